@@ -0,0 +1,38 @@
+//
+//  bench.h
+//
+//  Minimal benchmark harness for the Chassis library hot paths. Every benchmark
+//  is a plain function that is timed over a number of iterations, results are
+//  printed as one line per benchmark:
+//
+//      BENCH <name> <microseconds per call> us <cycles per call> cycles <peak stack> stack
+//
+//  On the ATmega2560 the cycles are counted exactly with Timer1 running at the CPU
+//  clock, the cost of the call loop itself is subtracted. The peak stack is the
+//  deepest stack use in bytes from the end of RAM while the benchmark ran, found by
+//  painting the free RAM before the run and looking for the lowest overwritten byte.
+//
+//  benchIsr() reports the worst case duration of an external interrupt handler in
+//  the same format, memory use is reported at the end as:
+//
+//      MEM <name> <bytes>
+//
+//  bench/run_simavr.py runs the firmware under simavr and collects all of it into
+//  a JSON file.
+//
+
+#ifndef bench_h
+#define bench_h
+
+#include <Arduino.h>
+
+typedef void (*BenchFunction)(void);
+
+void benchRun(const char *name, BenchFunction function, unsigned int iterations);
+void benchIsr(const char *name, uint8_t pin, unsigned int repeats);
+unsigned long benchCycles();
+
+// keeps the optimiser from removing work whose result is otherwise unused
+extern volatile long benchSink;
+
+#endif /* bench_h */
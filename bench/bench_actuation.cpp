@@ -0,0 +1,65 @@
+//
+//  bench_actuation.cpp
+//
+//  Cost per call of moveWheels / switchLightsOn with the port register layer,
+//  against the analogWrite / digitalWrite loop it replaced.
+//
+
+#include "bench.h"
+#include <Chassis.h>
+
+static Chassis benchChassis;
+
+static int wheelPins[NUM_WHEELS][NUM_WHEEL_PINS] = {{4, 31, 32}, {5, 24, 30}, {6, 38, 39}, {7, 27, 28}};
+static int lightPins[NUM_LIGHT_PINS] = {42, 43, 44, 45};
+
+static int forward[NUM_WHEELS] = {190, 190, 190, 190};
+static int rotate[NUM_WHEELS]  = {-190, 190, -190, 190};
+static bool lightsOn[NUM_LIGHT_PINS]  = {true, true, false, false};
+static bool lightsOff[NUM_LIGHT_PINS] = {false, false, false, false};
+static bool toggle = false;
+
+//
+// the original moveWheels / switchLightsOn pin handling
+//
+static void legacyMoveWheels(int movements[NUM_WHEELS])
+{
+  for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+  {
+    int wheelSpeed = abs(movements[wheel]);
+    if (wheelSpeed > MAX_WHEEL_SPEED) {wheelSpeed = MAX_WHEEL_SPEED;}
+
+    analogWrite(wheelPins[wheel][0], wheelSpeed);
+    digitalWrite(wheelPins[wheel][1], (movements[wheel] > 0) && HIGH);
+    digitalWrite(wheelPins[wheel][2], (movements[wheel] < 0) && HIGH);
+  }
+}
+
+static void legacySwitchLights(bool lights[NUM_LIGHT_PINS])
+{
+  for (int light=0; light < NUM_LIGHT_PINS; light++)
+    digitalWrite(lightPins[light], lights[light] && HIGH);
+}
+
+static void benchLegacySame()     { legacyMoveWheels(forward); }
+static void benchLegacyChanging() { toggle = !toggle; legacyMoveWheels(toggle ? forward : rotate); }
+static void benchLegacyLights()   { toggle = !toggle; legacySwitchLights(toggle ? lightsOn : lightsOff); }
+static void benchPortsSame()      { benchChassis.moveWheels(forward); }
+static void benchPortsChanging()  { toggle = !toggle; benchChassis.moveWheels(toggle ? forward : rotate); }
+static void benchPortsLights()    { toggle = !toggle; benchChassis.switchLightsOn(toggle ? lightsOn : lightsOff); }
+
+void bench_actuation()
+{
+  benchChassis.initialiseWheels(wheelPins);
+  benchChassis.initialiseLights(lightPins);
+  benchChassis.setLightsOverride(true);
+
+  benchRun("moveWheels_legacy_same", benchLegacySame, 100);
+  benchRun("moveWheels_legacy_changing", benchLegacyChanging, 100);
+  benchRun("switchLights_legacy", benchLegacyLights, 100);
+  benchRun("moveWheels_ports_same", benchPortsSame, 100);
+  benchRun("moveWheels_ports_changing", benchPortsChanging, 100);
+  benchRun("switchLights_ports", benchPortsLights, 100);
+
+  benchChassis.doFullStop();
+}
@@ -0,0 +1,142 @@
+//
+//  bench_chassis.cpp
+//
+//  Cost of the Chassis hot paths: loading the configuration, compiling and running
+//  a <MOVEMENT> block, output framing for Wire, the pulse bookkeeping and the pulse
+//  interrupt handlers.
+//
+//  The configuration and the command file are read from memory through the Stream
+//  entry points, so the numbers hold the parsing and the Chassis work but not the SD
+//  card reads. With a card in, the bench firmware on a board also times the whole
+//  initialiseFromFile(); simavr has no card.
+//
+
+#include "bench.h"
+#include <Chassis.h>
+#include <Wire.h>
+
+//
+// read only Stream over text in SRAM
+//
+class BenchTextStream : public Stream
+{
+  public:
+    BenchTextStream(const char *streamText) : text(streamText), position(0) {}
+
+    int available() { return strlen(text + position); }
+    int read()      { return text[position] ? (uint8_t) text[position++] : -1; }
+    int peek()      { return text[position] ? (uint8_t) text[position] : -1; }
+    size_t write(uint8_t) { return 0; }
+
+  private:
+    const char *text;
+    size_t      position;
+};
+
+static Chassis benchChassis;
+
+static const char confText[] =
+  "LIGHTS = OFF;\r\n"
+  "LIGHTS_OVERRIDE = OFF;\r\n"
+  "LIGHT_PINS = {42, 43, 44, 45};\r\n"
+  "WHEEL_PINS = {{4,31,32}, {5,24,30}, {6,38,39}, {7,27,28}};\r\n"
+  "CYCLE = 1;\r\n"
+  "MOVEMENTS = commands/GUIDE.TXT;\r\n";
+
+static const char blockText[] =
+  "<MOVEMENT>\r\n"
+  " LIGHTS = (OFF, ON, ON, OFF)\r\n"
+  " WHEELS = (-255, -255, -255, -255)\r\n"
+  " DURATION  = 0\r\n"
+  "</MOVEMENT>\r\n";
+
+static const char shortMessage[] = "Chassis::update ERROR";
+static const char longMessage[]  = "Chassis::compileCommandFile ERROR line 12 invalid arguments for WHEELS";
+
+static void benchConfig()
+{
+  BenchTextStream source(confText);
+  benchSink += benchChassis.initialiseFromStream(source);
+}
+
+static void benchConfigFile()
+{
+  benchSink += benchChassis.initialiseFromFile("CONF.TXT");
+}
+
+static void benchBlockCompile()
+{
+  BenchTextStream source(blockText);
+  benchSink += benchChassis.compileCommandStream(source);
+}
+
+//
+// every instruction of the block, the DURATION of 0 ends on the next update()
+//
+static void benchBlockRun()
+{
+  benchChassis.startProgram();
+  while (benchChassis.isBusy())
+    benchChassis.update();
+}
+
+static void benchOutputQueued() { benchChassis.writeToOutput(shortMessage); }
+static void benchOutputShort()  { benchChassis.writeToOutput(shortMessage); benchChassis.flushWire(); }
+static void benchOutputLong()   { benchChassis.writeToOutput(longMessage); benchChassis.flushWire(); }
+
+static void benchPulseCalculation()
+{
+  for (int i = 0; i < 7; i++)
+  {
+    pulseCounter<0>();
+    pulseCounter<1>();
+    pulseCounter<2>();
+    pulseCounter<3>();
+  }
+  doPulseCalculation();
+}
+
+void bench_chassis()
+{
+  benchChassis.setManualMode(false);
+
+  benchRun("config_stream", benchConfig, 20);
+#if !defined(BENCH_SIMAVR)
+  if (SD.begin()) benchRun("config_file", benchConfigFile, 5);
+#else
+  (void) benchConfigFile;
+#endif
+
+  benchRun("block_compile", benchBlockCompile, 20);
+  benchRun("block_run", benchBlockRun, 20);
+
+  //
+  // Wire only, no receiver is attached so every frame ends in a NACK. The queued run is the cost of
+  // writeToOutput() itself, the others include sending all frames
+  //
+  Wire.begin();
+#if defined(WIRE_HAS_TIMEOUT)
+  Wire.setWireTimeout(1000, true);
+#endif
+  benchChassis.setSerial(false);
+  benchChassis.setWire(true);
+  benchRun("writeToOutput_wire_queued", benchOutputQueued, 5);   // all six fit in the queue
+  benchChassis.flushWire();
+  benchRun("writeToOutput_wire_short", benchOutputShort, 20);
+  benchRun("writeToOutput_wire_long", benchOutputLong, 20);
+  benchChassis.setWire(false);
+  benchChassis.setSerial(true);
+
+  benchRun("doPulseCalculation", benchPulseCalculation, 100);
+
+  initialisePulseCounters();
+  for (int wheel = 0; wheel < NUM_WHEELS; wheel++)
+  {
+    static const char *names[NUM_WHEELS] = {"isr_pulse_flw", "isr_pulse_frw", "isr_pulse_rlw", "isr_pulse_rrw"};
+    benchIsr(names[wheel], pulseCounters[wheel], 50);
+  }
+  for (int wheel = 0; wheel < NUM_WHEELS; wheel++)
+    detachInterrupt(digitalPinToInterrupt(pulseCounters[wheel]));
+
+  benchChassis.doFullStop();
+}
@@ -0,0 +1,251 @@
+//
+//  bench_main.cpp
+//
+//  Benchmark firmware, build and upload with: platformio run -e bench -t upload
+//  or run it without a board under simavr with: python3 bench/run_simavr.py
+//
+
+#include "bench.h"
+
+#if defined(__AVR__)
+#  include <avr/sleep.h>
+#  include <util/atomic.h>
+
+#  define BENCH_STACK_PAINT       0xC5      // pattern of unused stack
+#  define BENCH_HEAP_MARGIN       128       // left unpainted above the heap for allocations during a benchmark
+
+extern char  __heap_start;
+extern char *__brkval;
+#endif
+
+volatile long benchSink = 0;
+
+static unsigned long loopOverhead = 0;      // cycles of the benchmark loop around an empty function
+static unsigned int  stackPeak    = 0;
+
+// forward declarations for benchmarks
+void bench_tokenizer();
+void bench_actuation();
+void bench_chassis();
+void bench_reader();
+
+#if defined(__AVR__)
+static volatile uint16_t cycleOverflows = 0;
+
+ISR(TIMER1_OVF_vect)
+{
+  cycleOverflows++;
+}
+
+//
+// Timer1 counts every CPU cycle, the overflows extend it to 32 bits
+//
+static void startCycleCounter()
+{
+  TCCR1A = 0;
+  TCCR1B = _BV(CS10);
+  TCNT1  = 0;
+  TIFR1  = _BV(TOV1);
+  TIMSK1 = _BV(TOIE1);
+}
+
+unsigned long benchCycles()
+{
+  uint16_t low;
+  uint16_t high;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    low  = TCNT1;
+    high = cycleOverflows;
+
+    // an overflow that happened after interrupts were disabled is still pending
+    if ((TIFR1 & _BV(TOV1)) && (low < 0x8000)) high++;
+  }
+
+  return ((unsigned long) high << 16) | low;
+}
+
+static uint8_t *stackFloor()
+{
+  return (uint8_t *) ((__brkval ? __brkval : &__heap_start) + BENCH_HEAP_MARGIN);
+}
+
+//
+// fill the free RAM between the heap and the stack pointer with the paint pattern
+//
+static void paintStack()
+{
+  uint8_t *top = (uint8_t *) SP;
+
+  for (uint8_t *p = stackFloor(); p < top; p++)
+    *p = BENCH_STACK_PAINT;
+}
+
+//
+// deepest stack use since paintStack() in bytes from the end of RAM
+//
+static unsigned int stackDepth()
+{
+  uint8_t *p = stackFloor();
+
+  while ((p <= (uint8_t *) RAMEND) && (*p == BENCH_STACK_PAINT))
+    p++;
+
+  unsigned int depth = (uint8_t *) RAMEND + 1 - p;
+  if (depth > stackPeak) stackPeak = depth;
+
+  return depth;
+}
+#else
+static void startCycleCounter() {}
+
+unsigned long benchCycles()
+{
+  return micros() * (F_CPU / 1000000UL);
+}
+
+static void paintStack() {}
+static unsigned int stackDepth() { return 0; }
+#endif
+
+static void benchEmpty() {}
+
+static void benchPrint(const char *name, unsigned long cycles, unsigned int stack)
+{
+  Serial.print("BENCH ");
+  Serial.print(name);
+  Serial.print(" ");
+  Serial.print((float) cycles / (F_CPU / 1000000UL));
+  Serial.print(" us ");
+  Serial.print(cycles);
+  Serial.print(" cycles ");
+  Serial.print(stack);
+  Serial.println(" stack");
+}
+
+static unsigned long timeLoop(BenchFunction function, unsigned int iterations)
+{
+  unsigned long start = benchCycles();
+  for (unsigned int i = 0; i < iterations; i++)
+    function();
+
+  return benchCycles() - start;
+}
+
+void benchRun(const char *name, BenchFunction function, unsigned int iterations)
+{
+  function();  // warm up
+
+  Serial.flush();   // no UART interrupts while timing
+  paintStack();
+
+  unsigned long elapsed = timeLoop(function, iterations);
+  unsigned int  stack   = stackDepth();
+
+  elapsed = (elapsed > loopOverhead * iterations) ? elapsed - loopOverhead * iterations : 0;
+
+  benchPrint(name, (elapsed + iterations / 2) / iterations, stack);
+}
+
+#if defined(__AVR__)
+//
+// cycles from just before a rising edge on the pin to just after it, the pin is driven as
+// an output, the external interrupt logic sees the edge all the same
+//
+static unsigned long edgeCycles(volatile uint8_t *out, uint8_t mask, bool interrupts)
+{
+  unsigned long start;
+  unsigned long end;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    if (interrupts) sei();
+
+    start = benchCycles();
+    *out |= mask;
+    __asm__ __volatile__ ("nop\n\tnop\n\tnop\n\tnop\n\t");   // the handler runs in here
+    end = benchCycles();
+  }
+
+  *out &= ~mask;
+
+  return end - start;
+}
+#endif
+
+//
+// worst case duration of the handler attached to an external interrupt pin, including the
+// vector entry, the attachInterrupt() dispatch and the return
+//
+void benchIsr(const char *name, uint8_t pin, unsigned int repeats)
+{
+#if defined(__AVR__)
+  volatile uint8_t *out = portOutputRegister(digitalPinToPort(pin));
+  uint8_t mask  = digitalPinToBitMask(pin);
+  uint8_t timer = TIMSK0;
+  unsigned long worst = 0;
+
+  *out &= ~mask;
+  pinMode(pin, OUTPUT);
+
+  Serial.flush();
+  TIMSK0 = 0;       // no millis() tick during the measurement
+  paintStack();
+
+  unsigned long baseline = edgeCycles(out, mask, false);   // the pending interrupt runs after the measurement
+
+  for (unsigned int i = 0; i < repeats; i++)
+  {
+    unsigned long cycles = edgeCycles(out, mask, true);
+
+    if ((cycles > baseline) && ((cycles - baseline) > worst)) worst = cycles - baseline;
+  }
+
+  unsigned int stack = stackDepth();
+
+  TIMSK0 = timer;
+  pinMode(pin, INPUT);
+
+  benchPrint(name, worst, stack);
+#else
+  (void) pin;
+  (void) repeats;
+  benchPrint(name, 0, 0);
+#endif
+}
+
+static void benchMemory()
+{
+#if defined(__AVR__)
+  Serial.print("MEM sram_static ");
+  Serial.println((unsigned int) &__heap_start - RAMSTART);
+#endif
+  Serial.print("MEM stack_peak ");
+  Serial.println(stackPeak);
+}
+
+void setup() {
+  Serial.begin(115200);
+  startCycleCounter();
+
+  loopOverhead = (timeLoop(benchEmpty, 100) + 50) / 100;
+
+  bench_tokenizer();
+  bench_actuation();
+  bench_chassis();
+  bench_reader();
+
+  benchMemory();
+  Serial.println("BENCH DONE");
+
+#if defined(BENCH_SIMAVR) && defined(__AVR__)
+  // simavr stops when the cpu sleeps with interrupts off
+  Serial.flush();
+  cli();
+  sleep_enable();
+  sleep_cpu();
+#endif
+}
+
+void loop() {}
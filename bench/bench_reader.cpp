@@ -0,0 +1,187 @@
+//
+//  bench_reader.cpp
+//
+//  Read speed of a command file through the block buffered ChassisReader, against
+//  the byte at a time statement reads it replaced, and the time until the first
+//  command of the file is parsed.
+//
+//  Besides the usual BENCH line every read benchmark reports its input size as
+//
+//      BYTES <name> <bytes per call>
+//
+//  from which run_simavr.py derives bytes/s. simavr has no card, the file is a
+//  Stream over a line in memory repeated; with a card in, the bench firmware on a
+//  board also reads commands/GUIDE.TXT both ways.
+//
+
+#include "bench.h"
+#include <ChassisReader.h>
+
+#define BENCH_READER_LINES        24
+
+static const char commandLine[] = " WHEELS = (-255, -255, -255, -255)\r\n";
+
+//
+// read only Stream of a line repeated BENCH_READER_LINES times behind a <MOVEMENT>
+//
+class BenchRepeatStream : public Stream
+{
+  public:
+    BenchRepeatStream() : line(0), position(0) {}
+
+    int available() { return (line <= BENCH_READER_LINES) ? 1 : 0; }
+    int read()
+    {
+      int c = peek();
+
+      if (c >= 0)
+      {
+        position++;
+        if (current()[position] == '\0') { line++; position = 0; }
+      }
+      return c;
+    }
+    int peek()      { return (line <= BENCH_READER_LINES) ? (uint8_t) current()[position] : -1; }
+    size_t write(uint8_t) { return 0; }
+
+  private:
+    uint8_t line;
+    uint8_t position;
+
+    const char *current() { return (line == 0) ? "<MOVEMENT>\r\n" : commandLine; }
+};
+
+//
+// the statement read before ChassisReader: byte by byte through the Stream into a copy
+//
+static int readStatementBytewise(Stream &source, char *buffer, int size, char terminator)
+{
+  int length = 0;
+  int c;
+
+  while ((c = source.read()) >= 0)
+  {
+    if (c == terminator) break;
+    if (length < (size - 1)) buffer[length++] = c;
+  }
+  buffer[length] = '\0';
+
+  return length;
+}
+
+static void readAllBytewise(Stream &source)
+{
+  char statementText[MAX_STATEMENT_LENGTH];
+
+  while (source.available())
+    benchSink += readStatementBytewise(source, statementText, sizeof(statementText), '\n');
+}
+
+static void readAllReader(ChassisReader &reader)
+{
+  ChassisText statement;
+  bool        truncated;
+
+  while (reader.next('\n', statement, truncated))
+    benchSink += statement.length;
+}
+
+//
+// up to the first command, i.e. the statement behind <MOVEMENT>, tokenized
+//
+static void firstCommand(const char *text, size_t length)
+{
+  ChassisTokenizer tokenizer(text, length, '\n');
+  ChassisStatement statement;
+
+  benchSink += tokenizer.next(statement);
+}
+
+static void benchBytewise()
+{
+  BenchRepeatStream source;
+  readAllBytewise(source);
+}
+
+static void benchReader()
+{
+  BenchRepeatStream source;
+  ChassisReader     reader(source);
+  readAllReader(reader);
+}
+
+static void benchFirstBytewise()
+{
+  BenchRepeatStream source;
+  char              statementText[MAX_STATEMENT_LENGTH];
+  int               length;
+
+  readStatementBytewise(source, statementText, sizeof(statementText), '\n');
+  length = readStatementBytewise(source, statementText, sizeof(statementText), '\n');
+  firstCommand(statementText, length);
+}
+
+static void benchFirstReader()
+{
+  BenchRepeatStream source;
+  ChassisReader     reader(source);
+  ChassisText       statement;
+  bool              truncated;
+
+  reader.next('\n', statement, truncated);
+  reader.next('\n', statement, truncated);
+  firstCommand(statement.text, statement.length);
+}
+
+#if !defined(BENCH_SIMAVR)
+static void benchFileBytewise()
+{
+  File file = SD.open("commands/GUIDE.TXT");
+  readAllBytewise(file);
+  file.close();
+}
+
+static void benchFileReader()
+{
+  File          file = SD.open("commands/GUIDE.TXT");
+  ChassisReader reader(file);
+  readAllReader(reader);
+  file.close();
+}
+#endif
+
+static void benchBytes(const char *name, unsigned long bytes)
+{
+  Serial.print("BYTES ");
+  Serial.print(name);
+  Serial.print(' ');
+  Serial.println(bytes);
+}
+
+void bench_reader()
+{
+  unsigned long bytes = sizeof("<MOVEMENT>\r\n") - 1 + BENCH_READER_LINES * (sizeof(commandLine) - 1);
+
+  benchRun("read_stream_bytewise", benchBytewise, 10);
+  benchBytes("read_stream_bytewise", bytes);
+  benchRun("read_stream_reader", benchReader, 10);
+  benchBytes("read_stream_reader", bytes);
+
+  benchRun("first_command_bytewise", benchFirstBytewise, 20);
+  benchRun("first_command_reader", benchFirstReader, 20);
+
+#if !defined(BENCH_SIMAVR)
+  File file = SD.begin() ? SD.open("commands/GUIDE.TXT") : File();
+
+  if (file)
+  {
+    bytes = file.size();
+    file.close();
+
+    benchRun("read_file_bytewise", benchFileBytewise, 5);
+    benchBytes("read_file_bytewise", bytes);
+    benchRun("read_file_reader", benchFileReader, 5);
+    benchBytes("read_file_reader", bytes);
+  }
+#endif
+}
@@ -0,0 +1,92 @@
+//
+//  bench_tokenizer.cpp
+//
+//  Parse time of CONF.TXT and a movement block with the zero allocation
+//  tokenizer, against the String based parsing it replaced.
+//
+
+#include "bench.h"
+#include <ChassisTokenizer.h>
+
+static const char confText[] =
+  "LIGHTS = OFF;\r\n"
+  "LIGHTS_OVERRIDE = OFF;\r\n"
+  "LIGHT_PINS = {42, 43, 44, 45};\r\n"
+  "WHEEL_PINS = {{4,31,32}, {5,24,30}, {6,38,39}, {7,27,28}};\r\n"
+  "BLE_PINS = {10, 11, 9};\r\n"
+  "CYCLE = 1000;\r\n"
+  "MOVEMENTS = commands/GUIDE.TXT;\r\n";
+
+static const char blockText[] =
+  "<MOVEMENT>\r\n"
+  " LIGHTS = (OFF, ON, ON, OFF)\r\n"
+  " WHEELS = (-255, -255, -255, -255)\r\n"
+  " DURATION  = 2000\r\n"
+  "</MOVEMENT>\r\n";
+
+static void parseWithTokenizer(const char *text, size_t length, char terminator)
+{
+  ChassisTokenizer tokenizer(text, length, terminator);
+  ChassisStatement statement;
+  long value;
+
+  while (tokenizer.next(statement) != PARSE_END)
+    for (uint8_t i = 0; i < statement.numItems; i++)
+      if (chassisTextToInt(statement.items[i], value)) benchSink += value;
+}
+
+//
+// the String handling of the original initialiseFromFile / setConfValues
+//
+static void parseWithStrings(const char *text, char terminator)
+{
+  String source = text;
+  int start = 0;
+
+  while (start < (int) source.length())
+  {
+    int end = source.indexOf(terminator, start);
+    if (end < 0) end = source.length();
+
+    String lineItem = source.substring(start, end);
+    lineItem.trim();
+    lineItem.replace(" ", "");
+    start = end + 1;
+
+    int pos = lineItem.indexOf("=");
+    if (pos <= 0) continue;
+
+    String key   = lineItem.substring(0, pos);
+    String value = lineItem.substring(pos+1);
+
+    if ((value[0] == '{') || (value[0] == '('))
+    {
+      value = value.substring(1, value.length()-1);
+
+      unsigned int posStart = 0;
+      while (posStart < value.length())
+      {
+        int posEnd = value.indexOf(",", posStart);
+        if (posEnd < 0) posEnd = value.length();
+
+        benchSink += value.substring(posStart, posEnd).toInt();
+        posStart = posEnd + 1;
+      }
+    }
+    else
+      benchSink += value.toInt();
+  }
+}
+
+static void benchConfTokenizer()  { parseWithTokenizer(confText, sizeof(confText) - 1, ';'); }
+static void benchConfStrings()    { parseWithStrings(confText, ';'); }
+static void benchBlockTokenizer() { parseWithTokenizer(blockText, sizeof(blockText) - 1, '\n'); }
+static void benchBlockStrings()   { parseWithStrings(blockText, '\n'); }
+
+void bench_tokenizer()
+{
+  benchRun("conf_tokenizer", benchConfTokenizer, 100);
+  benchRun("conf_strings", benchConfStrings, 100);
+  benchRun("block_tokenizer", benchBlockTokenizer, 100);
+  benchRun("block_strings", benchBlockStrings, 100);
+}
@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+#
+#  run_simavr.py
+#
+#  Builds the benchmark firmware for simavr, runs it and writes the results as JSON:
+#
+#      python3 bench/run_simavr.py [--output bench_results.json] [--baseline old.json]
+#
+#  With --baseline every benchmark that got slower by more than --threshold percent,
+#  and any growth in flash or SRAM use, is listed and the script exits with 1.
+#
+#  Needs PlatformIO (pio) and simavr (run_avr or simavr) on the PATH, avr-size is
+#  taken from the PlatformIO toolchain when it is not on the PATH.
+#
+
+import argparse
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+ENV = "bench_sim"
+MCU = "atmega2560"
+F_CPU = 16000000
+
+BENCH_LINE = re.compile(r"BENCH (\S+) ([\d.]+) us (\d+) cycles (\d+) stack")
+MEM_LINE = re.compile(r"MEM (\S+) (\d+)")
+BYTES_LINE = re.compile(r"BYTES (\S+) (\d+)")
+ANSI = re.compile(r"\x1b\[[0-9;]*m")
+
+
+def find_tool(names, fallback_dirs=()):
+    for name in names:
+        path = shutil.which(name)
+        if path:
+            return path
+        for directory in fallback_dirs:
+            candidate = os.path.join(directory, name)
+            if os.path.exists(candidate):
+                return candidate
+    return None
+
+
+def build(project):
+    subprocess.run(["pio", "run", "-e", ENV, "-d", project], check=True)
+    return os.path.join(project, ".pio", "build", ENV, "firmware.elf")
+
+
+def simulate(elf, timeout):
+    simavr = find_tool(["simavr", "run_avr"])
+    if simavr is None:
+        sys.exit("simavr not found")
+
+    result = subprocess.run([simavr, "-m", MCU, "-f", str(F_CPU), elf],
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                            universal_newlines=True, timeout=timeout)
+    return ANSI.sub("", result.stdout)
+
+
+def sizes(elf):
+    toolchain = os.path.expanduser("~/.platformio/packages/toolchain-atmelavr/bin")
+    avr_size = find_tool(["avr-size"], [toolchain])
+    if avr_size is None:
+        return {}
+
+    output = subprocess.run([avr_size, "-A", elf], stdout=subprocess.PIPE,
+                            universal_newlines=True, check=True).stdout
+    sections = {}
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0].startswith(".") and fields[1].isdigit():
+            sections[fields[0]] = int(fields[1])
+
+    return {
+        "flash": sections.get(".text", 0) + sections.get(".data", 0),
+        "sram_static": sections.get(".data", 0) + sections.get(".bss", 0) + sections.get(".noinit", 0),
+    }
+
+
+def parse(output):
+    benchmarks = {}
+    memory = {}
+    for line in output.splitlines():
+        match = BENCH_LINE.search(line)
+        if match:
+            benchmarks[match.group(1)] = {
+                "us": float(match.group(2)),
+                "cycles": int(match.group(3)),
+                "stack": int(match.group(4)),
+            }
+            continue
+        match = BYTES_LINE.search(line)
+        if match and match.group(1) in benchmarks:
+            entry = benchmarks[match.group(1)]
+            entry["bytes"] = int(match.group(2))
+            if entry["us"] > 0:
+                entry["bytes_per_s"] = round(entry["bytes"] * 1e6 / entry["us"])
+            continue
+        match = MEM_LINE.search(line)
+        if match:
+            memory[match.group(1)] = int(match.group(2))
+
+    if "BENCH DONE" not in output:
+        sys.exit("benchmark firmware did not finish:\n" + output)
+
+    return benchmarks, memory
+
+
+def compare(results, baseline, threshold):
+    regressions = []
+
+    for name, current in results["benchmarks"].items():
+        previous = baseline.get("benchmarks", {}).get(name)
+        if previous and previous["cycles"] > 0:
+            change = 100.0 * (current["cycles"] - previous["cycles"]) / previous["cycles"]
+            if change > threshold:
+                regressions.append("%s: %d -> %d cycles (+%.1f%%)" % (name, previous["cycles"], current["cycles"], change))
+
+    for name, current in results["memory"].items():
+        previous = baseline.get("memory", {}).get(name)
+        if previous is not None and current > previous:
+            regressions.append("%s: %d -> %d bytes" % (name, previous, current))
+
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Chassis benchmarks under simavr")
+    parser.add_argument("--project", default=os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+    parser.add_argument("--elf", help="use this firmware instead of building it")
+    parser.add_argument("--output", default="bench_results.json")
+    parser.add_argument("--baseline", help="results of an earlier run to compare with")
+    parser.add_argument("--threshold", type=float, default=2.0, help="allowed slow down in percent")
+    parser.add_argument("--timeout", type=int, default=600)
+    args = parser.parse_args()
+
+    elf = args.elf or build(args.project)
+    benchmarks, memory = parse(simulate(elf, args.timeout))
+    memory.update(sizes(elf))
+
+    results = {"mcu": MCU, "f_cpu": F_CPU, "benchmarks": benchmarks, "memory": memory}
+
+    with open(args.output, "w") as output:
+        json.dump(results, output, indent=2, sort_keys=True)
+        output.write("\n")
+
+    for name in sorted(benchmarks):
+        rate = benchmarks[name].get("bytes_per_s")
+        print("%-32s %10d cycles %6d stack%s" % (name, benchmarks[name]["cycles"], benchmarks[name]["stack"],
+                                                 " %8d bytes/s" % rate if rate else ""))
+    for name in sorted(memory):
+        print("%-32s %10d bytes" % (name, memory[name]))
+
+    if args.baseline:
+        with open(args.baseline) as previous:
+            regressions = compare(results, json.load(previous), args.threshold)
+        for regression in regressions:
+            print("REGRESSION " + regression)
+        if regressions:
+            return 1
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,283 @@
+//
+//  Arduino.cpp
+//
+//  Host (native) stand-in for the Arduino core: fake port registers, a
+//  simulated clock and a software interrupt table.
+//
+
+#include "Arduino.h"
+
+#include <stdio.h>
+
+volatile uint8_t halSREG = 0x80;
+
+HardwareSerial Serial;
+
+static volatile uint8_t halPorts[NUM_HAL_PORTS];
+static volatile uint8_t halDdr[NUM_HAL_PORTS];
+static volatile uint8_t halPin[NUM_HAL_PORTS];
+static int              halAnalog[NUM_DIGITAL_PINS];
+static unsigned long    halClockMicros = 0;
+static unsigned long    halWrites = 0;
+static void           (*halDelayHook)(unsigned long us) = NULL;
+
+#define HAL_NUM_INTERRUPTS 6
+static void (*halInterrupts[HAL_NUM_INTERRUPTS])(void);
+
+// same external interrupt layout as the ATmega2560 core
+static const int halPinInterrupts[][2] = {
+    {2, 0}, {3, 1}, {21, 2}, {20, 3}, {19, 4}, {18, 5}
+};
+
+//
+// pin to port mapping of the Arduino Mega core, ports are numbered PA = 1 .. PL = 12 (no PI)
+//
+static const char halPinPorts[] = "EEEEGEHHHHBBBBJJHHDDDDAAAAAAAACCCCCCCCDGGGLLLLLLLLBBBBFFFFFFFFKKKKKKKK";
+static const char halPinBits[]  = "0145533456456710103210012345677654321072107654321032100123456701234567";
+
+uint8_t digitalPinToPort(uint8_t pin)
+{
+    return (pin < NUM_DIGITAL_PINS) ? (uint8_t) (halPinPorts[pin] - 'A' + 1) : NOT_A_PORT;
+}
+
+uint8_t digitalPinToBitMask(uint8_t pin)
+{
+    return (pin < NUM_DIGITAL_PINS) ? (uint8_t) (1 << (halPinBits[pin] - '0')) : 0;
+}
+
+uint8_t digitalPinToTimer(uint8_t pin)
+{
+    // PWM capable pins on the Mega: 2..13 and 44..46
+    return (((pin >= 2) && (pin <= 13)) || ((pin >= 44) && (pin <= 46))) ? 1 : NOT_ON_TIMER;
+}
+
+volatile uint8_t *portOutputRegister(uint8_t port) { return &halPorts[port]; }
+volatile uint8_t *portModeRegister(uint8_t port)   { return &halDdr[port]; }
+volatile uint8_t *portInputRegister(uint8_t port)  { return &halPin[port]; }
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    uint8_t port = digitalPinToPort(pin);
+    if (port == NOT_A_PORT) return;
+
+    if (mode == OUTPUT)
+        halDdr[port] |= digitalPinToBitMask(pin);
+    else
+        halDdr[port] &= (uint8_t) ~digitalPinToBitMask(pin);
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    uint8_t port = digitalPinToPort(pin);
+    if (port == NOT_A_PORT) return;
+
+    // like turnOffPWM() of the avr core
+    if (digitalPinToTimer(pin) != NOT_ON_TIMER) halAnalog[pin] = 0;
+
+    if (val == LOW)
+        halPorts[port] &= (uint8_t) ~digitalPinToBitMask(pin);
+    else
+        halPorts[port] |= digitalPinToBitMask(pin);
+
+    halWrites++;
+}
+
+int digitalRead(uint8_t pin)
+{
+    uint8_t port = digitalPinToPort(pin);
+    if (port == NOT_A_PORT) return LOW;
+
+    return ((halPorts[port] | halPin[port]) & digitalPinToBitMask(pin)) ? HIGH : LOW;
+}
+
+void analogWrite(uint8_t pin, int val)
+{
+    if (pin >= NUM_DIGITAL_PINS) return;
+
+    halAnalog[pin] = val;
+    halWrites++;
+}
+
+int analogRead(uint8_t pin)
+{
+    (void) pin;
+    return 0;
+}
+
+unsigned long micros(void)
+{
+    return halClockMicros;
+}
+
+unsigned long millis(void)
+{
+    return halClockMicros / 1000UL;
+}
+
+void delay(unsigned long ms)
+{
+    halAdvanceMicros(ms * 1000UL);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    halAdvanceMicros(us);
+}
+
+int digitalPinToInterrupt(uint8_t pin)
+{
+    for (unsigned int i = 0; i < sizeof(halPinInterrupts) / sizeof(halPinInterrupts[0]); i++)
+        if (halPinInterrupts[i][0] == pin) return halPinInterrupts[i][1];
+
+    return NOT_AN_INTERRUPT;
+}
+
+void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode)
+{
+    (void) mode;
+    if (interruptNum < HAL_NUM_INTERRUPTS) halInterrupts[interruptNum] = userFunc;
+}
+
+void detachInterrupt(uint8_t interruptNum)
+{
+    if (interruptNum < HAL_NUM_INTERRUPTS) halInterrupts[interruptNum] = NULL;
+}
+
+void noInterrupts(void) { halSREG &= (uint8_t) ~0x80; }
+void interrupts(void)   { halSREG |= 0x80; }
+void cli(void)          { noInterrupts(); }
+void sei(void)          { interrupts(); }
+
+//
+// host helpers
+//
+void halReset(void)
+{
+    for (int i = 0; i < NUM_HAL_PORTS; i++)
+    {
+        halPorts[i] = 0;
+        halDdr[i]   = 0;
+        halPin[i]   = 0;
+    }
+    for (int i = 0; i < NUM_DIGITAL_PINS; i++)
+        halAnalog[i] = 0;
+    for (int i = 0; i < HAL_NUM_INTERRUPTS; i++)
+        halInterrupts[i] = NULL;
+
+    halClockMicros = 0;
+    halWrites      = 0;
+    halDelayHook   = NULL;
+    halSREG        = 0x80;
+    Serial.output  = "";
+    Serial.input   = "";
+}
+
+void halAdvanceMicros(unsigned long us)
+{
+    if (halDelayHook) halDelayHook(us);
+    halClockMicros += us;
+}
+
+void halSetDelayHook(void (*hook)(unsigned long us))
+{
+    halDelayHook = hook;
+}
+
+void halFireInterrupt(uint8_t interruptNum)
+{
+    if ((interruptNum < HAL_NUM_INTERRUPTS) && halInterrupts[interruptNum])
+        halInterrupts[interruptNum]();
+}
+
+int halPinMode(uint8_t pin)
+{
+    uint8_t port = digitalPinToPort(pin);
+    return (port != NOT_A_PORT) && (halDdr[port] & digitalPinToBitMask(pin)) ? OUTPUT : INPUT;
+}
+
+int halAnalogValue(uint8_t pin)
+{
+    return (pin < NUM_DIGITAL_PINS) ? halAnalog[pin] : 0;
+}
+
+unsigned long halPinWrites(void)
+{
+    return halWrites;
+}
+
+//
+// Print / Stream / Serial
+//
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+}
+
+size_t Print::print(long n, int base)
+{
+    return print(String(n, (unsigned char) base));
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+    return print(String(n, (unsigned char) base));
+}
+
+size_t Print::print(double n, int digits)
+{
+    return print(String(n, (unsigned char) digits));
+}
+
+size_t Stream::readBytes(char *buffer, size_t length)
+{
+    size_t count = 0;
+    while ((count < length) && (available() > 0))
+        buffer[count++] = (char) read();
+    return count;
+}
+
+String Stream::readString()
+{
+    String ret;
+    while (available() > 0) ret += (char) read();
+    return ret;
+}
+
+String Stream::readStringUntil(char terminator)
+{
+    String ret;
+    while (available() > 0)
+    {
+        int c = read();
+        if (c == terminator) break;
+        ret += (char) c;
+    }
+    return ret;
+}
+
+int HardwareSerial::available()
+{
+    return (int) input.length();
+}
+
+int HardwareSerial::read()
+{
+    if (input.length() == 0) return -1;
+    int c = (unsigned char) input[0];
+    input = input.substring(1);
+    return c;
+}
+
+int HardwareSerial::peek()
+{
+    return input.length() ? (unsigned char) input[0] : -1;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    output += (char) c;
+    if (echo) putchar(c);
+    return 1;
+}
@@ -0,0 +1,128 @@
+//
+//  Arduino.h
+//
+//  Host (native) stand-in for the Arduino core. Only the parts used by the
+//  Chassis library are provided. Pin state lives in fake port registers so
+//  both digitalWrite() and direct port access can be observed by tests.
+//
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include <avr/pgmspace.h>
+
+#define ARDUINO_NATIVE 1
+
+#ifndef F_CPU
+#define F_CPU 16000000L
+#endif
+
+#define HIGH    0x1
+#define LOW     0x0
+
+#define INPUT         0x0
+#define OUTPUT        0x1
+#define INPUT_PULLUP  0x2
+
+#define CHANGE   1
+#define FALLING  2
+#define RISING   3
+
+#define NOT_A_PIN        0
+#define NOT_A_PORT       0
+#define NOT_AN_INTERRUPT -1
+#define NOT_ON_TIMER     0
+
+#define NUM_DIGITAL_PINS  70
+#define NUM_HAL_PORTS     13        // PA = 1 .. PL = 12, 0 is NOT_A_PORT
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+#ifndef min
+#define min(a,b) ((a)<(b)?(a):(b))
+#endif
+#ifndef max
+#define max(a,b) ((a)>(b)?(a):(b))
+#endif
+#ifndef constrain
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+#endif
+
+// core I/O
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  digitalRead(uint8_t pin);
+void analogWrite(uint8_t pin, int val);
+int  analogRead(uint8_t pin);
+
+// time, driven by a simulated clock (see halAdvanceMicros)
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// interrupts
+void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode);
+void detachInterrupt(uint8_t interruptNum);
+int  digitalPinToInterrupt(uint8_t pin);
+void noInterrupts(void);
+void interrupts(void);
+void cli(void);
+void sei(void);
+
+// port level access, mimics the avr core macros
+uint8_t digitalPinToPort(uint8_t pin);
+uint8_t digitalPinToBitMask(uint8_t pin);
+uint8_t digitalPinToTimer(uint8_t pin);
+volatile uint8_t *portOutputRegister(uint8_t port);
+volatile uint8_t *portModeRegister(uint8_t port);
+volatile uint8_t *portInputRegister(uint8_t port);
+
+#define SREG halSREG
+extern volatile uint8_t halSREG;
+
+#define ISR(vector) void vector(void)
+
+//
+// host side helpers for tests, not part of the Arduino API
+//
+void halReset(void);
+void halAdvanceMicros(unsigned long us);
+void halSetDelayHook(void (*hook)(unsigned long us));
+void halFireInterrupt(uint8_t interruptNum);
+int  halPinMode(uint8_t pin);
+int  halAnalogValue(uint8_t pin);
+unsigned long halPinWrites(void);
+
+class HardwareSerial : public Stream
+{
+  public:
+    void begin(unsigned long baud) { (void) baud; }
+    void end() {}
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t c) override;
+    using Print::write;
+    int availableForWrite() override { return 63; }     // as the avr core, never full on the host
+    operator bool() { return true; }
+
+    // host helpers: captured output and injected input
+    String output;
+    String input;
+    bool   echo = false;
+};
+
+extern HardwareSerial Serial;
+
+#endif /* Arduino_h */
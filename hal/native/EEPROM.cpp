@@ -0,0 +1,54 @@
+//
+//  EEPROM.cpp
+//
+//  Host (native) stand-in for the Arduino EEPROM library.
+//
+
+#include "EEPROM.h"
+
+#include <string.h>
+
+EEPROMClass EEPROM;
+
+static uint8_t       halEEPROM[HAL_EEPROM_SIZE];
+static unsigned long halEEPROMWriteCount = 0;
+static bool          halEEPROMErased     = false;
+
+static void halEEPROMInit(void)
+{
+    if (!halEEPROMErased) halEEPROMErase();
+}
+
+uint8_t EEPROMClass::read(int address)
+{
+    halEEPROMInit();
+
+    return ((address >= 0) && (address < HAL_EEPROM_SIZE)) ? halEEPROM[address] : 0xFF;
+}
+
+void EEPROMClass::write(int address, uint8_t value)
+{
+    halEEPROMInit();
+
+    if ((address < 0) || (address >= HAL_EEPROM_SIZE)) return;
+
+    halEEPROM[address] = value;
+    halEEPROMWriteCount++;
+}
+
+void EEPROMClass::update(int address, uint8_t value)
+{
+    if (read(address) != value) write(address, value);
+}
+
+void halEEPROMErase(void)
+{
+    memset(halEEPROM, 0xFF, sizeof(halEEPROM));
+    halEEPROMWriteCount = 0;
+    halEEPROMErased     = true;
+}
+
+unsigned long halEEPROMWrites(void)
+{
+    return halEEPROMWriteCount;
+}
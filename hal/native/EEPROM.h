@@ -0,0 +1,31 @@
+//
+//  EEPROM.h
+//
+//  Host (native) stand-in for the Arduino EEPROM library. The contents live in
+//  memory and survive halReset(), like a real EEPROM survives a reboot, so tests
+//  can boot a second Chassis from what the first one stored.
+//
+
+#ifndef EEPROM_h
+#define EEPROM_h
+
+#include "Arduino.h"
+
+#define HAL_EEPROM_SIZE          4096      // ATmega2560
+
+class EEPROMClass
+{
+  public:
+    uint8_t read(int address);
+    void write(int address, uint8_t value);
+    void update(int address, uint8_t value);
+    uint16_t length() { return HAL_EEPROM_SIZE; }
+};
+
+extern EEPROMClass EEPROM;
+
+// host helpers
+void halEEPROMErase(void);                 // all cells 0xFF, as shipped
+unsigned long halEEPROMWrites(void);       // cells actually written since the last erase
+
+#endif /* EEPROM_h */
@@ -0,0 +1,192 @@
+//
+//  SD.cpp
+//
+//  Host (native) stand-in for the Arduino SD library, backed by a directory.
+//
+
+#include "SD.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <string>
+
+SDClass SD;
+
+static std::string   halSDRoot    = "sdcard";
+static bool          halSDPresent = true;
+static unsigned long halSDOpens   = 0;
+
+void halSetSDRoot(const char *path)
+{
+    halSDRoot = path;
+}
+
+void halSetSDPresent(bool present)
+{
+    halSDPresent = present;
+}
+
+unsigned long halSDOpenCount(void)
+{
+    return halSDOpens;
+}
+
+//
+// FAT is case insensitive, so resolve every path component ignoring case
+//
+static std::string resolvePath(const char *filepath, bool forCreate)
+{
+    std::string resolved = halSDRoot;
+    std::string path     = filepath;
+
+    size_t start = 0;
+    while (start <= path.size())
+    {
+        size_t end = path.find('/', start);
+        if (end == std::string::npos) end = path.size();
+
+        std::string part = path.substr(start, end - start);
+        start = end + 1;
+        if (part.empty()) continue;
+
+        std::string match;
+        DIR *dir = opendir(resolved.c_str());
+        if (dir)
+        {
+            struct dirent *entry;
+            while ((entry = readdir(dir)) != NULL)
+            {
+                if (strcasecmp(entry->d_name, part.c_str()) == 0)
+                {
+                    match = entry->d_name;
+                    break;
+                }
+            }
+            closedir(dir);
+        }
+
+        if (match.empty())
+        {
+            if (!forCreate) return std::string();
+            match = part;
+        }
+
+        resolved += "/" + match;
+    }
+
+    return resolved;
+}
+
+bool SDClass::begin(uint8_t csPin)
+{
+    (void) csPin;
+    return halSDPresent;
+}
+
+File SDClass::open(const char *filename, uint8_t mode)
+{
+    if (!halSDPresent) return File();
+
+    std::string path = resolvePath(filename, mode == FILE_WRITE);
+    if (path.empty()) return File();
+
+    FILE *handle = NULL;
+    if (mode == FILE_WRITE)
+    {
+        handle = fopen(path.c_str(), "r+b");
+        if (handle == NULL) handle = fopen(path.c_str(), "w+b");
+        if (handle) fseek(handle, 0, SEEK_END);
+    }
+    else
+        handle = fopen(path.c_str(), "rb");
+
+    if (handle) halSDOpens++;
+
+    return File(handle, filename);
+}
+
+bool SDClass::exists(const char *filepath)
+{
+    return halSDPresent && !resolvePath(filepath, false).empty();
+}
+
+bool SDClass::remove(const char *filepath)
+{
+    std::string path = resolvePath(filepath, false);
+    return halSDPresent && !path.empty() && (::remove(path.c_str()) == 0);
+}
+
+File::File(FILE *fileHandle, const char *name) : handle(fileHandle), fileName(name) {}
+
+size_t File::write(uint8_t c)
+{
+    return handle ? fwrite(&c, 1, 1, handle) : 0;
+}
+
+size_t File::write(const uint8_t *buf, size_t size)
+{
+    return handle ? fwrite(buf, 1, size, handle) : 0;
+}
+
+int File::available()
+{
+    if (!handle) return 0;
+
+    uint32_t remaining = size() - position();
+    return remaining > 0x7FFF ? 0x7FFF : (int) remaining;
+}
+
+int File::read()
+{
+    if (!handle) return -1;
+
+    int c = fgetc(handle);
+    return (c == EOF) ? -1 : c;
+}
+
+int File::read(void *buf, uint16_t nbyte)
+{
+    return handle ? (int) fread(buf, 1, nbyte, handle) : -1;
+}
+
+int File::peek()
+{
+    if (!handle) return -1;
+
+    int c = fgetc(handle);
+    if (c != EOF) ungetc(c, handle);
+    return (c == EOF) ? -1 : c;
+}
+
+void File::flush()
+{
+    if (handle) fflush(handle);
+}
+
+bool File::seek(uint32_t pos)
+{
+    return handle && (fseek(handle, (long) pos, SEEK_SET) == 0);
+}
+
+uint32_t File::position()
+{
+    return handle ? (uint32_t) ftell(handle) : 0;
+}
+
+uint32_t File::size()
+{
+    if (!handle) return 0;
+
+    long current = ftell(handle);
+    fseek(handle, 0, SEEK_END);
+    long end = ftell(handle);
+    fseek(handle, current, SEEK_SET);
+
+    return (uint32_t) end;
+}
+
+void File::close()
+{
+    if (handle) fclose(handle);
+    handle = NULL;
+}
@@ -0,0 +1,64 @@
+//
+//  SD.h
+//
+//  Host (native) stand-in for the Arduino SD library. Files are served from a
+//  local directory (default "sdcard", override with halSetSDRoot()) so tests
+//  can run against real CONF.TXT / GUIDE.TXT files.
+//
+
+#ifndef SD_h
+#define SD_h
+
+#include <stdio.h>
+#include "Arduino.h"
+
+#define FILE_READ   0x01
+#define FILE_WRITE  0x13
+
+class File : public Stream
+{
+  public:
+    File() {}
+    File(FILE *handle, const char *name);
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buf, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int read(void *buf, uint16_t nbyte);
+    int peek() override;
+    void flush() override;
+    bool seek(uint32_t pos);
+    uint32_t position();
+    uint32_t size();
+    void close();
+    const char *name() { return fileName.c_str(); }
+    operator bool() { return handle != NULL; }
+
+  private:
+    FILE  *handle = NULL;
+    String fileName;
+};
+
+class SDClass
+{
+  public:
+    bool begin(uint8_t csPin = 53);
+    void end() {}
+    File open(const char *filename, uint8_t mode = FILE_READ);
+    File open(const String &filename, uint8_t mode = FILE_READ) { return open(filename.c_str(), mode); }
+    bool exists(const char *filepath);
+    bool exists(const String &filepath) { return exists(filepath.c_str()); }
+    bool remove(const char *filepath);
+    bool remove(const String &filepath) { return remove(filepath.c_str()); }
+};
+
+extern SDClass SD;
+
+// host helpers
+void halSetSDRoot(const char *path);
+void halSetSDPresent(bool present);
+unsigned long halSDOpenCount(void);
+
+#endif /* SD_h */
@@ -0,0 +1,27 @@
+//
+//  Stream.h
+//
+//  Host (native) stand-in for the Arduino Stream class.
+//
+
+#ifndef Stream_h
+#define Stream_h
+
+#include "Print.h"
+
+class Stream : public Print
+{
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() {}
+
+    void setTimeout(unsigned long timeout) { (void) timeout; }
+    size_t readBytes(char *buffer, size_t length);
+    size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *) buffer, length); }
+    String readString();
+    String readStringUntil(char terminator);
+};
+
+#endif /* Stream_h */
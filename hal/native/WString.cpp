@@ -0,0 +1,137 @@
+//
+//  WString.cpp
+//
+//  Host (native) stand-in for the Arduino String class.
+//
+
+#include "WString.h"
+
+#include <stdio.h>
+#include <ctype.h>
+#include <stdlib.h>
+
+static std::string numberToString(unsigned long value, unsigned char base, bool negative)
+{
+    char digits[40];
+    int  pos = sizeof(digits) - 1;
+
+    if (base < 2) base = 10;
+    digits[pos] = '\0';
+    do
+    {
+        unsigned long digit = value % base;
+        digits[--pos] = (char) (digit < 10 ? '0' + digit : 'A' + digit - 10);
+        value /= base;
+    } while (value > 0);
+
+    if (negative) digits[--pos] = '-';
+
+    return std::string(&digits[pos]);
+}
+
+String::String(int value, unsigned char base) : String((long) value, base) {}
+String::String(unsigned int value, unsigned char base) : String((unsigned long) value, base) {}
+
+String::String(long value, unsigned char base)
+{
+    if ((base == 10) && (value < 0))
+        buffer = numberToString(0UL - (unsigned long) value, base, true);
+    else
+        buffer = numberToString((unsigned long) value, base, false);
+}
+
+String::String(unsigned long value, unsigned char base)
+{
+    buffer = numberToString(value, base, false);
+}
+
+String::String(float value, unsigned char decimalPlaces) : String((double) value, decimalPlaces) {}
+
+String::String(double value, unsigned char decimalPlaces)
+{
+    char text[64];
+    snprintf(text, sizeof(text), "%.*f", decimalPlaces, value);
+    buffer = text;
+}
+
+bool String::equalsIgnoreCase(const String &s) const
+{
+    if (buffer.size() != s.buffer.size()) return false;
+    for (size_t i = 0; i < buffer.size(); i++)
+        if (tolower((unsigned char) buffer[i]) != tolower((unsigned char) s.buffer[i])) return false;
+    return true;
+}
+
+bool String::endsWith(const String &suffix) const
+{
+    if (suffix.buffer.size() > buffer.size()) return false;
+    return buffer.compare(buffer.size() - suffix.buffer.size(), suffix.buffer.size(), suffix.buffer) == 0;
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const
+{
+    size_t pos = buffer.find(ch, fromIndex);
+    return (pos == std::string::npos) ? -1 : (int) pos;
+}
+
+int String::indexOf(const String &str, unsigned int fromIndex) const
+{
+    size_t pos = buffer.find(str.buffer, fromIndex);
+    return (pos == std::string::npos) ? -1 : (int) pos;
+}
+
+int String::lastIndexOf(char ch) const
+{
+    size_t pos = buffer.rfind(ch);
+    return (pos == std::string::npos) ? -1 : (int) pos;
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const
+{
+    if (beginIndex > endIndex)
+    {
+        unsigned int temp = endIndex;
+        endIndex = beginIndex;
+        beginIndex = temp;
+    }
+    if (beginIndex > buffer.size()) return String();
+    if (endIndex > buffer.size()) endIndex = buffer.size();
+
+    return String(buffer.substr(beginIndex, endIndex - beginIndex).c_str());
+}
+
+void String::replace(const String &find, const String &replace)
+{
+    if (find.buffer.empty()) return;
+
+    size_t pos = 0;
+    while ((pos = buffer.find(find.buffer, pos)) != std::string::npos)
+    {
+        buffer.replace(pos, find.buffer.size(), replace.buffer);
+        pos += replace.buffer.size();
+    }
+}
+
+void String::remove(unsigned int index, unsigned int count)
+{
+    if (index >= buffer.size()) return;
+    buffer.erase(index, count);
+}
+
+void String::toLowerCase()
+{
+    for (auto &c : buffer) c = (char) tolower((unsigned char) c);
+}
+
+void String::toUpperCase()
+{
+    for (auto &c : buffer) c = (char) toupper((unsigned char) c);
+}
+
+void String::trim()
+{
+    size_t begin = buffer.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) { buffer.clear(); return; }
+    size_t end = buffer.find_last_not_of(" \t\r\n");
+    buffer = buffer.substr(begin, end - begin + 1);
+}
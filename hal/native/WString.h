@@ -0,0 +1,86 @@
+//
+//  WString.h
+//
+//  Host (native) stand-in for the Arduino String class.
+//
+
+#ifndef WString_h
+#define WString_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+class String
+{
+  public:
+    String(const char *cstr = "") : buffer(cstr ? cstr : "") {}
+    String(const String &other) = default;
+    String(const __FlashStringHelper *str) : buffer(reinterpret_cast<const char *>(str)) {}
+    explicit String(char c) : buffer(1, c) {}
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(float value, unsigned char decimalPlaces = 2);
+    explicit String(double value, unsigned char decimalPlaces = 2);
+
+    String &operator=(const String &rhs) = default;
+    String &operator=(const char *cstr) { buffer = cstr ? cstr : ""; return *this; }
+
+    unsigned int length() const { return buffer.size(); }
+    const char *c_str() const { return buffer.c_str(); }
+
+    String &operator+=(const String &rhs) { buffer += rhs.buffer; return *this; }
+    String &operator+=(const char *cstr) { buffer += cstr; return *this; }
+    String &operator+=(char c) { buffer += c; return *this; }
+    String &operator+=(int num) { buffer += std::to_string(num); return *this; }
+    String &operator+=(unsigned int num) { buffer += std::to_string(num); return *this; }
+    String &operator+=(long num) { buffer += std::to_string(num); return *this; }
+    String &operator+=(unsigned long num) { buffer += std::to_string(num); return *this; }
+    unsigned char concat(const String &str) { buffer += str.buffer; return 1; }
+    unsigned char concat(const char *cstr) { buffer += cstr; return 1; }
+    unsigned char concat(char c) { buffer += c; return 1; }
+
+    friend String operator+(const String &lhs, const String &rhs) { String s(lhs); s += rhs; return s; }
+    friend String operator+(const String &lhs, const char *rhs) { String s(lhs); s += rhs; return s; }
+    friend String operator+(const char *lhs, const String &rhs) { String s(lhs); s += rhs; return s; }
+
+    bool equals(const String &s) const { return buffer == s.buffer; }
+    bool equals(const char *cstr) const { return buffer == (cstr ? cstr : ""); }
+    bool operator==(const String &rhs) const { return equals(rhs); }
+    bool operator==(const char *cstr) const { return equals(cstr); }
+    bool operator!=(const String &rhs) const { return !equals(rhs); }
+    bool operator!=(const char *cstr) const { return !equals(cstr); }
+    bool equalsIgnoreCase(const String &s) const;
+    bool startsWith(const String &prefix) const { return buffer.compare(0, prefix.buffer.size(), prefix.buffer) == 0; }
+    bool endsWith(const String &suffix) const;
+
+    char charAt(unsigned int index) const { return index < buffer.size() ? buffer[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char &operator[](unsigned int index) { static char dummy; return index < buffer.size() ? buffer[index] : (dummy = 0); }
+
+    int indexOf(char ch, unsigned int fromIndex = 0) const;
+    int indexOf(const String &str, unsigned int fromIndex = 0) const;
+    int lastIndexOf(char ch) const;
+
+    String substring(unsigned int beginIndex) const { return substring(beginIndex, buffer.size()); }
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+    void replace(const String &find, const String &replace);
+    void remove(unsigned int index, unsigned int count = (unsigned int) -1);
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+    long toInt() const { return strtol(buffer.c_str(), NULL, 10); }
+    float toFloat() const { return (float) strtod(buffer.c_str(), NULL); }
+
+  private:
+    std::string buffer;
+};
+
+#endif /* WString_h */
@@ -0,0 +1,44 @@
+//
+//  Wire.cpp
+//
+//  Host (native) stand-in for the Arduino Wire library.
+//
+
+#include "Wire.h"
+
+TwoWire Wire;
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    current.address = address;
+    current.length   = 0;
+    transmitting     = true;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+    (void) sendStop;
+    if (!transmitting) return 4;
+
+    if (numFrames < HAL_WIRE_MAX_FRAMES)
+        frames[numFrames++] = current;
+
+    transmitting = false;
+    return 0;
+}
+
+size_t TwoWire::write(uint8_t c)
+{
+    // the AVR Wire buffer holds 32 bytes, anything beyond that is dropped
+    if (!transmitting || (current.length >= HAL_WIRE_MAX_FRAME_SIZE)) return 0;
+
+    current.data[current.length++] = c;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *buf, size_t size)
+{
+    size_t n = 0;
+    while (size--) n += write(*buf++);
+    return n;
+}
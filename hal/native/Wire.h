@@ -0,0 +1,52 @@
+//
+//  Wire.h
+//
+//  Host (native) stand-in for the Arduino Wire library. Every completed
+//  transmission is captured as a frame so tests can inspect the I2C traffic.
+//
+
+#ifndef Wire_h
+#define Wire_h
+
+#include "Arduino.h"
+
+#define HAL_WIRE_MAX_FRAMES      64
+#define HAL_WIRE_MAX_FRAME_SIZE  32
+
+struct HalWireFrame
+{
+    uint8_t address;
+    uint8_t length;
+    uint8_t data[HAL_WIRE_MAX_FRAME_SIZE];
+};
+
+class TwoWire : public Stream
+{
+  public:
+    void begin() {}
+    void begin(uint8_t address) { (void) address; }
+    void setClock(uint32_t clock) { (void) clock; }
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address) { beginTransmission((uint8_t) address); }
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity) { (void) address; (void) quantity; return 0; }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buf, size_t size) override;
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+
+    // host helpers
+    HalWireFrame frames[HAL_WIRE_MAX_FRAMES];
+    unsigned int numFrames = 0;
+    void clearFrames() { numFrames = 0; }
+
+  private:
+    HalWireFrame current;
+    bool transmitting = false;
+};
+
+extern TwoWire Wire;
+
+#endif /* Wire_h */
@@ -0,0 +1,28 @@
+//
+//  avr/pgmspace.h
+//
+//  Host (native) stand-in: flash and RAM are the same address space.
+//
+
+#ifndef pgmspace_h
+#define pgmspace_h
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P  const char *
+#define PSTR(s) (s)
+
+#define pgm_read_byte(addr)   (*(const uint8_t *)(addr))
+#define pgm_read_word(addr)   (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr)  (*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr)    (*(void * const *)(addr))
+
+#define strlen_P   strlen
+#define strcmp_P   strcmp
+#define strncmp_P  strncmp
+#define strcpy_P   strcpy
+#define memcpy_P   memcpy
+
+#endif /* pgmspace_h */
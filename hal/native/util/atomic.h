@@ -0,0 +1,34 @@
+//
+//  util/atomic.h
+//
+//  Host (native) stand-in for avr-libc ATOMIC_BLOCK. Interrupts on the host are
+//  only ever raised synchronously by tests, so the block just tracks SREG.
+//
+
+#ifndef util_atomic_h
+#define util_atomic_h
+
+#include <stdint.h>
+
+extern volatile uint8_t halSREG;
+
+static inline uint8_t halAtomicEnter(void)
+{
+    uint8_t sreg = halSREG;
+    halSREG &= (uint8_t) ~0x80;
+    return 1 | (uint8_t) (sreg & 0x80);
+}
+
+static inline void halAtomicRestore(const uint8_t *state)
+{
+    if (*state & 0x80) halSREG |= 0x80;
+}
+
+#define ATOMIC_RESTORESTATE  0
+#define ATOMIC_FORCEON       0
+
+#define ATOMIC_BLOCK(type) \
+    for (uint8_t halAtomicState __attribute__((__cleanup__(halAtomicRestore))) = halAtomicEnter(); \
+         halAtomicState & 1; halAtomicState &= (uint8_t) ~1)
+
+#endif /* util_atomic_h */
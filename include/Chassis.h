@@ -44,8 +44,22 @@
 #  include <Wire.h>
 #endif
 
-// debug define
-#define DEBUG                     false
+#include "ChassisTokenizer.h"
+#include "ChassisKeywords.h"
+#include "ChassisCommands.h"
+#include "ChassisPorts.h"
+#include "ChassisSpeed.h"
+#include "ChassisOdometry.h"
+#include "ChassisDistance.h"
+#include "ChassisWireQueue.h"
+#include "ChassisLog.h"
+#include "ChassisReader.h"
+#include "ChassisTelemetry.h"
+#include "ChassisProfile.h"
+#include "ChassisKinematics.h"
+
+// debug define, set CHASSIS_LOG_LEVEL to LOG_LEVEL_DEBUG for the debug output of the library
+#define DEBUG                     (CHASSIS_LOG_LEVEL >= LOG_LEVEL_DEBUG)
 
 // Definitions used
 #define MAX_RUN_CYCLES            1000
@@ -54,20 +68,129 @@
 #define DEFAULT_CONF_FILE         "CONF.TXT"
 #define DEFAULT_COMMAND_FILE      "COMMANDS/GUIDE.TXT"
 #define MAX_ROTATION_ANGLE        360
-#define NUM_CONFIG_ITEMS          7
+#define ROTATION_SPEED            300       // mm/s of the wheels while rotating on the spot
 #define NUM_BLE_PINS              3
 #define NUM_LIGHT_PINS            4
 #define NUM_WHEEL_PINS            3
 #define NUM_WHEELS                4
 #define START_BLOCK_IDENTIFIER    "<MOVEMENT>"
 #define END_BLOCK_IDENTIFIER      "</MOVEMENT>"
-#define NUM_OF_COMMANDS           8
-#define WHEEL_CIRCUM_FLW          212       // mm's
+#define MAX_FILE_NAME_LENGTH      32        // longest path of the configuration and command files, including the 0
+#define WHEEL_CIRCUM_FLW          212       // mm's, default calibration, see setWheelCalibration()
 #define WHEEL_CIRCUM_FRW          212       // mm's
 #define WHEEL_CIRCUM_RLW          211       // mm's
 #define WHEEL_CIRCUM_RRW          211       // mm's
 #define PULSES_PER_TURN           20        // how many pulses for a single turn of a wheel
 #define PULSE_DETECTION           RISING    // detect HIGH to LOW
+#define TRACK_WIDTH               150       // mm between the left and right wheels, calibrate for skid steering
+#define MAX_PROGRAM_SIZE          256       // bytes of compiled movement program kept in SRAM
+#define PROGRAM_CACHE_EXTENSION   ".BIN"    // compiled program cache sits next to the command file
+#define PROGRAM_CACHE_MAGIC       0xC4
+#define PROGRAM_CACHE_VERSION     3
+#define MAX_PROGRAM_BLOCKS        16        // <MOVEMENT> blocks kept in the block index
+#define CONFIG_CACHE_ADDRESS      0         // EEPROM address of the cached configuration
+#define CONFIG_CACHE_MAGIC        0xC5
+#define CONFIG_CACHE_VERSION      1
+#define CONFIG_FLAG_LIGHTS        0x01      // flags of the cached configuration
+#define CONFIG_FLAG_OVERRIDE      0x02
+#define CONFIG_FLAG_SPEED_CONTROL 0x04
+#define MAX_CALL_DEPTH            4         // REPEATs and CALLs nested while a program runs
+#define MAX_PROGRAM_LABELS        8         // LABEL names of a program, GOTO targets included
+#define MAX_LABEL_LENGTH          8
+#define MAX_PROGRAM_JUMPS         16        // GOTOs and CALLs of a program
+#define MAX_CALL_FILES            4         // sub-route files CALLed by a program
+#define SPEED_CONTROL_PERIOD      50        // ms between speed controller steps (20 Hz)
+#define SPEED_WINDOW              8         // controller steps over which the wheel speed is measured
+#define SPEED_KP                  64        // default Q8 gains of the speed controller, 256 = 1.0
+#define SPEED_KI                  8
+#define SPEED_KD                  0
+#define SPEED_KFF                 96        // pwm per mm/s, roughly 255 pwm at 680 mm/s
+#define DISTANCE_MIN_SPEED        80        // mm/s, slowest speed while ramping down to a distance target
+#define DISTANCE_RAMP_RATE        3         // ramp down speed in mm/s per mm left to go
+#define DISTANCE_SETTLE_STEPS     4         // controller steps to let the wheels coast out before measuring
+#define DISTANCE_MAX_COAST        8         // pulses, limit of the learned overshoot compensation
+#define PROFILE_PERIOD            10        // ms between ramp steps of the motion profile
+#define PROFILE_ACCELERATION      500       // default pwm/s, standstill to full speed in half a second
+#define PROFILE_JERK              5000      // default pwm/s^2 of the s-curve
+
+//
+// opcodes of a compiled movement program. The commands are their own opcode (see ChassisKeywords.h),
+// operands are stored little endian directly behind the opcode
+//
+enum ChassisOpcode : uint8_t
+{
+    OP_WHEELS   = CMD_WHEELS,     // 4 x int16 wheel speeds
+    OP_FORWARD  = CMD_FORWARD,    // int16 speed
+    OP_BACKWARD = CMD_BACKWARD,   // int16 speed
+    OP_FULLSTOP = CMD_FULLSTOP,   // no operands
+    OP_ROTATE   = CMD_ROTATE,     // int16 angle
+    OP_LIGHTS   = CMD_LIGHTS,     // uint8 light bits, bit 0 = lfl ... bit 3 = rrl
+    OP_DURATION = CMD_DURATION,   // uint32 milliseconds
+    OP_DISTANCE = CMD_DISTANCE,   // uint16 centimetres
+    OP_END_OF_BLOCK,              // closes a <MOVEMENT> block
+    OP_REPEAT,                    // int16 count, uint16 position behind the matching OP_END_REPEAT
+    OP_END_REPEAT,                // back to the body of the innermost REPEAT until its count is done
+    OP_GOTO,                      // uint16 position
+    OP_CALL,                      // uint16 position of a sub-route
+    OP_RETURN,                    // end of a sub-route
+    OP_END_OF_PROGRAM             // end of the main program, the sub-routes follow
+};
+
+//
+// entry of the block index: where a <MOVEMENT> block starts in the program and a hash of its lines
+//
+struct ChassisBlockEntry
+{
+    uint16_t offset;
+    uint16_t hash;
+};
+
+//
+// the configuration as resolved from the configuration file, cached in EEPROM. Only the device
+// that wrote the record reads it back, multi byte fields are in its byte order
+//
+struct ChassisConfigRecord
+{
+    uint8_t  magic;
+    uint8_t  version;
+    uint32_t sourceSize;                          // of the configuration file it was parsed from
+    uint16_t sourceChecksum;
+    char     sourceName[MAX_FILE_NAME_LENGTH];
+    uint8_t  flags;                               // CONFIG_FLAG_*
+    uint8_t  wheelPins[NUM_WHEELS][NUM_WHEEL_PINS];
+    uint8_t  lightPins[NUM_LIGHT_PINS];
+    uint8_t  blePins[NUM_BLE_PINS];
+    int16_t  runCycles;
+    char     commandFile[MAX_FILE_NAME_LENGTH];
+    int16_t  speedGains[4];
+    uint16_t trackWidth;
+    uint16_t circumferences[NUM_WHEELS];          // 0.01 mm
+    uint16_t pulsesPerTurn[NUM_WHEELS];
+    int16_t  profile[3];                          // mode, acceleration, jerk
+    uint8_t  crc;                                 // CRC-8 of all fields before it
+};
+
+//
+// frame of the executor stack, a REPEAT with the rounds left or a CALL with remaining 0
+//
+struct ChassisStackFrame
+{
+    uint16_t position;            // start of the REPEAT body, return position of a CALL
+    uint16_t remaining;
+};
+
+struct ChassisCompileState;
+
+//
+// states of the non-blocking program executor
+//
+enum ChassisExecutorState : uint8_t
+{
+    EXEC_IDLE = 0,        // no program running
+    EXEC_RUNNING,         // executing instructions, one per update()
+    EXEC_WAIT_DURATION,   // waiting for a DURATION deadline
+    EXEC_WAIT_DISTANCE    // waiting for the wheels to travel a DISTANCE
+};
 
 //
 // Chassis class defintion
@@ -82,20 +205,79 @@ class Chassis {
     bool initialiseBLE(int blePinSettings[NUM_BLE_PINS]);
     
     // Configuration from file and associated functions
-    bool initialiseFromFile(String fileName);
-    void setCommandFile(String commandFileName);
+    bool initialiseFromFile(const char *fileName);
+    bool initialiseFromFile(const String &fileName);           // for sketches that pass a String
+    bool initialiseFromStream(Stream &source);
+    void setConfigCache(bool setting);     // keep the parsed configuration in EEPROM
+    bool initialiseFromCache();            // boot from EEPROM only, no SD card needed
+    bool setCommandFile(const char *commandFileName);
+    bool setCommandFile(const String &commandFileName);        // for sketches that pass a String
     void dumpSettings();
     void setRunCycles(int setting);
     int getRunCycles();
 
+    // movement program, compiled once from the command file and replayed from SRAM
+    bool compileCommandFile();
+    bool compileCommandStream(Stream &source);
+    void setProgramCache(bool setting);
+    int  getProgramLength();
+
+    // non-blocking program execution and speed control, call update() from loop()
+    bool startProgram(uint8_t block = 0);
+    void update();
+    bool isBusy();
+    void abort();
+    void runProgram();
+
+    // block index of the program, blocks are numbered from 0 in file order
+    bool jumpToBlock(uint8_t block);
+    uint8_t  getNumBlocks();
+    uint16_t getBlockHash(uint8_t block);
+    int  getCurrentBlock();
+
+    // commands of any front end (BLE, I2C, serial) on the same path as the program
+    bool execute(const ChassisParsedCommand &command);
+    bool execute(uint8_t commandId, const int16_t *args, uint8_t numArgs);
+    bool executeLine(const char *line, int length);
+
     // movement functions
     void moveWheels(int movements[NUM_WHEELS]);
     void moveBackwards(int speed);
     void moveForward(int speed);
     void doFullStop();
-    void doRotate(int angle);
+    bool doRotate(int angle);      // degrees, > 0 clockwise, completed from update()
     String getWheelSpeedStatus();
 
+    // acceleration and jerk limited movement functions, ramped from update(), see ChassisProfile.h
+    bool setMotionProfile(uint8_t mode, int acceleration, int jerk = PROFILE_JERK);
+    uint8_t getMotionProfile();
+    bool isRamping();
+
+    // closed loop speed control, speeds in mm/s driven from update()
+    void setSpeedControl(bool setting);
+    bool isSpeedControlEnabled();
+    void setSpeedGains(int kp, int ki, int kd, int kff);
+    void moveWheelsAt(int speeds[NUM_WHEELS]);
+    int  getWheelSpeed(int wheel);
+
+    // encoder based distance moves, completed from update()
+    bool moveDistance(long distance, int speed);
+    bool moveDistance(long distance);
+    bool isMoving();
+
+    // dead reckoning, updated from update() with the wheel counters
+    ChassisPose getPose();
+    void resetPose();
+    void setTrackWidth(int trackWidth);
+
+    // binary status frames at a fixed rate, sent from update(), see ChassisTelemetry.h
+    void setTelemetry(Print &output, uint8_t rate);     // frames per second, 0 stops
+    void getTelemetry(ChassisTelemetry &state);
+    uint8_t getTelemetryFrame(uint8_t frame[TELEMETRY_MAX_FRAME]);
+
+    // wheel calibration, circumference in 0.01 mm
+    bool setWheelCalibration(int wheel, long circumference, long pulsesPerTurn);
+
     // light functions
     void switchLightsOn(bool lights[NUM_LIGHT_PINS]);
     void setLightsOverride(bool setting);
@@ -117,6 +299,13 @@ class Chassis {
     void writeToOutput(String outputText);
     bool setReceivingEnd(uint8_t receiver);
 
+    // wire output is queued and sent from update(), one frame per call
+    void flushWire();
+    int  getWireQueued();
+    unsigned int getWireDropped();
+    unsigned int getWireOversized();
+    unsigned int getWireErrors();
+
 private:
     // default settings, can be changed during init phase
     int chassisWheels[NUM_WHEELS][NUM_WHEEL_PINS] = {
@@ -129,8 +318,8 @@ private:
     int chassisBLE[NUM_BLE_PINS]      = {10, 11, 9};       // RX pin Arduino -> TX on Module, TX pin Arduino -> RX on Module, Key pin in case of BLE module
      
     int runCycles = MAX_RUN_CYCLES;  // number of cycles to run
-    String configFile  = DEFAULT_CONF_FILE;
-    String commandFile = DEFAULT_COMMAND_FILE;
+    char configFile[MAX_FILE_NAME_LENGTH]  = DEFAULT_CONF_FILE;
+    char commandFile[MAX_FILE_NAME_LENGTH] = DEFAULT_COMMAND_FILE;
     
     bool lightsEnabled  = false;
     bool lightsOverride = false;
@@ -140,48 +329,169 @@ private:
  
     bool manualMode = true;
     
-    // configuration items
-    String configItemList[NUM_CONFIG_ITEMS][2] = {
-                                   {"LIGHTS", ""},
-                                   {"LIGHTS_OVERRIDE", ""},
-                                   {"LIGHT_PINS", ""},
-                                   {"WHEEL_PINS", ""},
-                                   {"BLE_PINS", ""},
-                                   {"CYCLE", ""},
-                                   {"MOVEMENTS", ""}
-                                                  };
-    
-    String commandsAvailable[NUM_OF_COMMANDS][2] = {
-                                    {"WHEELS",   "1"},
-                                    {"FORWARD",  "0"},
-                                    {"BACKWARD", "0"},
-                                    {"FULLSTOP", "0"},
-                                    {"ROTATE",   "1"},
-                                    {"LIGHTS",   "1"},
-                                    {"DURATION", "1"},
-                                    {"DISTANCE", "1"}
-                                                };
-    bool setConfValues();
-    bool validateCommand(String cmdString);
-
-    // outputStreams
-    bool haveSerial   = false;
-    bool haveWire     = false;  
+    bool setConfValue(const ChassisStatement &statement);
+    bool statementToInts(const ChassisStatement &statement, ChassisValueType valueType, int *values, int count);
+    bool initialiseFromReader(ChassisReader &reader);
+
+    // configuration cache in EEPROM
+    bool configCache = false;
+
+    bool loadConfigCache(ChassisConfigRecord &record);
+    void saveConfigCache(const char *fileName, uint32_t sourceSize, uint16_t sourceChecksum);
+    void applyConfig(const ChassisConfigRecord &record);
+    bool validateCommand(const char *cmdString);
+    bool setFileName(char field[MAX_FILE_NAME_LENGTH], const char *fileName);
+
+    // compiled movement program
+    uint8_t  program[MAX_PROGRAM_SIZE];
+    uint16_t programLength   = 0;
+    bool     programOverflow = false;
+    bool     programCache    = false;
+
+    // block index and the command file the program was compiled from
+    ChassisBlockEntry blocks[MAX_PROGRAM_BLOCKS];
+    uint8_t  numBlocks             = 0;
+    bool     programSourceOk       = false;
+    bool     programCalls          = false;     // sub-routes were compiled in, not cached
+    uint32_t programSourceSize     = 0;
+    uint16_t programSourceChecksum = 0;
+
+    // program executor
+    uint8_t       executorState  = EXEC_IDLE;
+    uint16_t      programCounter = 0;
+    int           cyclesDone     = 0;
+    unsigned long waitStart      = 0;
+    unsigned long waitDuration   = 0;
+    bool          programRunning = false;   // a wait returns to the program, otherwise to idle
+    ChassisStackFrame callStack[MAX_CALL_DEPTH];
+    uint8_t       callDepth      = 0;
+
+    bool compileCommandReader(ChassisReader &reader);
+    bool compileLines(ChassisReader &reader, ChassisCompileState &state);
+    bool compileControl(const ChassisStatement &statement, int8_t control, ChassisCompileState &state);
+    bool compileCallFile(ChassisCompileState &state, uint8_t file);
+    bool closeRepeats(ChassisCompileState &state);
+    bool resolveJumps(ChassisCompileState &state);
+    int8_t findLabel(ChassisCompileState &state, const ChassisText &name);
+    int8_t findCallFile(ChassisCompileState &state, const ChassisText &name);
+    void patchWord(uint16_t position, uint16_t value);
+    bool compileCommand(const ChassisStatement &statement);
+    void indexBlock(uint16_t offset, uint16_t hash);
+    void fletcher16(uint16_t &sum1, uint16_t &sum2, const uint8_t *data, uint16_t length);
+    void emitByte(uint8_t value);
+    void emitWord(int value);
+    int  readProgramWord(uint16_t pc);
+    uint16_t executeInstruction(uint16_t pc);
+    uint16_t executeControl(uint8_t opcode, uint16_t pc);
+    bool inProgram(uint16_t pc, uint8_t size);
+    uint16_t invalidProgram(uint16_t pc);
+    bool pushFrame(uint16_t position, uint16_t remaining);
+    void dispatchCommand(const ChassisParsedCommand &command);
+    void programCacheName(char name[MAX_FILE_NAME_LENGTH + sizeof(PROGRAM_CACHE_EXTENSION)]);
+    uint16_t sourceFileChecksum(File &sourceFile);
+    bool loadProgramCache(uint32_t sourceSize, uint16_t sourceChecksum);
+    void saveProgramCache(uint32_t sourceSize, uint16_t sourceChecksum);
+
+    // port register output of the direction and light pins
+    ChassisPortSet directionPins;
+    ChassisPortSet lightPins;
+    bool           pwmSynced = false;
+
+    void buildPortTables();
+    void driveWheels(int movements[NUM_WHEELS], bool ramped);
+    void writeWheels(int movements[NUM_WHEELS]);
+
+    // motion profile of moveWheels() and the movement functions built on it
+    ChassisProfileTable profileTable;
+    ChassisRamp   wheelRamps[NUM_WHEELS];
+    int           profileSettings[3] = {PROFILE_NONE, PROFILE_ACCELERATION, PROFILE_JERK};   // mode, pwm/s, pwm/s^2
+    bool          rampsActive       = false;
+    unsigned long nextProfileTick   = 0;
+
+    void profileTick();
+
+    // closed loop speed control
+    ChassisSpeedController speedControllers[NUM_WHEELS];
+    int           speedGains[4]     = {SPEED_KP, SPEED_KI, SPEED_KD, SPEED_KFF};
+    bool          speedControl      = false;   // closed loop enabled
+    bool          speedTargetsSet   = false;   // moveWheelsAt() is in charge of the wheels
+    int8_t        wheelDirections[NUM_WHEELS]  = {0, 0, 0, 0};   // last direction, kept while coasting
+    int           measuredSpeeds[NUM_WHEELS]   = {0, 0, 0, 0};
+    uint16_t      lastPulseTotals[NUM_WHEELS]  = {0, 0, 0, 0};
+    uint8_t       pulseWindow[NUM_WHEELS][SPEED_WINDOW];
+    uint8_t       pulseWindowPos    = 0;
+    unsigned long nextSpeedTick     = 0;
+
+    void speedControlTick();
+    void measureWheelSpeeds();
+    void speedsToPwm(const int speeds[NUM_WHEELS], int movements[NUM_WHEELS]);
+
+    // distance moves
+    bool          distanceActive    = false;
+    uint8_t       distanceStopped   = 0;       // bit per wheel that reached its target
+    uint8_t       distanceSettle    = 0;
+    uint16_t      distanceStart[NUM_WHEELS];   // pulse totals at the start of the move
+    uint16_t      distanceTarget[NUM_WHEELS];  // pulses to travel
+    int           distanceSpeeds[NUM_WHEELS];  // cruise speeds in mm/s
+    int8_t        coastPulses[NUM_WHEELS]   = {0, 0, 0, 0};   // learned overshoot, wheels stop this early
+
+    bool startDistance(long distance, int speeds[NUM_WHEELS]);
+    void rampWheelsAt(int speeds[NUM_WHEELS]);
+    void distanceTick();
+
+    // dead reckoning
+    ChassisOdometry odometry;
+
+    // telemetry
+    ChassisTelemetryEncoder telemetryEncoder;
+    Print         *telemetryOutput  = NULL;
+    unsigned long  telemetryPeriod  = 0;       // ms between frames, 0 = off
+    unsigned long  nextTelemetry    = 0;
+    uint8_t        telemetryFrame[TELEMETRY_MAX_FRAME];     // frame being sent
+    uint8_t        telemetryLength  = 0;
+    uint8_t        telemetrySent    = 0;
+
+    // pulses to distance of every wheel, Q24.8 mm for the dead reckoning
+    ChassisPulseConverter wheelDistances[NUM_WHEELS] = {
+                                    ChassisPulseConverter(ODOMETRY_Q, WHEEL_CIRCUM_FLW * 100, PULSES_PER_TURN),
+                                    ChassisPulseConverter(ODOMETRY_Q, WHEEL_CIRCUM_FRW * 100, PULSES_PER_TURN),
+                                    ChassisPulseConverter(ODOMETRY_Q, WHEEL_CIRCUM_RLW * 100, PULSES_PER_TURN),
+                                    ChassisPulseConverter(ODOMETRY_Q, WHEEL_CIRCUM_RRW * 100, PULSES_PER_TURN)
+                                                    };
+
+    // outputStreams, Serial and Wire are switched in chassisLog
     uint8_t receivingEnd = 0x08;
+
+    uint16_t wireErrors = 0;      // frames not acknowledged by the receiving end
+
+    bool sendWireFrame();
+    void sendTelemetry();
 };
 
 //
 // interrupts cannot be part of a class :(
 //
-extern volatile byte numPulses[];
-extern unsigned int cumulativeDistances[];
+extern volatile uint16_t numPulses[];
+extern volatile uint16_t pulseTotals[];
+extern volatile uint32_t cumulativeDistances[];
 extern int pulseCounters[];
+extern ChassisPulseConverter pulseConverters[];
 
 extern bool initialisePulseCounters();
 extern void doPulseCalculation();
-extern void pulseCounterFLW();
-extern void pulseCounterFRW();
-extern void pulseCounterRLW();
-extern void pulseCounterRRW();
+extern void snapshotPulses(uint16_t pulses[NUM_WHEELS]);
+extern void snapshotPulseTotals(uint16_t totals[NUM_WHEELS]);
+extern uint32_t readCumulativeDistance(int wheel);
+extern void resetCumulativeDistances();
+
+//
+// pulse counter of a wheel, one interrupt handler is generated per wheel
+//
+template <uint8_t Wheel>
+void pulseCounter()
+{
+    numPulses[Wheel]++;
+    pulseTotals[Wheel]++;
+}
 
 #endif /* Chassis_h */
@@ -0,0 +1,60 @@
+//
+//  ChassisCommands.h
+//
+//
+//  Commands in their parsed form, shared by every front end.
+//
+//  A command line of the command file, the BLE link or the I2C bus is turned into a
+//  ChassisParsedCommand once: the command id of ChassisKeywords.h and up to
+//  MAX_COMMAND_ARGS int16 operands. Chassis::execute() dispatches that form without
+//  looking at the text again, so all front ends share one path into the chassis.
+//
+//  Operands per command:
+//
+//      WHEELS      4   wheel speeds, lfw rfw lrw rrw, -255..255
+//      FORWARD     1   speed -255..255, 0 when left out
+//      BACKWARD    1   speed -255..255, 0 when left out
+//      FULLSTOP    0
+//      ROTATE      1   angle -360..360
+//      LIGHTS      1   light bits, bit 0 = lfl ... bit 3 = rrl
+//      DURATION    2   milliseconds 0..2^31-1, low word first
+//      DISTANCE    1   centimetres 0..32767
+//
+//  A value out of its range is rejected rather than narrowed into the int16 operand.
+//
+
+#ifndef ChassisCommands_h
+#define ChassisCommands_h
+
+#include <stdint.h>
+
+#include "ChassisTokenizer.h"
+#include "ChassisKeywords.h"
+
+#define MAX_COMMAND_ARGS          4
+
+#define COMMAND_MAX_SPEED         255       // same as MAX_WHEEL_SPEED
+#define COMMAND_MAX_ANGLE         360       // same as MAX_ROTATION_ANGLE
+#define COMMAND_MAX_DISTANCE      32767
+#define COMMAND_MAX_DURATION      0x7FFFFFFFL  // ms, what the two int16 operands hold
+
+struct ChassisParsedCommand
+{
+    uint8_t command;                    // ChassisCommand
+    uint8_t numArgs;
+    int16_t args[MAX_COMMAND_ARGS];
+};
+
+enum ChassisCommandResult : uint8_t
+{
+    COMMAND_OK = 0,
+    COMMAND_UNKNOWN,            // not a command keyword
+    COMMAND_MISSING_VALUE,      // e.g. WHEELS without (...)
+    COMMAND_INVALID_VALUE       // wrong value type, count or number
+};
+
+ChassisCommandResult chassisParseCommand(const ChassisStatement &statement, ChassisParsedCommand &parsed);
+uint8_t chassisCommandArgs(uint8_t command);            // operands of a command, see above
+bool chassisCommandInRange(const ChassisParsedCommand &parsed);     // command, operand count and values valid
+
+#endif /* ChassisCommands_h */
@@ -0,0 +1,52 @@
+//
+//  ChassisDistance.h
+//
+//
+//  Exact conversion of wheel encoder pulses into distance.
+//
+//  A wheel is calibrated with its circumference in 0.01 mm and the number of encoder
+//  pulses per turn. Converting a batch of pulses with convert() keeps the remainder of
+//  the division and carries it into the next batch, so the sum of all results equals
+//  total pulses * circumference / pulses per turn, however the pulses were batched.
+//  Nothing is lost to truncation and the distance never drifts.
+//
+//  The result unit is mm with fractionBits fractional bits, 0 gives whole mm and
+//  8 gives Q24.8 mm.
+//
+
+#ifndef ChassisDistance_h
+#define ChassisDistance_h
+
+#include <stdint.h>
+
+class ChassisPulseConverter
+{
+  public:
+    constexpr ChassisPulseConverter(uint8_t bits = 0, uint16_t wheelCircumference = 0, uint16_t wheelPulsesPerTurn = 1) :
+        circumference(wheelCircumference),
+        pulsesPerTurn((wheelPulsesPerTurn > 0) ? wheelPulsesPerTurn : 1),
+        fractionBits(bits),
+        residue(0)
+    {
+    }
+
+    void setCalibration(uint16_t wheelCircumference, uint16_t wheelPulsesPerTurn);   // 0.01 mm per turn
+    uint16_t getCircumference();
+    uint16_t getPulsesPerTurn();
+
+    uint32_t convert(uint16_t pulses);    // accumulating, exact over time
+    void reset();                         // drop the carried remainder
+
+    // stateless conversions with the same calibration
+    uint32_t toDistance(uint16_t pulses);                          // whole mm, truncated
+    uint16_t toPulses(uint32_t distance);                          // mm to pulses, rounded
+    uint16_t toSpeed(uint16_t pulses, uint16_t milliseconds);      // mm/s
+
+  private:
+    uint16_t circumference;     // 0.01 mm
+    uint16_t pulsesPerTurn;
+    uint8_t  fractionBits;
+    uint32_t residue;           // always below pulsesPerTurn * 100
+};
+
+#endif /* ChassisDistance_h */
@@ -0,0 +1,82 @@
+//
+//  ChassisKeywords.h
+//
+//
+//  Keywords of the configuration and command files, kept in flash.
+//
+//  A keyword is found without searching a table: its length and first letter select the
+//  only candidate (DURATION and DISTANCE are told apart by their last letter), which is
+//  then compared once with its name in flash. Lookups are case insensitive like the rest
+//  of the parser.
+//
+//  The ids are the positions in the tables, i.e. the ChassisConfItem and ChassisCommand
+//  values. Adding a keyword means adding it to the enum, the table in ChassisKeywords.cpp
+//  and the length switch next to it.
+//
+
+#ifndef ChassisKeywords_h
+#define ChassisKeywords_h
+
+#include <stdint.h>
+
+#include "ChassisTokenizer.h"
+
+//
+// configuration items of CONF.TXT
+//
+enum ChassisConfItem : uint8_t
+{
+    CONF_LIGHTS = 0,
+    CONF_LIGHTS_OVERRIDE,
+    CONF_LIGHT_PINS,
+    CONF_WHEEL_PINS,
+    CONF_BLE_PINS,
+    CONF_CYCLE,
+    CONF_MOVEMENTS,
+    CONF_SPEED_CONTROL,
+    CONF_SPEED_GAINS,
+    CONF_TRACK_WIDTH,
+    CONF_WHEEL_CALIBRATION,
+    CONF_MOTION_PROFILE,
+    NUM_CONFIG_ITEMS
+};
+
+//
+// commands of a <MOVEMENT> block, also the first opcodes of a compiled program
+//
+enum ChassisCommand : uint8_t
+{
+    CMD_WHEELS = 0,
+    CMD_FORWARD,
+    CMD_BACKWARD,
+    CMD_FULLSTOP,
+    CMD_ROTATE,
+    CMD_LIGHTS,
+    CMD_DURATION,
+    CMD_DISTANCE,
+    NUM_OF_COMMANDS
+};
+
+//
+// control flow of a <MOVEMENT> block, compiled into the program only
+//
+enum ChassisControl : uint8_t
+{
+    CTRL_REPEAT = 0,      // REPEAT = n ... END
+    CTRL_END,
+    CTRL_LABEL,           // LABEL = name
+    CTRL_GOTO,            // GOTO = name
+    CTRL_CALL,            // CALL = file
+    NUM_OF_CONTROLS
+};
+
+int8_t chassisFindConfItem(const ChassisText &key);     // -1 when unknown
+int8_t chassisFindCommand(const ChassisText &key);      // -1 when unknown
+int8_t chassisFindControl(const ChassisText &key);      // -1 when unknown
+
+const char *chassisConfItemName(uint8_t item);          // PROGMEM
+const char *chassisCommandName(uint8_t command);        // PROGMEM
+const char *chassisControlName(uint8_t control);        // PROGMEM
+bool chassisCommandNeedsValue(uint8_t command);         // e.g. WHEELS = (...), FORWARD alone is valid
+
+#endif /* ChassisKeywords_h */
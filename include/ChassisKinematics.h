@@ -0,0 +1,72 @@
+//
+//  ChassisKinematics.h
+//
+//
+//  Drive geometries: how a movement of the chassis maps onto its wheels.
+//
+//  A movement is (vx, vy, omega) on the PWM scale: vx forward, vy to the left and omega
+//  counter clockwise. A drive turns it into the value of every wheel, the wheels are
+//  numbered front to back in left/right pairs, i.e. even wheels on the left and odd
+//  wheels on the right:
+//
+//      SkidDrive       2, 4 or 6 wheels, the sides turn the chassis, vy is ignored
+//      MecanumDrive    4 wheels with their rollers in an X seen from above, also moves
+//                      sideways
+//
+//  A drive is a struct with a constexpr wheelSpeed(), so with a fixed number of wheels
+//  every wheel value folds into a few additions.
+//
+
+#ifndef ChassisKinematics_h
+#define ChassisKinematics_h
+
+#include <stdint.h>
+
+struct SkidDrive
+{
+    static constexpr bool holonomic = false;
+
+    static constexpr bool supports(uint8_t numWheels)
+    {
+        return (numWheels >= 2) && (numWheels <= 6) && ((numWheels % 2) == 0);
+    }
+
+    static constexpr int wheelSpeed(uint8_t wheel, int vx, int /* vy */, int omega)
+    {
+        return (wheel & 1) ? (vx + omega) : (vx - omega);
+    }
+};
+
+struct MecanumDrive
+{
+    static constexpr bool holonomic = true;
+
+    static constexpr bool supports(uint8_t numWheels)
+    {
+        return numWheels == 4;
+    }
+
+    // front left, front right, rear left, rear right
+    static constexpr int wheelSpeed(uint8_t wheel, int vx, int vy, int omega)
+    {
+        return (wheel == 0) ? (vx - vy - omega) :
+               (wheel == 1) ? (vx + vy + omega) :
+               (wheel == 2) ? (vx + vy - omega) :
+                              (vx - vy + omega);
+    }
+};
+
+//
+// the lights that go with a movement, from the sums of the left and right wheel values:
+// forward is lfl and rfl, backward is rll and rrl, turning on the spot lights the front
+// light on the side the chassis turns to
+//
+inline void chassisMovementLights(long left, long right, bool lights[4])
+{
+    lights[0] = (right > 0) && (left != 0);
+    lights[1] = (left > 0) && (right != 0);
+    lights[2] = (left < 0) && (right < 0);
+    lights[3] = lights[2];
+}
+
+#endif /* ChassisKinematics_h */
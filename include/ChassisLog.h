@@ -0,0 +1,119 @@
+//
+//  ChassisLog.h
+//
+//
+//  Flash resident logging to the Serial and Wire outputs.
+//
+//  A log line is a list of items that are streamed one by one to the enabled outputs,
+//  no String is built on the way. Text stays in flash when it is wrapped in F():
+//
+//      LOG_ERROR(F("Chassis::compileCommandFile ERROR line "), lineNumber, F(" too long"));
+//
+//  Items can be anything Print can print, a ChassisText view of the tokenizer buffer or
+//  a ChassisLogList of ints, which is printed as {a,b,c}.
+//
+//  Every line has a level, lines above CHASSIS_LOG_LEVEL are removed by the preprocessor
+//  and cost neither flash nor cycles, their arguments are not evaluated. Select the level
+//  with a build flag, e.g. -DCHASSIS_LOG_LEVEL=LOG_LEVEL_DEBUG
+//
+
+#ifndef ChassisLog_h
+#define ChassisLog_h
+
+#include <Arduino.h>
+
+#include "ChassisTokenizer.h"
+#include "ChassisWireQueue.h"
+
+#define LOG_LEVEL_NONE            0
+#define LOG_LEVEL_ERROR           1
+#define LOG_LEVEL_WARNING         2
+#define LOG_LEVEL_INFO            3         // settings dumps and progress
+#define LOG_LEVEL_DEBUG           4
+
+#ifndef CHASSIS_LOG_LEVEL
+#  define CHASSIS_LOG_LEVEL       LOG_LEVEL_INFO
+#endif
+
+// a PROGMEM string as a log item, like the text of F()
+#define LOG_FLASH(text)           (reinterpret_cast<const __FlashStringHelper *>(text))
+
+#if CHASSIS_LOG_LEVEL >= LOG_LEVEL_ERROR
+#  define LOG_ERROR(...)          chassisLog.line(__VA_ARGS__)
+#else
+#  define LOG_ERROR(...)          do {} while (0)
+#endif
+
+#if CHASSIS_LOG_LEVEL >= LOG_LEVEL_WARNING
+#  define LOG_WARNING(...)        chassisLog.line(__VA_ARGS__)
+#else
+#  define LOG_WARNING(...)        do {} while (0)
+#endif
+
+#if CHASSIS_LOG_LEVEL >= LOG_LEVEL_INFO
+#  define LOG_INFO(...)           chassisLog.line(__VA_ARGS__)
+#else
+#  define LOG_INFO(...)           do {} while (0)
+#endif
+
+#if CHASSIS_LOG_LEVEL >= LOG_LEVEL_DEBUG
+#  define LOG_DEBUG(...)          chassisLog.line(__VA_ARGS__)
+#else
+#  define LOG_DEBUG(...)          do {} while (0)
+#endif
+
+//
+// a list of ints printed as {a,b,c}
+//
+struct ChassisLogList
+{
+    ChassisLogList(const int *listValues, uint8_t listCount) : values(listValues), count(listCount) {}
+
+    const int *values;
+    uint8_t    count;
+};
+
+class ChassisLog : public Print
+{
+  public:
+    void setSerial(bool setting);
+    void setWire(bool setting);
+    ChassisWireQueue &getWireQueue();
+
+    // one line with all items, use the LOG_ macros to have it removed by level
+    template <typename... Items> void line(const Items &... items)
+    {
+        begin();
+        printItems(items...);
+        end();
+    }
+
+    // or build a line piece by piece with print() in between
+    void begin();
+    void end();
+
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buffer, size_t size);
+    using Print::write;
+
+  private:
+    bool serial = false;
+    bool wire   = false;
+    ChassisWireQueue wireQueue;
+
+    void printItems() {}
+
+    template <typename Item, typename... Items> void printItems(const Item &item, const Items &... items)
+    {
+        printItem(item);
+        printItems(items...);
+    }
+
+    template <typename Item> void printItem(const Item &item) { print(item); }
+    void printItem(const ChassisText &text);
+    void printItem(const ChassisLogList &list);
+};
+
+extern ChassisLog chassisLog;
+
+#endif /* ChassisLog_h */
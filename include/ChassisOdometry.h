@@ -0,0 +1,59 @@
+//
+//  ChassisOdometry.h
+//
+//
+//  Fixed point dead reckoning from the left and right wheel distances.
+//
+//  The pose is kept without floating point:
+//
+//      x, y      Q24.8 mm, i.e. 256 = 1 mm
+//      heading   binary angle, 65536 = 360 degrees, counter clockwise
+//
+//  The chassis starts at (0, 0) looking along the x axis. Every update() takes the
+//  distance travelled by the left and right side since the previous update, turns the
+//  heading by their difference over the track width and moves the position along the
+//  average heading of the step.
+//
+
+#ifndef ChassisOdometry_h
+#define ChassisOdometry_h
+
+#include <stdint.h>
+
+#define ODOMETRY_Q                8         // fractional bits of x, y and the distances
+#define ODOMETRY_ANGLE_BITS       24        // internal heading resolution, full circle = 1 << bits
+
+struct ChassisPose
+{
+    int32_t  x;           // Q24.8 mm
+    int32_t  y;           // Q24.8 mm
+    uint16_t heading;     // 65536 = 360 degrees
+};
+
+class ChassisOdometry
+{
+  public:
+    ChassisOdometry(void);
+
+    void setTrackWidth(uint16_t trackWidth);    // mm between the left and right wheels
+    uint16_t getTrackWidth();
+
+    void update(int32_t left, int32_t right);   // Q24.8 mm travelled per side, < 0 is backward
+    void reset();
+    ChassisPose getPose();
+
+  private:
+    uint16_t trackWidth  = 150;
+    int32_t  x           = 0;
+    int32_t  y           = 0;
+    uint32_t heading     = 0;     // full circle = 1 << ODOMETRY_ANGLE_BITS, wraps
+    int32_t  turnResidue = 0;     // remainder of the heading division, carried to the next step
+};
+
+//
+// Q15 sine and cosine of a binary angle, 65536 = 360 degrees
+//
+int16_t chassisSin(uint16_t angle);
+int16_t chassisCos(uint16_t angle);
+
+#endif /* ChassisOdometry_h */
@@ -0,0 +1,50 @@
+//
+//  ChassisPorts.h
+//
+//
+//  Direct port register output for the digital pins of the chassis.
+//
+//  The port and bit of every pin are looked up once when the pins are
+//  configured. Pins sharing a port are written with a single register store,
+//  and a port is not touched at all when none of its pins change.
+//
+
+#ifndef ChassisPorts_h
+#define ChassisPorts_h
+
+#if defined(__has_include)
+#  if __has_include(<Arduino.h>)
+#    include <Arduino.h>
+#  elif __has_include(<arduino.h>)
+#    include <arduino.h>
+#  endif
+#else
+#  include <Arduino.h>
+#endif
+
+#define MAX_PORT_PINS             8         // pins in a single port set
+#define MAX_PORT_GROUPS           8         // distinct ports in a single port set
+
+class ChassisPortSet
+{
+  public:
+    ChassisPortSet(void);
+
+    void clear();
+    bool addPin(int pin);       // pins are numbered in the order they are added
+    void set(uint8_t pinIndex, bool value);
+    void write();               // one store per port whose pins changed
+    uint8_t getNumPorts();
+
+  private:
+    volatile uint8_t *ports[MAX_PORT_GROUPS];
+    uint8_t portMasks[MAX_PORT_GROUPS];       // all pins of this set on the port
+    uint8_t portValues[MAX_PORT_GROUPS];      // requested pin levels, applied by write()
+    uint8_t numPorts;
+
+    uint8_t pinPorts[MAX_PORT_PINS];
+    uint8_t pinMasks[MAX_PORT_PINS];
+    uint8_t numPins;
+};
+
+#endif /* ChassisPorts_h */
@@ -0,0 +1,83 @@
+//
+//  ChassisProfile.h
+//
+//
+//  Acceleration and jerk limited ramps of the wheel PWM values.
+//
+//  Instead of jumping to a new value every wheel is ramped to it in fixed ticks. The
+//  ramp of a wheel moves through a table of speed steps that is computed once from the
+//  limits:
+//
+//      trapezoid   one step of acceleration * tick, the speed changes linearly
+//      s-curve     steps growing by jerk * tick^2 up to the acceleration step, so the
+//                  acceleration itself ramps up and down (at most PROFILE_MAX_STEPS
+//                  steps, a steeper jerk is used when more would be needed)
+//
+//  Every tick a ramp takes the largest step it can still brake from in time, i.e. one
+//  level up, the same or one level down the table. The cumulative table tells how much
+//  speed change braking from a level takes, so the ramp lands on its target without
+//  overshoot. A new target while ramping is taken from the current speed and level,
+//  a reversal eases out of the old direction first.
+//
+//  The values are Q7 PWM, 128 = 1 PWM step, the full -255..255 range fits an int16.
+//
+
+#ifndef ChassisProfile_h
+#define ChassisProfile_h
+
+#include <stdint.h>
+
+#define PROFILE_Q                 7         // fractional bits of the ramped pwm values
+#define PROFILE_MAX_STEPS         16        // entries of the step table, ticks of the jerk phase
+#define PROFILE_PWM_LIMIT         255
+
+enum ChassisProfileMode : uint8_t
+{
+    PROFILE_NONE = 0,     // values are applied at once
+    PROFILE_TRAPEZOID,    // acceleration limited
+    PROFILE_S_CURVE       // acceleration and jerk limited
+};
+
+//
+// step table shared by the ramps of all wheels
+//
+class ChassisProfileTable
+{
+  public:
+    ChassisProfileTable(void);
+
+    // pwm/s, pwm/s^2 (s-curve only) and ms per tick, false for invalid limits
+    bool setLimits(uint8_t mode, uint16_t acceleration, uint16_t jerk, uint16_t period);
+    uint8_t getMode() const;
+    uint8_t getNumSteps() const;
+
+    uint16_t step(uint8_t level) const;      // Q7 speed change of a tick at level 1..numSteps
+    uint16_t brake(uint8_t level) const;     // Q7 speed change of braking from level to 0
+
+  private:
+    uint8_t  mode     = PROFILE_NONE;
+    uint8_t  numSteps = 0;
+    uint16_t steps[PROFILE_MAX_STEPS];
+    uint16_t brakes[PROFILE_MAX_STEPS];     // saturated at 0xFFFF
+};
+
+//
+// ramp of a single wheel
+//
+class ChassisRamp
+{
+  public:
+    void setTarget(int16_t pwm);
+    void reset(int16_t pwm);                 // jump to the value, nothing left to ramp
+    int16_t update(const ChassisProfileTable &table);    // one tick, returns the pwm
+    int16_t getValue() const;
+    int16_t getTarget() const;
+    bool isDone() const;
+
+  private:
+    int16_t value  = 0;       // Q7 pwm
+    int16_t target = 0;       // Q7 pwm
+    int8_t  level  = 0;       // table level, the sign is the direction the value moves in
+};
+
+#endif /* ChassisProfile_h */
@@ -0,0 +1,56 @@
+//
+//  ChassisReader.h
+//
+//
+//  Block buffered statement reader for the configuration and command files.
+//
+//  The file is read READER_BLOCK_SIZE bytes at a time into one static buffer and cut
+//  into statements at their terminator (';' or '\n'). A statement is handed out as a
+//  ChassisText view of that buffer, nothing is copied, and stays valid up to the next
+//  call of next(). The unread tail of a block is moved to the front before the next
+//  block is read behind it, so a statement can span blocks.
+//
+//  SD files are read with one File::read() per block, served from the sector cache of
+//  the SD library. Other Streams are read byte by byte without the Stream timeout.
+//
+//  The buffer is shared, only one reader can be in use at a time.
+//
+
+#ifndef ChassisReader_h
+#define ChassisReader_h
+
+#include <Arduino.h>
+#include <SD.h>
+
+#include "ChassisTokenizer.h"
+
+#ifndef READER_BLOCK_SIZE
+#define READER_BLOCK_SIZE         128       // bytes per read, up to 512 (one SD sector)
+#endif
+#define READER_BUFFER_SIZE        (READER_BLOCK_SIZE + MAX_STATEMENT_LENGTH)
+
+class ChassisReader
+{
+  public:
+    ChassisReader(File &source);
+    ChassisReader(Stream &source);
+
+    // false at the end of the source, truncated statements are cut at MAX_STATEMENT_LENGTH - 1
+    bool next(char terminator, ChassisText &statement, bool &truncated);
+    uint32_t getBytesRead();
+
+  private:
+    static char buffer[READER_BUFFER_SIZE];
+
+    File     *file;
+    Stream   *stream;
+    uint16_t  start;          // first byte of the next statement
+    uint16_t  end;            // end of the bytes read
+    bool      endOfSource;
+    bool      skipping;       // dropping the rest of a truncated statement
+    uint32_t  bytesRead;
+
+    bool fill();
+};
+
+#endif /* ChassisReader_h */
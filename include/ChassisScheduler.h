@@ -0,0 +1,76 @@
+//
+//  ChassisScheduler.h
+//
+//
+//  Fixed rate tasks run from loop(), with the timer interrupt only counting ticks.
+//
+//  The ticks come from millis(), or from tick() called by a timer interrupt the sketch
+//  owns, which does nothing but count them. run() is called from loop() and calls the
+//  tasks that are due, so the work of a task never delays other interrupts and a task
+//  may use Serial, the SD card or String:
+//
+//      period > 0      called every period ms, in the order the tasks were added
+//      period 0        background, called on the passes no periodic task was due
+//
+//  Every task has its own statistics: the runs, the longest run in us, the runs that
+//  took longer than its budget and the periods that were missed because run() was
+//  late. A late task runs once and then keeps its rate, missed periods are not made up.
+//
+//  Built with SCHEDULER_USE_TIMER1 the library owns the Timer1 compare A interrupt and
+//  begin() sets Timer1 up for a tick every ms. Without it Timer1 stays free for Servo,
+//  TimerOne or PWM on pins 11 and 12, and begin() returns false.
+//
+
+#ifndef ChassisScheduler_h
+#define ChassisScheduler_h
+
+#include <stdint.h>
+
+#define SCHEDULER_MAX_TASKS       6
+#define SCHEDULER_TICK_RATE       1000      // ticks per second, i.e. periods in ms
+
+typedef void (*ChassisTaskFunction)(void *context);
+
+struct ChassisTask
+{
+    ChassisTaskFunction function;
+    void    *context;
+    uint16_t period;          // ticks, 0 for a background task
+    uint16_t budget;          // us, 0 for none
+    uint16_t next;            // tick the task is due
+    uint16_t runs;            // the counters saturate
+    uint16_t overruns;
+    uint16_t missed;
+    uint16_t longest;         // us
+};
+
+class ChassisScheduler
+{
+  public:
+    ChassisScheduler(void);
+
+    // id of the task, -1 when all SCHEDULER_MAX_TASKS are taken
+    int8_t addTask(ChassisTaskFunction function, void *context, uint16_t period, uint16_t budget = 0);
+
+    bool begin();             // start the Timer1 tick, false without SCHEDULER_USE_TIMER1
+    void tick();              // interrupt side, counts a tick
+    void run();               // loop() side, calls the tasks that are due
+
+    uint16_t getRuns(int8_t task);
+    uint16_t getOverruns(int8_t task);
+    uint16_t getMissed(int8_t task);
+    uint16_t getLongest(int8_t task);
+    void resetStatistics();
+
+  private:
+    ChassisTask tasks[SCHEDULER_MAX_TASKS];
+    uint8_t numTasks = 0;
+
+    volatile uint16_t ticks   = 0;
+    volatile bool     ticking = false;    // ticks come from tick(), not from millis()
+
+    uint16_t now();
+    void call(ChassisTask &task);
+};
+
+#endif /* ChassisScheduler_h */
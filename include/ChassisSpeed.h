@@ -0,0 +1,53 @@
+//
+//  ChassisSpeed.h
+//
+//
+//  Fixed point closed loop speed control for a single wheel.
+//
+//  The controller turns a target speed in mm/s and a measured speed in mm/s into a
+//  PWM value of -255..255:
+//
+//      pwm = (kff * target + kp * error + ki * sum(error) + kd * delta(error)) / 256
+//
+//  All gains are Q8, i.e. 256 is a gain of 1.0. The integral is clamped so it can
+//  never push the output beyond full scale on its own, and it is frozen while the
+//  output is saturated in the direction of the error (anti windup). The error is taken
+//  in 32 bits and saturated to SPEED_ERROR_LIMIT, so extreme speeds never wrap around.
+//
+//  The controller is called at a fixed rate, the integral and derivative gains are
+//  therefore per tick.
+//
+
+#ifndef ChassisSpeed_h
+#define ChassisSpeed_h
+
+#include <stdint.h>
+
+#define SPEED_PWM_LIMIT           255       // output range of the controller is -limit..limit
+#define SPEED_ERROR_LIMIT         8191      // mm/s, the error is saturated to -limit..limit
+
+class ChassisSpeedController
+{
+  public:
+    ChassisSpeedController(void);
+
+    void setGains(int16_t kp, int16_t ki, int16_t kd, int16_t kff);
+    void setTarget(int16_t target);     // mm/s, the sign is the direction
+    int16_t getTarget();
+    void reset();                       // clear the integral and derivative history
+
+    int16_t update(int16_t measured);   // measured mm/s, signed, returns the pwm
+
+  private:
+    int16_t kp  = 0;
+    int16_t ki  = 0;
+    int16_t kd  = 0;
+    int16_t kff = 0;
+
+    int16_t target    = 0;
+    int32_t integral  = 0;
+    int16_t lastError = 0;
+    int32_t integralLimit = 0;
+};
+
+#endif /* ChassisSpeed_h */
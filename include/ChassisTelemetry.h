@@ -0,0 +1,83 @@
+//
+//  ChassisTelemetry.h
+//
+//
+//  Compact binary status frames for low bandwidth links (BLE serial, I2C).
+//
+//  A frame carries the state of the chassis as ten integer fields. Only the first frame
+//  and every TELEMETRY_KEY_INTERVAL-th frame after it carry all fields, the frames in
+//  between carry the changes since the previous frame: a bit mask of the changed fields
+//  followed by their differences. All numbers are zigzag varints, so a difference of
+//  -64..63 takes a single byte. A chassis driving at constant speed sends about ten
+//  bytes per frame, one standing still five.
+//
+//      0xA5                  sync byte
+//      length                bytes from header up to the CRC
+//      header                bit 7 = key frame, bits 0..6 = sequence number
+//      mask                  varint, bit per field, delta frames only
+//      values                varint per field (key frame) or per changed field (delta)
+//      crc                   CRC-8 (poly 0x07) over length .. values
+//
+//  A receiver that misses a frame ignores the deltas up to the next key frame.
+//
+
+#ifndef ChassisTelemetry_h
+#define ChassisTelemetry_h
+
+#include <stdint.h>
+
+#define TELEMETRY_SYNC            0xA5
+#define TELEMETRY_KEY_INTERVAL    20        // frames, a key frame at least once a second at 20 Hz
+#define TELEMETRY_MAX_FRAME       56        // sync, length, header, 2 mask and 10 x 5 value bytes, crc
+
+#define TELEMETRY_STATUS_MANUAL   0x10      // bits 0..3 of the status field are the lights
+#define TELEMETRY_STATUS_BUSY     0x20
+
+//
+// fields in frame order, the ones changing while driving come first to keep the mask short
+//
+enum ChassisTelemetryField : uint8_t
+{
+    TELEMETRY_PULSES = 0,                   // 4 x encoder pulse totals, wrapping at 16 bits
+    TELEMETRY_DISTANCE = 4,                 // mm, average of the wheels
+    TELEMETRY_STATUS,                       // light bits and TELEMETRY_STATUS_ flags
+    TELEMETRY_SPEEDS,                       // 4 x measured wheel speeds, mm/s
+    NUM_TELEMETRY_FIELDS = TELEMETRY_SPEEDS + 4
+};
+
+struct ChassisTelemetry
+{
+    int32_t values[NUM_TELEMETRY_FIELDS];
+};
+
+class ChassisTelemetryEncoder
+{
+  public:
+    ChassisTelemetryEncoder(void);
+
+    uint8_t encode(const ChassisTelemetry &state, uint8_t frame[TELEMETRY_MAX_FRAME]);   // frame length
+    void reset();                           // the next frame is a key frame
+
+  private:
+    ChassisTelemetry last;
+    uint8_t          sequence;
+    uint8_t          sinceKeyFrame;
+};
+
+class ChassisTelemetryDecoder
+{
+  public:
+    ChassisTelemetryDecoder(void);
+
+    // false for a corrupt frame or a delta without the frame before it, state is kept then
+    bool decode(const uint8_t *frame, uint8_t length, ChassisTelemetry &state);
+
+  private:
+    ChassisTelemetry last;
+    uint8_t          sequence;
+    bool             synced;
+};
+
+uint8_t chassisCrc8(const uint8_t *data, uint8_t length, uint8_t crc = 0);
+
+#endif /* ChassisTelemetry_h */
@@ -0,0 +1,97 @@
+//
+//  ChassisTokenizer.h
+//
+//
+//  Zero allocation tokenizer for the Chassis configuration and command files.
+//
+//  The tokenizer works in place on a caller supplied char buffer and splits it
+//  into statements of the form
+//
+//      KEY = VALUE;              scalar value (number or word)
+//      KEY = {a, b, c};          array, may be nested: {{4,31,32}, {5,24,30}}
+//      KEY = (x, y, z, w)        tuple
+//      KEY                       key only, e.g. FULLSTOP or <MOVEMENT>
+//
+//  in a single pass. Keys, values and items are returned as views into the
+//  buffer, nothing is copied and nothing is allocated.
+//
+
+#ifndef ChassisTokenizer_h
+#define ChassisTokenizer_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define MAX_STATEMENT_ITEMS       16        // leaf items of an array or tuple
+#define MAX_STATEMENT_LENGTH      96        // longest statement read from a file
+
+//
+// a view into the tokenizer buffer, not zero terminated
+//
+struct ChassisText
+{
+    const char *text;
+    uint8_t     length;
+};
+
+enum ChassisValueType : uint8_t
+{
+    VALUE_NONE = 0,     // key only
+    VALUE_SCALAR,       // KEY = VALUE
+    VALUE_ARRAY,        // KEY = {...}
+    VALUE_TUPLE         // KEY = (...)
+};
+
+enum ChassisParseResult : uint8_t
+{
+    PARSE_OK = 0,       // statement returned
+    PARSE_END,          // no more statements in the buffer
+    PARSE_ERROR         // malformed statement, skipped up to its terminator
+};
+
+struct ChassisStatement
+{
+    ChassisText      key;
+    ChassisText      value;                       // complete value text, brackets included
+    ChassisValueType valueType;
+    uint8_t          numItems;                    // leaf items, nested arrays are flattened
+    uint8_t          numGroups;                   // inner groups of a nested array, 0 when flat
+    ChassisText      items[MAX_STATEMENT_ITEMS];
+    uint16_t         line;                        // line the statement starts on
+};
+
+class ChassisTokenizer
+{
+  public:
+    // terminator is ';' for configuration files and '\n' for command files
+    ChassisTokenizer(const char *buffer, size_t length, char terminator);
+
+    ChassisParseResult next(ChassisStatement &statement);
+    const char *getError();         // PROGMEM, NULL when there was no error
+    size_t getPosition();
+
+  private:
+    const char *buffer;
+    size_t      length;
+    size_t      pos;
+    char        terminator;
+    uint16_t    line;
+    const char *error;
+
+    bool isTerminator(char c);
+    bool isSpace(char c);
+    void skipSpaces();
+    void skipStatement();
+    bool parseGroup(ChassisStatement &statement, char closing, uint8_t depth);
+    ChassisParseResult fail(const char *message);
+};
+
+//
+// helpers working on text views
+//
+bool chassisTextEquals(const ChassisText &text, const char *value);  // case insensitive
+bool chassisTextToInt(const ChassisText &text, long &value);
+bool chassisTextToSwitch(const ChassisText &text, bool &value);      // ON / OFF
+uint8_t chassisTextCopy(const ChassisText &text, char *target, uint8_t size);
+
+#endif /* ChassisTokenizer_h */
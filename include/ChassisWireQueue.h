@@ -0,0 +1,75 @@
+//
+//  ChassisWireQueue.h
+//
+//
+//  Fixed size ring buffer of output messages for the I2C link.
+//
+//  writeToOutput() only copies a message into the queue, the frames go out on the bus
+//  later, one at a time. Every message is cut into frames of at most 30 bytes, each
+//  preceded by two framing bytes:
+//
+//      6 8   the only frame of a message
+//      6 7   first frame, more follow
+//      7 7   middle frame
+//      7 8   last frame
+//
+//  A message that does not fit in the free space is dropped as a whole and counted, so
+//  the receiving end never sees a message with frames missing. A message being written
+//  with append() is not visible to peekFrame() until endMessage().
+//
+//  A message longer than WIRE_MAX_MESSAGE never fits, not even in an empty queue. It is
+//  counted apart as oversized, so it can be told from a drop on a busy queue.
+//
+
+#ifndef ChassisWireQueue_h
+#define ChassisWireQueue_h
+
+#include <stdint.h>
+
+#define WIRE_QUEUE_SIZE           192       // bytes of queued output, 2 bytes per message are used for its length
+#define WIRE_MAX_MESSAGE          (WIRE_QUEUE_SIZE - 2)     // longest message the queue can hold
+#define WIRE_FRAME_DATA           30        // message bytes per frame
+#define WIRE_FRAME_SIZE           (WIRE_FRAME_DATA + 2)
+
+#define WIRE_FRAME_START          6
+#define WIRE_FRAME_CONTINUE       7
+#define WIRE_FRAME_STOP           8
+
+class ChassisWireQueue
+{
+  public:
+    ChassisWireQueue(void);
+
+    bool push(const char *text, uint16_t length);   // whole message or nothing
+
+    // or write a message byte by byte, it is queued by endMessage()
+    void beginMessage();
+    void append(uint8_t c);
+    bool endMessage();                               // false when it did not fit and was dropped
+    uint8_t peekFrame(uint8_t frame[WIRE_FRAME_SIZE]);   // next frame and its length, 0 when empty
+    void popFrame();                                 // the frame from peekFrame() has been sent
+    void clear();
+
+    bool isEmpty();
+    uint16_t getQueued();                            // bytes waiting, including the lengths
+    uint16_t getDropped();                           // messages dropped, including the oversized ones
+    uint16_t getOversized();                         // messages longer than WIRE_MAX_MESSAGE
+
+  private:
+    uint8_t  buffer[WIRE_QUEUE_SIZE];
+    uint16_t head    = 0;     // next byte written
+    uint16_t tail    = 0;     // length of the oldest message
+    uint16_t used    = 0;
+    uint16_t sent    = 0;     // bytes of the oldest message already framed
+    uint16_t dropped   = 0;
+    uint16_t oversized = 0;
+
+    uint16_t messageStart  = 0;     // position of the length of the message being written
+    uint16_t messageLength = 0;     // counted on after the message ran full
+    bool     messageFull   = false;
+
+    uint8_t byteAt(uint16_t offset);
+    uint16_t frameData(uint16_t length);
+};
+
+#endif /* ChassisWireQueue_h */
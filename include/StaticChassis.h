@@ -0,0 +1,433 @@
+//
+//  StaticChassis.h
+//
+//
+//  Compile-time wired front end for the chassis.
+//
+//  Where the Chassis class keeps its pin numbers in runtime arrays (so they can be read
+//  from CONF.TXT), StaticChassis takes them from a wiring struct at compile time:
+//
+//      struct MyWiring
+//      {
+//          static constexpr uint8_t wheels[4][NUM_WHEEL_PINS] = {
+//              {4, 31, 32}, {5, 24, 30}, {6, 38, 39}, {7, 27, 28}   // pwm, in2/in4, in1/in3
+//          };
+//          static constexpr uint8_t lights[NUM_LIGHT_PINS] = {42, 43, 44, 45};
+//          static constexpr uint8_t encoders[4] = {18, 19, 2, 3};   // optional, see beginEncoders()
+//      };
+//
+//      StaticChassis<MyWiring> chassis;                    // skid steering
+//      StaticChassis<MyWiring, MecanumDrive> chassis;      // mecanum wheels
+//
+//  The number of wheels is the number of rows in wheels, front to back in left/right
+//  pairs, and the drive (see ChassisKinematics.h) maps drive(vx, vy, omega) onto them.
+//  2, 4 and 6 wheel skid steering and 4 wheel mecanum are supported. Every loop over the
+//  wheels unrolls at compile time, and so does the interrupt handler of every encoder.
+//
+//  Every pin resolves to a fixed port register and bit, so on the ATmega2560 a
+//  direction or light change compiles to a single sbi/cbi (or an atomic
+//  read-modify-write for the ports above 0x5F). Unknown pins, non PWM speed pins and
+//  pins used twice are rejected by static_assert. No pin numbers are kept in SRAM.
+//
+
+#ifndef StaticChassis_h
+#define StaticChassis_h
+
+#include "Chassis.h"
+#include "ChassisKinematics.h"
+
+#include <util/atomic.h>
+
+#define MEGA_NUM_PINS             70
+
+//
+// ATmega2560 pin layout as used by the Arduino Mega core, indexed by Arduino pin number
+//
+namespace MegaPins
+{
+    constexpr char port(uint8_t pin)
+    {
+        return "EEEEGEHHHHBBBBJJHHDDDDAAAAAAAACCCCCCCCDGGGLLLLLLLLBBBBFFFFFFFFKKKKKKKK"[pin];
+    }
+
+    constexpr uint8_t bit(uint8_t pin)
+    {
+        return "0145533456456710103210012345677654321072107654321032100123456701234567"[pin] - '0';
+    }
+
+    // data space address of the PORTx register, DDRx sits one below it
+    constexpr uint16_t portAddress(char port)
+    {
+        return (port == 'A') ? 0x22  : (port == 'B') ? 0x25  : (port == 'C') ? 0x28  :
+               (port == 'D') ? 0x2B  : (port == 'E') ? 0x2E  : (port == 'F') ? 0x31  :
+               (port == 'G') ? 0x34  : (port == 'H') ? 0x102 : (port == 'J') ? 0x105 :
+               (port == 'K') ? 0x108 : 0x10B;
+    }
+
+    constexpr bool isPWM(uint8_t pin)
+    {
+        return ((pin >= 2) && (pin <= 13)) || ((pin >= 44) && (pin <= 46));
+    }
+
+    // pins with an external interrupt
+    constexpr bool isInterrupt(uint8_t pin)
+    {
+        return (pin == 2) || (pin == 3) || ((pin >= 18) && (pin <= 21));
+    }
+}
+
+//
+// a single output pin resolved at compile time
+//
+template <uint8_t Pin>
+struct StaticPin
+{
+    static_assert(Pin < MEGA_NUM_PINS, "pin does not exist on the ATmega2560");
+
+    static constexpr uint16_t address = MegaPins::portAddress(MegaPins::port(Pin));
+    static constexpr uint8_t  mask    = 1 << MegaPins::bit(Pin);
+
+    static inline void output()
+    {
+        pinMode(Pin, OUTPUT);
+    }
+
+    static inline void write(bool value)
+    {
+#if defined(__AVR_ATmega2560__)
+        volatile uint8_t &port = *(volatile uint8_t *) address;
+
+        if (address < 0x40)
+        {
+            // low I/O space, compiles to a single sbi / cbi
+            if (value) port |= mask; else port &= ~mask;
+        }
+        else
+        {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                if (value) port |= mask; else port &= ~mask;
+            }
+        }
+#else
+        digitalWrite(Pin, value ? HIGH : LOW);
+#endif
+    }
+};
+
+//
+// compile time checks on a wiring struct
+//
+namespace StaticWiring
+{
+    template <class Wiring>
+    constexpr uint8_t numWheels()
+    {
+        return sizeof(Wiring::wheels) / sizeof(Wiring::wheels[0]);
+    }
+
+    template <class Wiring>
+    constexpr uint8_t numPins()
+    {
+        return (numWheels<Wiring>() * NUM_WHEEL_PINS) + NUM_LIGHT_PINS;
+    }
+
+    // all pins of the wiring in one list: wheel pins first, then the lights
+    template <class Wiring>
+    constexpr uint8_t pin(uint8_t index)
+    {
+        return (index < (numWheels<Wiring>() * NUM_WHEEL_PINS)) ?
+                   Wiring::wheels[index / NUM_WHEEL_PINS][index % NUM_WHEEL_PINS] :
+                   Wiring::lights[index - (numWheels<Wiring>() * NUM_WHEEL_PINS)];
+    }
+
+    template <class Wiring>
+    constexpr bool pinUnique(uint8_t index, uint8_t other)
+    {
+        return (other >= numPins<Wiring>()) ? true :
+               ((other != index) && (pin<Wiring>(other) == pin<Wiring>(index))) ? false :
+               pinUnique<Wiring>(index, other + 1);
+    }
+
+    template <class Wiring>
+    constexpr bool pinsUnique(uint8_t index = 0)
+    {
+        return (index >= numPins<Wiring>()) ? true : (pinUnique<Wiring>(index, 0) && pinsUnique<Wiring>(index + 1));
+    }
+
+    template <class Wiring>
+    constexpr bool pinsExist(uint8_t index = 0)
+    {
+        return (index >= numPins<Wiring>()) ? true : ((pin<Wiring>(index) < MEGA_NUM_PINS) && pinsExist<Wiring>(index + 1));
+    }
+
+    template <class Wiring>
+    constexpr bool speedPinsPWM(uint8_t wheel = 0)
+    {
+        return (wheel >= numWheels<Wiring>()) ? true : (MegaPins::isPWM(Wiring::wheels[wheel][0]) && speedPinsPWM<Wiring>(wheel + 1));
+    }
+
+    template <class Wiring>
+    constexpr bool encoderPinsInterrupt(uint8_t wheel = 0)
+    {
+        return (wheel >= numWheels<Wiring>()) ? true : (MegaPins::isInterrupt(Wiring::encoders[wheel]) && encoderPinsInterrupt<Wiring>(wheel + 1));
+    }
+}
+
+//
+// one wheel: PWM speed pin and two direction pins
+//
+template <class Wiring, uint8_t Wheel>
+struct StaticWheel
+{
+    typedef StaticPin<Wiring::wheels[Wheel][1]> Forward;
+    typedef StaticPin<Wiring::wheels[Wheel][2]> Backward;
+
+    static inline void output()
+    {
+        pinMode(Wiring::wheels[Wheel][0], OUTPUT);
+        Forward::output();
+        Backward::output();
+    }
+
+    static inline void move(int movement, int &speedStatus)
+    {
+        int speed = abs(movement);
+        if (speed > MAX_WHEEL_SPEED) {speed = MAX_WHEEL_SPEED;}
+
+        if (speed != speedStatus)
+            analogWrite(Wiring::wheels[Wheel][0], speed);
+
+        Forward::write(movement > 0);
+        Backward::write(movement < 0);
+        speedStatus = speed;
+    }
+};
+
+//
+// encoder of a wheel, the interrupt handler is generated per wheel
+//
+template <class Wiring, uint8_t Wheel>
+struct StaticEncoder
+{
+    static volatile uint16_t pulses;     // free running, wraps
+
+    static void count()
+    {
+        pulses++;
+    }
+};
+
+template <class Wiring, uint8_t Wheel>
+volatile uint16_t StaticEncoder<Wiring, Wheel>::pulses = 0;
+
+//
+// loops over the wheels and lights, unrolled at compile time
+//
+template <class Wiring, uint8_t Wheel, bool End = (Wheel >= StaticWiring::numWheels<Wiring>())>
+struct StaticWheels
+{
+    static inline void output()
+    {
+        StaticWheel<Wiring, Wheel>::output();
+        StaticWheels<Wiring, Wheel + 1>::output();
+    }
+
+    static inline void move(const int movements[], int speedStatus[])
+    {
+        StaticWheel<Wiring, Wheel>::move(movements[Wheel], speedStatus[Wheel]);
+        StaticWheels<Wiring, Wheel + 1>::move(movements, speedStatus);
+    }
+
+    static inline void attachEncoders()
+    {
+        attachInterrupt(digitalPinToInterrupt(Wiring::encoders[Wheel]), StaticEncoder<Wiring, Wheel>::count, PULSE_DETECTION);
+        StaticWheels<Wiring, Wheel + 1>::attachEncoders();
+    }
+
+    static inline uint16_t readEncoder(uint8_t wheel)
+    {
+        return (wheel == Wheel) ? StaticEncoder<Wiring, Wheel>::pulses : StaticWheels<Wiring, Wheel + 1>::readEncoder(wheel);
+    }
+};
+
+template <class Wiring, uint8_t Wheel>
+struct StaticWheels<Wiring, Wheel, true>
+{
+    static inline void output() {}
+    static inline void move(const int *, int *) {}
+    static inline void attachEncoders() {}
+    static inline uint16_t readEncoder(uint8_t) { return 0; }
+};
+
+template <class Wiring, uint8_t Light>
+struct StaticLights
+{
+    static inline void output()
+    {
+        StaticPin<Wiring::lights[Light]>::output();
+        StaticLights<Wiring, Light + 1>::output();
+    }
+
+    static inline void write(const bool lights[])
+    {
+        StaticPin<Wiring::lights[Light]>::write(lights[Light]);
+        StaticLights<Wiring, Light + 1>::write(lights);
+    }
+};
+
+template <class Wiring>
+struct StaticLights<Wiring, NUM_LIGHT_PINS>
+{
+    static inline void output() {}
+    static inline void write(const bool *) {}
+};
+
+//
+// StaticChassis class definition
+//
+template <class Wiring, class Drive = SkidDrive>
+class StaticChassis
+{
+  public:
+    static constexpr uint8_t numWheels = StaticWiring::numWheels<Wiring>();
+
+  private:
+    static_assert(Drive::supports(numWheels), "the drive does not support this number of wheels");
+    static_assert(StaticWiring::pinsExist<Wiring>(), "wiring uses a pin that does not exist on the ATmega2560");
+    static_assert(StaticWiring::pinsUnique<Wiring>(), "wiring uses the same pin twice");
+    static_assert(StaticWiring::speedPinsPWM<Wiring>(), "wheel speed pins must be PWM capable (2..13, 44..46)");
+
+  public:
+    StaticChassis()
+    {
+        for (uint8_t wheel=0; wheel < numWheels; wheel++)
+            wheelSpeedStatus[wheel] = -1;   // -1 forces the first PWM write
+    }
+
+    // set all pins to output, call from setup()
+    void begin()
+    {
+        StaticWheels<Wiring, 0>::output();
+        StaticLights<Wiring, 0>::output();
+        doFullStop();
+    }
+
+    // movement functions, same conventions as Chassis
+    void moveWheels(const int movements[numWheels])
+    {
+        long sides[2] = {0, 0};   // sum of the left and the right wheels
+
+        StaticWheels<Wiring, 0>::move(movements, wheelSpeedStatus);
+
+        if (!lightsOverride)
+        {
+            bool lights[NUM_LIGHT_PINS];
+
+            for (uint8_t wheel=0; wheel < numWheels; wheel++)
+                sides[wheel & 1] += movements[wheel];
+
+            chassisMovementLights(sides[0], sides[1], lights);
+            switchLightsOn(lights);
+        }
+    }
+
+    //
+    // move the chassis: vx forward, vy to the left (holonomic drives only) and omega counter
+    // clockwise, all on the PWM scale. When a wheel would exceed full speed all wheels are
+    // scaled down together, so the direction of the movement is kept
+    //
+    void drive(int vx, int vy, int omega)
+    {
+        int  movements[numWheels];
+        long largest = MAX_WHEEL_SPEED;
+
+        for (uint8_t wheel=0; wheel < numWheels; wheel++)
+        {
+            movements[wheel] = Drive::wheelSpeed(wheel, vx, vy, omega);
+            if (abs(movements[wheel]) > largest) largest = abs(movements[wheel]);
+        }
+
+        if (largest > MAX_WHEEL_SPEED)
+        {
+            for (uint8_t wheel=0; wheel < numWheels; wheel++)
+                movements[wheel] = ((long) movements[wheel] * MAX_WHEEL_SPEED) / largest;
+        }
+
+        moveWheels(movements);
+    }
+
+    void moveForward(int speed)
+    {
+        drive(constrain(abs(speed), 0, MAX_WHEEL_SPEED), 0, 0);
+    }
+
+    void moveBackwards(int speed)
+    {
+        drive(-constrain(abs(speed), 0, MAX_WHEEL_SPEED), 0, 0);
+    }
+
+    // > 0 moves to the left
+    void moveSideways(int speed)
+    {
+        static_assert(Drive::holonomic, "the drive cannot move sideways");
+
+        drive(0, constrain(speed, MIN_WHEEL_SPEED, MAX_WHEEL_SPEED), 0);
+    }
+
+    void doFullStop()
+    {
+        drive(0, 0, 0);
+    }
+
+    int getWheelSpeed(int wheel)
+    {
+        return ((wheel < 0) || (wheel >= numWheels)) ? 0 : wheelSpeedStatus[wheel];
+    }
+
+    //
+    // attach the generated interrupt handlers to the pins of Wiring::encoders, only
+    // available when the wiring has them
+    //
+    void beginEncoders()
+    {
+        static_assert(StaticWiring::encoderPinsInterrupt<Wiring>(), "encoder pins must have an external interrupt (2, 3, 18..21)");
+
+        StaticWheels<Wiring, 0>::attachEncoders();
+    }
+
+    // free running pulse count of a wheel, the difference of two reads is the pulses in between
+    uint16_t getPulses(uint8_t wheel)
+    {
+        uint16_t pulses;
+
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            pulses = StaticWheels<Wiring, 0>::readEncoder(wheel);
+        }
+
+        return pulses;
+    }
+
+    // light functions
+    void switchLightsOn(const bool lights[NUM_LIGHT_PINS])
+    {
+        if (lightsEnabled)
+            StaticLights<Wiring, 0>::write(lights);
+    }
+
+    void setLights(bool setting)         { lightsEnabled = setting; }
+    void setLightsOverride(bool setting) { lightsOverride = setting; }
+    bool areLightsEnabled()              { return lightsEnabled; }
+    bool isLightsOverrideEnabled()       { return lightsOverride; }
+
+  private:
+    int  wheelSpeedStatus[numWheels];
+    bool lightsEnabled  = true;
+    bool lightsOverride = false;
+};
+
+template <class Wiring, class Drive>
+constexpr uint8_t StaticChassis<Wiring, Drive>::numWheels;
+
+#endif /* StaticChassis_h */
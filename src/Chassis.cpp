@@ -7,6 +7,9 @@
 
 #include "Chassis.h"
 
+#include <EEPROM.h>
+#include <util/atomic.h>
+
 //
 // Constructor with defaults
 //
@@ -14,14 +17,38 @@ Chassis::Chassis()
 {
     lightsEnabled      = false;
     lightsOverride     = false;
-    haveSerial         = false;  // switch off Serial by default
-    haveWire           = false;  // switch off Wire by default
+    chassisLog.setSerial(false); // switch off Serial by default
+    chassisLog.setWire(false);   // switch off Wire by default
     receivingEnd       = 0x08;   // receiving end is default 0x08
     runCycles          = MAX_RUN_CYCLES;
-    configFile         = DEFAULT_CONF_FILE;
-    commandFile        = DEFAULT_COMMAND_FILE;
+    setFileName(configFile, DEFAULT_CONF_FILE);
+    setFileName(commandFile, DEFAULT_COMMAND_FILE);
     cumulativeDistance = 0;
     pinMode(chassisBLE[2], OUTPUT);
+    buildPortTables();
+    setSpeedGains(SPEED_KP, SPEED_KI, SPEED_KD, SPEED_KFF);
+    odometry.setTrackWidth(TRACK_WIDTH);
+    memset(pulseWindow, 0, sizeof(pulseWindow));
+}
+
+//
+// look up the ports of the direction and light pins once, moveWheels and switchLightsOn
+// write them straight to the port registers
+//
+void Chassis::buildPortTables()
+{
+    directionPins.clear();
+    for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+    {
+        directionPins.addPin(chassisWheels[wheel][1]);  // index 2 * wheel
+        directionPins.addPin(chassisWheels[wheel][2]);  // index 2 * wheel + 1
+    }
+
+    lightPins.clear();
+    for (int light=0; light < NUM_LIGHT_PINS; light++)
+        lightPins.addPin(chassisLights[light]);
+
+    pwmSynced = false;
 }
 
 // chassis definition
@@ -64,6 +91,7 @@ bool Chassis::initialiseWheels(int wheelPinSettings[NUM_WHEELS][NUM_WHEEL_PINS])
        wheelSpeedStatus[wheel] = 0;
    }
 
+   buildPortTables();
    success = true;
   }
 
@@ -100,6 +128,8 @@ bool Chassis::initialiseLights(int lightPinSettings[NUM_LIGHT_PINS])
        chassisLights[wheel] = lightPinSettings[wheel];
        lightStatus[wheel] = false;
      }
+
+     buildPortTables();
      
      lightsEnabled = true;
      success = true;
@@ -129,15 +159,19 @@ bool Chassis::initialiseBLE(int blePinSettings[NUM_BLE_PINS])
 // Initialise from file allows for the reading of configuration settings through a config file
 // rather than setting each of the individual items in an init loop.
 //
+// The file is read in blocks (see ChassisReader.h) and every statement is tokenized in place,
+// no Strings are built while parsing.
+//
 // Returns true upon successful parsing of the file
 //         false otherwise
-bool Chassis::initialiseFromFile(String fileName)
+bool Chassis::initialiseFromFile(const char *fileName)
 {
-    bool success = true;
+    bool success   = true;
+    bool cardError = false;       // the card or the file is missing, not broken
     
-  if (fileName.length() == 0)
+  if ((fileName == NULL) || (fileName[0] == '\0'))
   {
-    writeToOutput("Chassis::initialiseFromFile ERROR fileName is empty");
+    LOG_ERROR(F("Chassis::initialiseFromFile ERROR fileName is empty"));
     success = false;
   }
     
@@ -150,81 +184,250 @@ bool Chassis::initialiseFromFile(String fileName)
         confFile = SD.open(fileName);
         if (confFile)
         {
-      int numConfItems = 0;
-      String lineItem = "";
-      String confItems[NUM_CONFIG_ITEMS][2];
+            ChassisConfigRecord record;
+            uint32_t sourceSize     = confFile.size();
+            uint16_t sourceChecksum = configCache ? sourceFileChecksum(confFile) : 0;
 
-      while (confFile.available() && (numConfItems < NUM_CONFIG_ITEMS))
-      {
-        lineItem = confFile.readStringUntil(';');
-        lineItem.trim();
-        lineItem.replace(" ", "");
-
-        if (lineItem.length() == 0) continue;
+            setFileName(configFile, fileName);
 
-        if (DEBUG) Serial.println(lineItem);
+            if (configCache && loadConfigCache(record) && (record.sourceSize == sourceSize) &&
+                (record.sourceChecksum == sourceChecksum) && (strcmp(record.sourceName, fileName) == 0))
+            {
+                // the file did not change since it was cached
+                applyConfig(record);
+            }
+            else
+            {
+                ChassisReader reader(confFile);
 
-        int pos = lineItem.indexOf("=");
-        if (pos <= 0) continue; // malformed
+                success = initialiseFromReader(reader) && success;
 
-        confItems[numConfItems][0] = lineItem.substring(0, pos);
-        confItems[numConfItems][1] = lineItem.substring(pos+1);
-        numConfItems++;
-      }
+                // a file with errors is parsed again next time, so the errors are reported again
+                if (success && configCache) saveConfigCache(fileName, sourceSize, sourceChecksum);
+            }
                       
             confFile.close();
-                
-            //
-            // run through all of the gathered conf items in the CONF.txt file
-            //
-            for (int i=0; i < numConfItems; i++)
-            {
-                //
-                // for each found item, check if we can find a corresponding item in official list
-                //
-                bool found = false;
-                int  pos = 0;
-                while (!found && (pos < NUM_CONFIG_ITEMS))
-                {
-                    if (confItems[i][0].equals(configItemList[pos][0]))
-                    {
-                        configItemList[pos][1] = confItems[i][1];
-                            
-                        found = true;
-                        pos = 0;
-                    }
-
-                    pos++;
-                }
-
-                if (!found)
-                {
-                    writeToOutput("Chassis::initialiseFromFile ERROR CONFIG ITEM " + String(confItems[i][0]) + " not found in the conf items list");
-                    
-                    success = success && false;
-                }
-                else
-                {
-                    success = success && true;
-                }
-            }
-                
-            if (success)
-                setConfValues();
         }
         else
         {
-            writeToOutput("Chassis::initialiseFromFile ERROR cannot open file: " + fileName);
+            LOG_ERROR(F("Chassis::initialiseFromFile ERROR cannot open file: "), fileName);
             
-            success = success && false;
+            success   = success && false;
+            cardError = true;
         }
     }
-    else
-        writeToOutput("Chassis::initialiseFromFile ERROR cannot initialise SD card");
+    else if ((fileName != NULL) && (fileName[0] != '\0'))
+    {
+        LOG_ERROR(F("Chassis::initialiseFromFile ERROR cannot initialise SD card"));
+
+        cardError = true;
+    }
+
+    //
+    // without a card or the file the chassis can still boot from the cached configuration,
+    // a file with errors is reported and leaves the cache as it is
+    //
+    if (cardError && configCache)
+    {
+        success = initialiseFromCache();
+
+        if (success) LOG_WARNING(F("Chassis::initialiseFromFile using the cached configuration of "), configFile);
+    }
         
     return success;
  }
 
+bool Chassis::initialiseFromFile(const String &fileName)
+{
+    return initialiseFromFile(fileName.c_str());
+}
+
+//
+// configuration cache
+//
+// with the cache switched on initialiseFromFile() stores the configuration it parsed in EEPROM,
+// with the size and checksum of the file. As long as the file stays the same it is not parsed
+// again, and when the card or the file is missing the cached configuration is used instead
+//
+void Chassis::setConfigCache(bool setting)
+{
+    configCache = setting;
+}
+
+//
+// apply the cached configuration without touching the SD card, e.g. for a fast boot
+//
+// returns false when EEPROM holds no valid configuration
+//
+bool Chassis::initialiseFromCache()
+{
+    ChassisConfigRecord record;
+
+    if (!loadConfigCache(record)) return false;
+
+    setFileName(configFile, record.sourceName);
+    applyConfig(record);
+
+    return true;
+}
+
+static_assert(sizeof(ChassisConfigRecord) < 256, "the cache record is read with an 8 bit index");
+
+//
+// read the record, true when its magic, version and CRC are right
+//
+bool Chassis::loadConfigCache(ChassisConfigRecord &record)
+{
+    uint8_t *bytes = (uint8_t *) &record;
+
+    for (uint8_t i=0; i < sizeof(record); i++)
+        bytes[i] = EEPROM.read(CONFIG_CACHE_ADDRESS + i);
+
+    // a terminated name is part of what the CRC vouches for, checked anyway before it is used
+    return (record.magic == CONFIG_CACHE_MAGIC) && (record.version == CONFIG_CACHE_VERSION) &&
+           (chassisCrc8(bytes, offsetof(ChassisConfigRecord, crc)) == record.crc) &&
+           (memchr(record.sourceName, '\0', MAX_FILE_NAME_LENGTH) != NULL) &&
+           (memchr(record.commandFile, '\0', MAX_FILE_NAME_LENGTH) != NULL);
+}
+
+//
+// store the current configuration, only the bytes that changed are written to spare the EEPROM
+//
+void Chassis::saveConfigCache(const char *fileName, uint32_t sourceSize, uint16_t sourceChecksum)
+{
+    ChassisConfigRecord record;
+    const uint8_t      *bytes = (const uint8_t *) &record;
+
+    memset(&record, 0, sizeof(record));
+
+    record.magic          = CONFIG_CACHE_MAGIC;
+    record.version        = CONFIG_CACHE_VERSION;
+    record.sourceSize     = sourceSize;
+    record.sourceChecksum = sourceChecksum;
+    strncpy(record.sourceName, fileName, MAX_FILE_NAME_LENGTH - 1);
+
+    record.flags = (lightsEnabled  ? CONFIG_FLAG_LIGHTS : 0) |
+                   (lightsOverride ? CONFIG_FLAG_OVERRIDE : 0) |
+                   (speedControl   ? CONFIG_FLAG_SPEED_CONTROL : 0);
+
+    for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+    {
+        for (int pin=0; pin < NUM_WHEEL_PINS; pin++)
+            record.wheelPins[wheel][pin] = chassisWheels[wheel][pin];
+
+        record.circumferences[wheel] = wheelDistances[wheel].getCircumference();
+        record.pulsesPerTurn[wheel]  = wheelDistances[wheel].getPulsesPerTurn();
+    }
+
+    for (int light=0; light < NUM_LIGHT_PINS; light++)
+        record.lightPins[light] = chassisLights[light];
+
+    for (int i=0; i < NUM_BLE_PINS; i++)
+        record.blePins[i] = chassisBLE[i];
+
+    for (int i=0; i < 4; i++)
+        record.speedGains[i] = speedGains[i];
+
+    for (int i=0; i < 3; i++)
+        record.profile[i] = profileSettings[i];
+
+    record.runCycles  = runCycles;
+    record.trackWidth = odometry.getTrackWidth();
+    strcpy(record.commandFile, commandFile);
+    record.crc = chassisCrc8(bytes, offsetof(ChassisConfigRecord, crc));
+
+    for (uint8_t i=0; i < sizeof(record); i++)
+        EEPROM.update(CONFIG_CACHE_ADDRESS + i, bytes[i]);
+}
+
+//
+// set the chassis up from a cached record, through the same functions the configuration file uses
+//
+void Chassis::applyConfig(const ChassisConfigRecord &record)
+{
+    int wheelPins[NUM_WHEELS][NUM_WHEEL_PINS];
+    int lightPins[NUM_LIGHT_PINS];
+    int blePins[NUM_BLE_PINS];
+
+    for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+        for (int pin=0; pin < NUM_WHEEL_PINS; pin++)
+            wheelPins[wheel][pin] = record.wheelPins[wheel][pin];
+
+    for (int light=0; light < NUM_LIGHT_PINS; light++)
+        lightPins[light] = record.lightPins[light];
+
+    for (int i=0; i < NUM_BLE_PINS; i++)
+        blePins[i] = record.blePins[i];
+
+    initialiseWheels(wheelPins);
+    initialiseLights(lightPins);
+    initialiseBLE(blePins);
+
+    lightsEnabled  = record.flags & CONFIG_FLAG_LIGHTS;
+    lightsOverride = record.flags & CONFIG_FLAG_OVERRIDE;
+    runCycles      = record.runCycles;
+    setFileName(commandFile, record.commandFile);
+
+    setSpeedControl(record.flags & CONFIG_FLAG_SPEED_CONTROL);
+    setSpeedGains(record.speedGains[0], record.speedGains[1], record.speedGains[2], record.speedGains[3]);
+    setTrackWidth(record.trackWidth);
+    setMotionProfile(record.profile[0], record.profile[1], record.profile[2]);
+
+    for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+        setWheelCalibration(wheel, record.circumferences[wheel], record.pulsesPerTurn[wheel]);
+}
+
+//
+// read the configuration statements from a Stream, Serial or text in memory
+//
+// Returns true upon successful parsing of all statements
+//         false otherwise
+bool Chassis::initialiseFromStream(Stream &source)
+{
+    ChassisReader reader(source);
+
+    return initialiseFromReader(reader);
+}
+
+//
+// parse the statements of a reader, each one is tokenized in the reader buffer without copying
+//
+bool Chassis::initialiseFromReader(ChassisReader &reader)
+{
+    bool        success = true;
+    bool        truncated = false;
+    ChassisText statementText;
+
+    while (reader.next(';', statementText, truncated))
+    {
+        if (truncated)
+        {
+            LOG_ERROR(F("Chassis::initialiseFromFile ERROR statement too long: "), statementText);
+            success = false;
+            continue;
+        }
+
+        ChassisTokenizer   tokenizer(statementText.text, statementText.length, ';');
+        ChassisStatement   statement;
+        ChassisParseResult result = tokenizer.next(statement);
+
+        if (result == PARSE_END) continue;
+
+        if (result == PARSE_ERROR)
+        {
+            LOG_ERROR(F("Chassis::initialiseFromFile ERROR "), LOG_FLASH(tokenizer.getError()), F(" in: "), statementText);
+            success = false;
+            continue;
+        }
+
+        LOG_DEBUG(statementText);
+
+        success = setConfValue(statement) && success;
+    }
+
+    return success;
+}
+
 //
 // set Manual (blootooth/other) controlled mode or automated (reading the guidance file)
 //
@@ -255,8 +458,48 @@ bool Chassis::getManualMode()
 //
 void Chassis::moveWheels(int movements[NUM_WHEELS])
 {
-  int wheelSpeed = 0;
-  int sumOfWheelSpeed = 0;
+  driveWheels(movements, profileTable.getMode() != PROFILE_NONE);
+}
+
+//
+// direct pwm control takes over from moveWheelsAt() and moveDistance(), the values are
+// written at once or become the targets of the wheel ramps
+//
+void Chassis::driveWheels(int movements[NUM_WHEELS], bool ramped)
+{
+  distanceActive = false;
+
+  if (speedTargetsSet)
+  {
+    speedTargetsSet = false;
+    for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+      speedControllers[wheel].setTarget(0);
+  }
+
+  if (ramped)
+  {
+    // a new ramp starts from the pwm the wheels run at now
+    for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+    {
+      if (!rampsActive) wheelRamps[wheel].reset(wheelDirections[wheel] * wheelSpeedStatus[wheel]);
+      wheelRamps[wheel].setTarget(movements[wheel]);
+    }
+
+    rampsActive = true;
+    return;
+  }
+
+  rampsActive = false;
+  writeWheels(movements);
+}
+
+//
+// write the pwm and direction pins of the wheels, shared by moveWheels and the speed controller
+//
+void Chassis::writeWheels(int movements[NUM_WHEELS])
+{
+  int  wheelSpeed = 0;
+  long sides[2] = {0, 0};   // sum of the left and the right wheels
   bool lights[NUM_LIGHT_PINS] = {false, false, false, false};
 
   for (int wheel=0; wheel < NUM_WHEELS; wheel++)
@@ -265,373 +508,895 @@ void Chassis::moveWheels(int movements[NUM_WHEELS])
     wheelSpeed = abs(movements[wheel]);
       if (wheelSpeed > MAX_WHEEL_SPEED) {wheelSpeed = MAX_WHEEL_SPEED;}     // set maximum wheel speed
       
-    analogWrite(chassisWheels[wheel][0], wheelSpeed);
-    digitalWrite(chassisWheels[wheel][1], (movements[wheel] > 0) && HIGH);
-    digitalWrite(chassisWheels[wheel][2], (movements[wheel] < 0) && HIGH);
+    // the speed status is the shadow of the PWM output, only write what changed
+    if (!pwmSynced || (wheelSpeed != wheelSpeedStatus[wheel]))
+      analogWrite(chassisWheels[wheel][0], wheelSpeed);
+
+    directionPins.set(2 * wheel,     movements[wheel] > 0);
+    directionPins.set(2 * wheel + 1, movements[wheel] < 0);
     wheelSpeedStatus[wheel] = wheelSpeed;
+    if (movements[wheel] != 0) wheelDirections[wheel] = (movements[wheel] > 0) ? 1 : -1;
     
-    sumOfWheelSpeed += movements[wheel];
+    sides[wheel & 1] += movements[wheel];
   }
+
+  // all direction pins on a port switch with a single store
+  directionPins.write();
+  pwmSynced = true;
     
   if (!lightsOverride)
   {
-     //
-     // a bit dodgy but for now we look at the two front wheels
-     //
-     if ((movements[0] > 0) && (movements[1] > 0)) {lights[0] = true; lights[1] = true;} // moving forward
-     if ((movements[0] < 0) && (movements[1] < 0)) {lights[2] = true; lights[3] = true;} // moving back
-     if ((movements[0] < 0) && (movements[1] > 0)) {lights[0] = true;}
-     if ((movements[0] > 0) && (movements[1] < 0)) {lights[1] = true;}
-        
+     // the lights follow the movement of the left and right side as a whole
+     chassisMovementLights(sides[0], sides[1], lights);
      switchLightsOn(lights);
-   }
+  }
 }
 
 //
-// return the speed status
+// motion profile
 //
-String Chassis::getWheelSpeedStatus()
+// with a profile moveWheels(), and with it moveForward(), moveBackwards() and doFullStop(), no
+// longer jump to the new pwm values. update() ramps every wheel to them in steps of
+// PROFILE_PERIOD ms within the acceleration (pwm/s) and, for the s-curve, jerk (pwm/s^2)
+// limits. abort() still stops at once
+//
+bool Chassis::setMotionProfile(uint8_t mode, int acceleration, int jerk)
 {
-    String wheelSpeeds = "(";
-    
-    for (int i=0; i < NUM_WHEELS; i++)
+    if ((acceleration < 0) || (jerk < 0) || !profileTable.setLimits(mode, acceleration, jerk, PROFILE_PERIOD))
     {
-        wheelSpeeds += String(wheelSpeedStatus[i]);
-        if (i < (NUM_WHEELS - 1)) wheelSpeeds += ",";
+        LOG_ERROR(F("Chassis::setMotionProfile ERROR invalid profile "), mode);
+
+        return false;
     }
-    wheelSpeeds += ")";
-    
-    return wheelSpeeds;
+
+    profileSettings[0] = mode;
+    profileSettings[1] = acceleration;
+    profileSettings[2] = jerk;
+
+    // without a profile a ramp in progress jumps to its targets
+    if ((mode == PROFILE_NONE) && rampsActive)
+    {
+        int movements[NUM_WHEELS];
+
+        for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+            movements[wheel] = wheelRamps[wheel].getTarget();
+
+        driveWheels(movements, false);
+    }
+
+    return true;
 }
 
-//
-// move the chassis forward
-//
-void Chassis::moveForward(int speed)
+uint8_t Chassis::getMotionProfile()
 {
-  int directions[NUM_WHEELS] = {0, 0, 0, 0};
-    
-  speed = abs(speed);
-  if (speed > 255) {speed = 255;}
-    
-  for (int i=0; i < NUM_WHEELS; i++)
-    directions[i] = speed;
-
-  moveWheels(directions);
+    return profileTable.getMode();
 }
 
 //
-// move the chassis back
+// are the wheels still ramping to the last movement?
 //
-void Chassis::moveBackwards(int speed)
+bool Chassis::isRamping()
 {
-  int directions[NUM_WHEELS] = {0, 0, 0, 0};
-
-  speed = abs(speed);
-  if (speed > 255) {speed = 255;}
- 
-  for (int i=0; i < NUM_WHEELS; i++)
-    directions[i] = -speed;
-    
-  moveWheels(directions);
+    return rampsActive;
 }
 
 //
-// fullStop
+// one ramp step of every wheel, called from update() at a fixed rate
 //
-void Chassis::doFullStop()
+void Chassis::profileTick()
 {
-  int directions[NUM_WHEELS] = {0, 0, 0, 0};
-    
-  moveWheels(directions);
+    int  movements[NUM_WHEELS];
+    bool done = true;
+
+    for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+    {
+        movements[wheel] = wheelRamps[wheel].update(profileTable);
+        done = done && wheelRamps[wheel].isDone();
+    }
+
+    writeWheels(movements);
+    rampsActive = !done;
 }
 
 //
-// rotate around the cental axis. As we have no angle detection yet, the only thing we can do is left or right rotation
+// return the measured wheel speeds in mm/s, negative when a wheel runs backwards
 //
-void Chassis::doRotate(int angle)
+String Chassis::getWheelSpeedStatus()
 {
-    bool rotateLeft = false;
-    int rotation = 0;
-    
-    rotateLeft = (angle < 0);
-    rotation = abs(angle);
-    
-    if (rotation > MAX_ROTATION_ANGLE) {rotation = MAX_ROTATION_ANGLE;}
+    String wheelSpeeds = "(";
     
-    if (rotateLeft)
-    {
-        // we need to rotate left ward
-        int directions[NUM_WHEELS] = {-255, 255, -255, 255};
-        moveWheels(directions);
-    }
-    else
+    for (int i=0; i < NUM_WHEELS; i++)
     {
-        // need to rotate right ward
-        int directions[NUM_WHEELS] = {255, -255, 255, -255};
-        moveWheels(directions);
+        wheelSpeeds += String(measuredSpeeds[i]);
+        if (i < (NUM_WHEELS - 1)) wheelSpeeds += ",";
     }
+    wheelSpeeds += ")";
+    
+    return wheelSpeeds;
 }
 
 //
-// have we enabled the lights?
-bool Chassis::areLightsEnabled()
+// measured speed of a single wheel in mm/s
+//
+int Chassis::getWheelSpeed(int wheel)
 {
-    return lightsEnabled;
+    if ((wheel < 0) || (wheel >= NUM_WHEELS)) return 0;
+
+    return measuredSpeeds[wheel];
 }
 
-bool Chassis::isLightsOverrideEnabled()
+//
+// closed loop speed control
+//
+// with speed control switched on, moveWheelsAt() hands the wheels to a PI(D) controller per
+// wheel which update() steps every SPEED_CONTROL_PERIOD ms. With speed control switched off
+// the targets are converted to pwm once, using the feedforward gain only.
+//
+void Chassis::setSpeedControl(bool setting)
 {
-    return lightsOverride;
+    speedControl = setting;
 }
 
-void Chassis::setLightsOverride(bool setting)
+bool Chassis::isSpeedControlEnabled()
 {
-    lightsOverride = setting;
+    return speedControl;
 }
 
 //
-// switch on the lights
+// Q8 gains, 256 = 1.0. ki and kd are per controller step
 //
-void Chassis::switchLightsOn(bool lights[NUM_LIGHT_PINS])
+void Chassis::setSpeedGains(int kp, int ki, int kd, int kff)
 {
-    if (lightsEnabled)
-        for (int light=0; light < NUM_LIGHT_PINS; light++)
-        {
-            digitalWrite(chassisLights[light], lights[light] && HIGH);
-            lightStatus[light] = lights[light];
-        }
+    speedGains[0] = kp;
+    speedGains[1] = ki;
+    speedGains[2] = kd;
+    speedGains[3] = kff;
+
+    for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+        speedControllers[wheel].setGains(kp, ki, kd, kff);
 }
 
 //
-// enable Lights (default = true)
+// move the wheels at the given speeds in mm/s, < 0 is backward
 //
-void Chassis::setLights(bool setting)
+void Chassis::moveWheelsAt(int speeds[NUM_WHEELS])
 {
-    lightsEnabled = setting;
+    int movements[NUM_WHEELS];
+
+    distanceActive = false;
+    rampsActive    = false;
+
+    for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+        speedControllers[wheel].setTarget(speeds[wheel]);
+
+    // start with the feedforward estimate, the controller corrects from the next step
+    speedsToPwm(speeds, movements);
+
+    speedTargetsSet = speedControl;
+    writeWheels(movements);
 }
 
 //
-// return status of the lights (0000 - 1111 => 0 - 15)
+// feedforward conversion of speeds in mm/s to pwm values
 //
-String Chassis::getLightsStatus()
+void Chassis::speedsToPwm(const int speeds[NUM_WHEELS], int movements[NUM_WHEELS])
 {
-    String returnVal;
-    
-    for (int i=0; i < NUM_LIGHT_PINS; i++)
-        returnVal += (lightStatus[i]?"1":"0");
-    
-    return returnVal;
+    for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+    {
+        long feedForward = ((long) speedGains[3] * speeds[wheel]) >> 8;
+        movements[wheel] = constrain(feedForward, MIN_WHEEL_SPEED, MAX_WHEEL_SPEED);
+    }
 }
 
 //
-// set the number of run cycles
+// one step of the speed controller, called from update() at a fixed rate
 //
-void Chassis::setRunCycles(int setting)
+void Chassis::speedControlTick()
 {
-    // ensure it is between 0 and MAX_RUN_CYCLES
-    if (setting < 0) {runCycles = 0;}
-    if (setting > MAX_RUN_CYCLES) {runCycles = MAX_RUN_CYCLES;}
-    runCycles = setting;
-}
+    measureWheelSpeeds();
 
-void Chassis::setCommandFile(String commandFileName)
-{
-    if (commandFileName == NULL) {commandFileName = DEFAULT_COMMAND_FILE;}
-    commandFile = commandFileName;
-}
+    if (distanceActive) distanceTick();
 
-bool Chassis::setConfValues()
-{
-  bool success = true;
+    // a ramped start of a distance move hands over to the controller once the ramps are done
+    if (!speedTargetsSet || rampsActive) return;
 
-  Serial.println("");
-    
-  for (int i=0; i < NUM_CONFIG_ITEMS; i++)
-  {
-    if (configItemList[i][0].equals("LIGHTS"))
-    {
-      if (DEBUG) Serial.print("Chassis::setConfValue Config LIGHTS set to: ");
-      if (DEBUG) Serial.println(configItemList[i][1] == "ON");
-      lightsEnabled = configItemList[i][1] == "ON";
-      success = success && true;
+    int movements[NUM_WHEELS];
+
+    for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+        movements[wheel] = speedControllers[wheel].update(measuredSpeeds[wheel]);
+
+    writeWheels(movements);
+}
+
+//
+// wheel speeds over the last SPEED_WINDOW steps, from the free running pulse totals. The
+// distance of this step also feeds the dead reckoning
+//
+// the encoders do not tell the direction, the speed takes the sign of the wheel direction
+//
+void Chassis::measureWheelSpeeds()
+{
+    uint16_t totals[NUM_WHEELS];
+    int32_t  distances[NUM_WHEELS];   // Q24.8 mm
+
+    snapshotPulseTotals(totals);
+
+    for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+    {
+        uint16_t delta = totals[wheel] - lastPulseTotals[wheel];   // wraps correctly
+        uint16_t windowPulses = 0;
+
+        distances[wheel] = wheelDistances[wheel].convert(delta);
+        if (wheelDirections[wheel] < 0) distances[wheel] = -distances[wheel];
+
+        lastPulseTotals[wheel] = totals[wheel];
+        pulseWindow[wheel][pulseWindowPos] = (delta > 255) ? 255 : delta;
+
+        for (int i=0; i < SPEED_WINDOW; i++)
+            windowPulses += pulseWindow[wheel][i];
+
+        long speed = wheelDistances[wheel].toSpeed(windowPulses, SPEED_WINDOW * SPEED_CONTROL_PERIOD);
+
+        measuredSpeeds[wheel] = (wheelDirections[wheel] < 0) ? -speed : speed;
     }
 
-    if (configItemList[i][0].equals("LIGHTS_OVERRIDE"))
+    pulseWindowPos = (pulseWindowPos + 1) % SPEED_WINDOW;
+
+    // left side is flw + rlw, right side is frw + rrw
+    odometry.update((distances[0] + distances[2]) / 2, (distances[1] + distances[3]) / 2);
+}
+
+//
+// dead reckoning
+//
+// x and y are Q24.8 mm from where the pose was last reset, heading is a binary angle with
+// 65536 = 360 degrees, counter clockwise. The chassis starts at (0, 0) looking along x
+//
+ChassisPose Chassis::getPose()
+{
+    return odometry.getPose();
+}
+
+void Chassis::resetPose()
+{
+    odometry.reset();
+}
+
+void Chassis::setTrackWidth(int trackWidth)
+{
+    if (trackWidth > 0) odometry.setTrackWidth(trackWidth);
+}
+
+//
+// calibrate a wheel: circumference in 0.01 mm and encoder pulses per turn of the wheel
+//
+// applies to the distance moves, speeds, dead reckoning and doPulseCalculation()
+//
+bool Chassis::setWheelCalibration(int wheel, long circumference, long pulsesPerTurn)
+{
+    if ((wheel < 0) || (wheel >= NUM_WHEELS) || (circumference <= 0) || (circumference > 0xFFFF) ||
+        (pulsesPerTurn <= 0) || (pulsesPerTurn > 0xFFFF))
     {
-      if (DEBUG) Serial.print("Chassis::setConfValue Config LIGHTS_OVERRIDE set to: ");
-      if (DEBUG) Serial.println(configItemList[i][1] == "ON");
-      lightsOverride = configItemList[i][1] == "ON";
-      success = success && true;
+        LOG_ERROR(F("Chassis::setWheelCalibration ERROR invalid calibration for wheel "), wheel);
+
+        return false;
     }
 
-    if (configItemList[i][0].equals("CYCLE"))
+    wheelDistances[wheel].setCalibration(circumference, pulsesPerTurn);
+
+    // doPulseCalculation() may run from a timer interrupt
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
     {
-      if (DEBUG) Serial.print("Chassis::setConfValue Config CYCLE set to: ");
-      if (DEBUG) Serial.println(configItemList[i][1].toInt());
-      runCycles = configItemList[i][1].toInt();
-      success = success && true;
+        pulseConverters[wheel].setCalibration(circumference, pulsesPerTurn);
     }
 
-    if (configItemList[i][0].equals("MOVEMENTS"))
+    return true;
+}
+
+//
+// distance moves
+//
+// the distance is counted per wheel in encoder pulses. Each wheel slows down when it gets
+// near its target and stops on its own target, the overshoot of every move is used to stop
+// the next move a little earlier. The achieved distance ends up in cumulativeDistance.
+//
+// move all wheels the distance in mm at speed in mm/s, a negative distance moves backward
+//
+// returns false when there is nothing to move
+//
+bool Chassis::moveDistance(long distance, int speed)
+{
+    int direction = (distance < 0) ? -1 : 1;
+    int speeds[NUM_WHEELS];
+
+    speed = abs(speed);
+    for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+        speeds[wheel] = direction * speed;
+
+    return startDistance(abs(distance), speeds);
+}
+
+//
+// keep the current movement going for the distance in mm, e.g. after moveForward()
+//
+bool Chassis::moveDistance(long distance)
+{
+    int speeds[NUM_WHEELS];
+
+    for (int wheel=0; wheel < NUM_WHEELS; wheel++)
     {
-      if (DEBUG) Serial.print("Chassis::setConfValue Config MOVEMENTS set to: ");
-      if (DEBUG) Serial.println(configItemList[i][1]);
-      commandFile = configItemList[i][1];
-      success = success && true;
+        // a ramp still on its way counts as the movement it ramps to
+        long pwm = rampsActive ? wheelRamps[wheel].getTarget() : (long) wheelDirections[wheel] * wheelSpeedStatus[wheel];
+
+        if (speedTargetsSet)
+            speeds[wheel] = speedControllers[wheel].getTarget();
+        else if (speedGains[3] > 0)
+            speeds[wheel] = (pwm * 256L) / speedGains[3];
+        else
+            speeds[wheel] = 0;
     }
 
-    if (configItemList[i][0].equals("BLE_PINS"))
+    return startDistance(abs(distance), speeds);
+}
+
+//
+// is a moveDistance() in progress?
+//
+bool Chassis::isMoving()
+{
+    return distanceActive;
+}
+
+bool Chassis::startDistance(long distance, int speeds[NUM_WHEELS])
+{
+    uint16_t totals[NUM_WHEELS];
+    bool     moving = false;
+
+    snapshotPulseTotals(totals);
+
+    distanceStopped = 0;
+    for (int wheel=0; wheel < NUM_WHEELS; wheel++)
     {
-      if (DEBUG) Serial.print("Chassis::setConfValue Config BLE_PINS set to: ");
+        distanceStart[wheel]  = totals[wheel];
+        distanceTarget[wheel] = wheelDistances[wheel].toPulses(distance);
+        distanceSpeeds[wheel] = speeds[wheel];
 
-      String value = configItemList[i][1];
-      if ((value[0] != '{') && (value[value.length()] != '}'))
-      {
-        writeToOutput("Chassis::setConfValue BLE_PINS: ERROR value " + String(value) + " is not a valid array");
-        
-        success = success && false;
-      }
-      else
-      {
-        value = value.substring(1, value.length()-1);
+        if ((speeds[wheel] == 0) || (distanceTarget[wheel] == 0))
+        {
+            distanceStopped |= (1 << wheel);
+            distanceSpeeds[wheel] = 0;
+        }
+        else
+            moving = true;
+    }
+
+    if (!moving)
+    {
+        LOG_DEBUG(F("Chassis::moveDistance nothing to move"));
+
+        return false;
+    }
+
+    if (profileTable.getMode() != PROFILE_NONE)
+        rampWheelsAt(distanceSpeeds);
+    else
+        moveWheelsAt(distanceSpeeds);
+
+    cumulativeDistance = 0;
+    distanceSettle     = DISTANCE_SETTLE_STEPS;
+    distanceActive     = true;
+
+    return true;
+}
+
+//
+// start the wheels at the speeds in mm/s through the ramps of the motion profile, from the
+// feedforward pwm of the speeds. With speed control the controller takes over once the ramps
+// are done
+//
+void Chassis::rampWheelsAt(int speeds[NUM_WHEELS])
+{
+    int movements[NUM_WHEELS];
+
+    speedsToPwm(speeds, movements);
+    driveWheels(movements, true);
+
+    for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+        speedControllers[wheel].setTarget(speeds[wheel]);
+
+    speedTargetsSet = speedControl;
+}
+
+//
+// one step of a distance move, called from the speed controller step
+//
+void Chassis::distanceTick()
+{
+    uint16_t totals[NUM_WHEELS];
+    uint16_t travelled[NUM_WHEELS];
+    int      speeds[NUM_WHEELS];
+    long     sumOfDistances = 0;
+    int      numMoving = 0;
+
+    snapshotPulseTotals(totals);
+
+    for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+    {
+        travelled[wheel] = totals[wheel] - distanceStart[wheel];
+        speeds[wheel] = 0;
+
+        if (distanceSpeeds[wheel] == 0) continue;
+
+        numMoving++;
+        sumOfDistances += wheelDistances[wheel].toDistance(travelled[wheel]);
 
-        // we expect 3 elements in the array
-        unsigned int posStart = 0;
-        unsigned int posEnd = 0;
-        // bool found = false;
-        int valueFound = 0;
+        if (distanceStopped & (1 << wheel)) continue;
 
-        while ((posStart < value.length()) && (valueFound < NUM_BLE_PINS))
+        long remaining = (long) distanceTarget[wheel] - coastPulses[wheel] - travelled[wheel];
+
+        if (remaining <= 0)
         {
-          posEnd = value.indexOf(",", posStart);
-          if (posEnd < 0) posEnd = value.length();
-
-          chassisBLE[valueFound] = value.substring(posStart,posEnd).toInt();
-          
-          posStart = posEnd;
-          posStart++;
-
-          if (DEBUG) Serial.print(chassisBLE[valueFound]); 
-          if (DEBUG) Serial.print(" ");
-          
-          valueFound++;
+            distanceStopped |= (1 << wheel);
+            continue;
         }
 
-        success = success && true;
-          
-        if (DEBUG) Serial.println("");
-      }
+        //
+        // ramp down linearly with the distance left, never below the minimum speed
+        //
+        long remainingMm = wheelDistances[wheel].toDistance(remaining);
+        long speed = abs(distanceSpeeds[wheel]);
+
+        if (speed > (remainingMm * DISTANCE_RAMP_RATE)) speed = remainingMm * DISTANCE_RAMP_RATE;
+        if (speed < DISTANCE_MIN_SPEED) speed = min((long) abs(distanceSpeeds[wheel]), (long) DISTANCE_MIN_SPEED);
+
+        speeds[wheel] = (distanceSpeeds[wheel] < 0) ? -speed : speed;
     }
 
-    if (configItemList[i][0].equals("LIGHT_PINS"))
+    cumulativeDistance = (numMoving > 0) ? (sumOfDistances / numMoving) : 0;
+
+    if (distanceStopped != ((1 << NUM_WHEELS) - 1))
     {
-      if (DEBUG) Serial.print("Chassis::setConfValue Config LIGHT_PINS set to: ");
+        //
+        // closed loop only needs the new targets, open loop gets the feedforward pwm. While
+        // the move is still ramping up the ramps take the pwm, a wheel on its target stops at once
+        //
+        int movements[NUM_WHEELS];
 
-      String value = configItemList[i][1];
-      if ((value[0] != '{') && (value[value.length()] != '}'))
-      {
-        writeToOutput("Chassis::setConfValue LIGHT_PINS ERROR value " + String(value) + " is not a valid array");
-          
-        success = success && false;
-      }
-      else
-      {
-        value = value.substring(1, value.length()-1);
+        speedsToPwm(speeds, movements);
 
-        // we expect 4 elements in the array
-        unsigned int posStart = 0;
-        unsigned int posEnd = 0;
-        // bool found = false;
-        int valueFound = 0;
+        if (rampsActive)
+        {
+            for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+            {
+                if (distanceStopped & (1 << wheel)) wheelRamps[wheel].reset(0);
+                else wheelRamps[wheel].setTarget(movements[wheel]);
+            }
+        }
 
-        while ((posStart < value.length()) && (valueFound < NUM_LIGHT_PINS))
+        if (speedControl)
         {
-          posEnd = value.indexOf(",", posStart);
-          if (posEnd < 0) posEnd = value.length();
+            for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+                speedControllers[wheel].setTarget(speeds[wheel]);
 
-          chassisLights[valueFound] = value.substring(posStart,posEnd).toInt();
-          
-          posStart = posEnd;
-          posStart++;
-            
-          if (DEBUG) Serial.print(chassisLights[valueFound]); 
-          if (DEBUG) Serial.print(" ");
-          
-          valueFound++;
+            speedTargetsSet = true;
         }
-          
-        if (success) initialiseLights(chassisLights);
-          
-        success = success && true;
-        
-        if (DEBUG) Serial.println("");
-      }
+        else if (!rampsActive)
+            writeWheels(movements);
+
+        return;
     }
-  }
 
-  return success;
+    //
+    // all wheels stopped, let them coast out before taking the final distance
+    //
+    if (distanceSettle > 0)
+    {
+        // the final stop is not ramped, the wheels are on their targets
+        if (distanceSettle == DISTANCE_SETTLE_STEPS)
+        {
+            int directions[NUM_WHEELS] = {0, 0, 0, 0};
+
+            driveWheels(directions, false);
+        }
+
+        distanceActive = true;   // doFullStop() ends the move, the settling is still part of it
+        distanceSettle--;
+        return;
+    }
+
+    for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+    {
+        if (distanceSpeeds[wheel] == 0) continue;
+
+        // the overshoot of this move moves the stop point of the next one
+        int overshoot = (int) travelled[wheel] - (int) distanceTarget[wheel];
+        coastPulses[wheel] = constrain(coastPulses[wheel] + (overshoot / 2), 0, DISTANCE_MAX_COAST);
+    }
+
+    distanceActive = false;
+
+    LOG_DEBUG(F("Chassis::moveDistance done "), cumulativeDistance);
 }
 
 //
-// dumps all of the settings to Serial. used for debugging purposes
+// move the chassis forward
 //
-void Chassis::dumpSettings()
+void Chassis::moveForward(int speed)
 {
-    String sendText = "";
+  int directions[NUM_WHEELS] = {0, 0, 0, 0};
+    
+  speed = abs(speed);
+  if (speed > 255) {speed = 255;}
+    
+  for (int i=0; i < NUM_WHEELS; i++)
+    directions[i] = speed;
+
+  moveWheels(directions);
+}
+
+//
+// move the chassis back
+//
+void Chassis::moveBackwards(int speed)
+{
+  int directions[NUM_WHEELS] = {0, 0, 0, 0};
+
+  speed = abs(speed);
+  if (speed > 255) {speed = 255;}
+ 
+  for (int i=0; i < NUM_WHEELS; i++)
+    directions[i] = -speed;
+    
+  moveWheels(directions);
+}
 
-    writeToOutput("Dumping current configured settings");
+//
+// fullStop
+//
+void Chassis::doFullStop()
+{
+  int directions[NUM_WHEELS] = {0, 0, 0, 0};
     
-    // dumping wheelpin settings
-    writeToOutput("Dumping wheel pin settings ");
-    for (int i=0; i < NUM_WHEELS; i++)
+  moveWheels(directions);
+}
+
+//
+// rotate on the spot by angle degrees, > 0 turns right (clockwise), < 0 turns left
+//
+// both sides travel the arc of the angle over the track width in opposite directions. The
+// rotation is a distance move: every wheel slows down near its encoder target, stops on it
+// and the wheels settle before isMoving() turns false, all from update()
+//
+// returns false when there is nothing to rotate
+//
+bool Chassis::doRotate(int angle)
+{
+    int direction = (angle < 0) ? -1 : 1;
+    unsigned long rotation = abs(angle);
+    int speeds[NUM_WHEELS];
+
+    if (rotation > MAX_ROTATION_ANGLE) {rotation = MAX_ROTATION_ANGLE;}
+
+    // arc = angle / 360 * pi * track width, with pi as 355 / 113
+    unsigned long arc = ((rotation * odometry.getTrackWidth() * 355UL) + (360UL * 113 / 2)) / (360UL * 113);
+
+    // left side is flw + rlw, right side is frw + rrw
+    speeds[0] = speeds[2] =  direction * ROTATION_SPEED;
+    speeds[1] = speeds[3] = -direction * ROTATION_SPEED;
+
+    return startDistance(arc, speeds);
+}
+
+//
+// have we enabled the lights?
+bool Chassis::areLightsEnabled()
+{
+    return lightsEnabled;
+}
+
+bool Chassis::isLightsOverrideEnabled()
+{
+    return lightsOverride;
+}
+
+void Chassis::setLightsOverride(bool setting)
+{
+    lightsOverride = setting;
+}
+
+//
+// switch on the lights
+//
+void Chassis::switchLightsOn(bool lights[NUM_LIGHT_PINS])
+{
+    if (lightsEnabled)
     {
-       sendText = "   {";
-        for (int j=0; j < NUM_WHEEL_PINS; j++)
+        for (int light=0; light < NUM_LIGHT_PINS; light++)
         {
-            sendText += String(chassisWheels[i][j]);
-            if (j != NUM_WHEEL_PINS-1) sendText += ",";
+            lightPins.set(light, lights[light]);
+            lightStatus[light] = lights[light];
         }
-        sendText += "}";
-        writeToOutput(sendText);
+
+        lightPins.write();
     }
+}
+
+//
+// enable Lights (default = true)
+//
+void Chassis::setLights(bool setting)
+{
+    lightsEnabled = setting;
+}
+
+//
+// return status of the lights (0000 - 1111 => 0 - 15)
+//
+String Chassis::getLightsStatus()
+{
+    String returnVal;
     
+    for (int i=0; i < NUM_LIGHT_PINS; i++)
+        returnVal += (lightStatus[i]?"1":"0");
     
-    // dumping the light settings
-    writeToOutput("Dumping light settings");
+    return returnVal;
+}
 
-    sendText = "   Light pin settings {";
-    for (int i=0; i < NUM_LIGHT_PINS; i++)
+//
+// set the number of run cycles
+//
+void Chassis::setRunCycles(int setting)
+{
+    // ensure it is between 0 and MAX_RUN_CYCLES
+    if (setting < 0) {runCycles = 0;}
+    if (setting > MAX_RUN_CYCLES) {runCycles = MAX_RUN_CYCLES;}
+    runCycles = setting;
+}
+
+//
+// returns false when the name does not fit in MAX_FILE_NAME_LENGTH, the command file is not changed then
+//
+bool Chassis::setCommandFile(const char *commandFileName)
+{
+    if ((commandFileName == NULL) || (commandFileName[0] == '\0')) {commandFileName = DEFAULT_COMMAND_FILE;}
+
+    if (!setFileName(commandFile, commandFileName))
     {
-        sendText += String(chassisLights[i]);
-        if (i != NUM_LIGHT_PINS-1) sendText += (",");
+        LOG_ERROR(F("Chassis::setCommandFile ERROR file name too long: "), commandFileName);
+        return false;
     }
-    sendText += "}";
-    writeToOutput(sendText);
 
-    sendText = "   Lights enabled ";
-    if (lightsEnabled) writeToOutput(sendText + "YES");
-    if (!lightsEnabled) writeToOutput(sendText + "NO");
+    return true;
+}
 
-    sendText = "   Lights override ";
-    if (lightsOverride) writeToOutput(sendText + "YES");
-    if (!lightsOverride) writeToOutput(sendText + "NO");
-    
-    // dumping the BLE settings
-    sendText = "Dumping BLE pin settings {";
-    for (int i=0; i < NUM_BLE_PINS; i++)
+bool Chassis::setCommandFile(const String &commandFileName)
+{
+    return setCommandFile(commandFileName.c_str());
+}
+
+//
+// copy a file name into a fixed size field, a name that does not fit leaves the field unchanged
+//
+bool Chassis::setFileName(char field[MAX_FILE_NAME_LENGTH], const char *fileName)
+{
+    if (strlen(fileName) >= MAX_FILE_NAME_LENGTH) return false;
+
+    strcpy(field, fileName);
+
+    return true;
+}
+
+bool Chassis::setConfValue(const ChassisStatement &statement)
+{
+  bool success = true;
+  int  item = chassisFindConfItem(statement.key);
+
+  if (item < 0)
+  {
+    LOG_ERROR(F("Chassis::initialiseFromFile ERROR CONFIG ITEM "), statement.key, F(" not found in the conf items list"));
+
+    return false;
+  }
+
+  switch (item)
+  {
+    case CONF_LIGHTS:
+    case CONF_LIGHTS_OVERRIDE:
+    {
+      bool setting = false;
+
+      success = (statement.valueType == VALUE_SCALAR) && chassisTextToSwitch(statement.items[0], setting);
+      if (success && (item == CONF_LIGHTS))          lightsEnabled  = setting;
+      if (success && (item == CONF_LIGHTS_OVERRIDE)) lightsOverride = setting;
+      break;
+    }
+
+    case CONF_CYCLE:
+    {
+      long cycles = 0;
+
+      success = (statement.valueType == VALUE_SCALAR) && chassisTextToInt(statement.items[0], cycles);
+      if (success) runCycles = cycles;
+      break;
+    }
+
+    case CONF_MOVEMENTS:
+    {
+      char fileName[MAX_FILE_NAME_LENGTH];
+
+      success = (statement.valueType == VALUE_SCALAR) && (statement.items[0].length < MAX_FILE_NAME_LENGTH);
+      if (success)
+      {
+        chassisTextCopy(statement.items[0], fileName, sizeof(fileName));
+        setFileName(commandFile, fileName);
+      }
+      break;
+    }
+
+    case CONF_BLE_PINS:
+    {
+      int pins[NUM_BLE_PINS];
+
+      success = statementToInts(statement, VALUE_ARRAY, pins, NUM_BLE_PINS);
+      if (success) initialiseBLE(pins);
+      break;
+    }
+
+    case CONF_LIGHT_PINS:
+    {
+      int pins[NUM_LIGHT_PINS];
+
+      success = statementToInts(statement, VALUE_ARRAY, pins, NUM_LIGHT_PINS);
+      if (success) initialiseLights(pins);
+      break;
+    }
+
+    case CONF_WHEEL_PINS:
+    {
+      int pins[NUM_WHEELS][NUM_WHEEL_PINS];
+
+      success = (statement.numGroups == NUM_WHEELS) && statementToInts(statement, VALUE_ARRAY, &pins[0][0], NUM_WHEELS * NUM_WHEEL_PINS);
+      if (success) initialiseWheels(pins);
+      break;
+    }
+
+    case CONF_SPEED_CONTROL:
+    {
+      bool setting = false;
+
+      success = (statement.valueType == VALUE_SCALAR) && chassisTextToSwitch(statement.items[0], setting);
+      if (success) setSpeedControl(setting);
+      break;
+    }
+
+    case CONF_SPEED_GAINS:
+    {
+      int gains[4];  // kp, ki, kd, kff
+
+      success = statementToInts(statement, VALUE_ARRAY, gains, 4);
+      if (success) setSpeedGains(gains[0], gains[1], gains[2], gains[3]);
+      break;
+    }
+
+    case CONF_WHEEL_CALIBRATION:
+    {
+      // {circumference in 0.01 mm, pulses per turn} per wheel, circumferences do not fit an int
+      long circumference = 0;
+      long pulsesPerTurn = 0;
+
+      success = (statement.valueType == VALUE_ARRAY) && (statement.numGroups == NUM_WHEELS) && (statement.numItems == NUM_WHEELS * 2);
+      for (int wheel=0; success && (wheel < NUM_WHEELS); wheel++)
+      {
+        success = chassisTextToInt(statement.items[2 * wheel], circumference) &&
+                  chassisTextToInt(statement.items[2 * wheel + 1], pulsesPerTurn) &&
+                  setWheelCalibration(wheel, circumference, pulsesPerTurn);
+      }
+      break;
+    }
+
+    case CONF_MOTION_PROFILE:
+    {
+      int settings[3];  // mode, acceleration, jerk
+
+      success = statementToInts(statement, VALUE_ARRAY, settings, 3) && (settings[0] >= 0) &&
+                setMotionProfile(settings[0], settings[1], settings[2]);
+      break;
+    }
+
+    case CONF_TRACK_WIDTH:
     {
-        sendText +=  String(chassisBLE[i]);
-        if (i != NUM_BLE_PINS-1) sendText += ",";
+      long trackWidth = 0;
+
+      success = (statement.valueType == VALUE_SCALAR) && chassisTextToInt(statement.items[0], trackWidth) && (trackWidth > 0);
+      if (success) setTrackWidth(trackWidth);
+      break;
     }
-    sendText += "}";
-    writeToOutput(sendText);
+  }
+
+  LOG_DEBUG(F("Chassis::setConfValue Config "), LOG_FLASH(chassisConfItemName(item)), F(" set to: "), statement.value);
+
+  if (!success)
+    LOG_ERROR(F("Chassis::setConfValue "), LOG_FLASH(chassisConfItemName(item)), F(" ERROR value "), statement.value, F(" is not valid"));
+
+  return success;
+}
+
+//
+// convert an array or tuple statement holding exactly count numbers
+//
+// returns false when the type or the number of items does not match
+//
+bool Chassis::statementToInts(const ChassisStatement &statement, ChassisValueType valueType, int *values, int count)
+{
+  if ((statement.valueType != valueType) || (statement.numItems != count))
+    return false;
+
+  for (int i=0; i < count; i++)
+  {
+    long value = 0;
+
+    if (!chassisTextToInt(statement.items[i], value)) return false;
+    values[i] = value;
+  }
+
+  return true;
+}
+
+//
+// dumps all of the settings to Serial. used for debugging purposes
+//
+void Chassis::dumpSettings()
+{
+#if CHASSIS_LOG_LEVEL >= LOG_LEVEL_INFO
+    // the dump is larger than the wire queue, every section is sent before the next one is queued
+    LOG_INFO(F("Dumping current configured settings"));
+    
+    // dumping wheelpin settings
+    LOG_INFO(F("Dumping wheel pin settings "));
+    for (int i=0; i < NUM_WHEELS; i++)
+        LOG_INFO(F("   "), ChassisLogList(chassisWheels[i], NUM_WHEEL_PINS));
+    flushWire();
+    
+    // dumping the light settings
+    LOG_INFO(F("Dumping light settings"));
+    LOG_INFO(F("   Light pin settings "), ChassisLogList(chassisLights, NUM_LIGHT_PINS));
+    LOG_INFO(F("   Lights enabled "), lightsEnabled ? F("YES") : F("NO"));
+    LOG_INFO(F("   Lights override "), lightsOverride ? F("YES") : F("NO"));
+    flushWire();
+    
+    // dumping the BLE settings
+    LOG_INFO(F("Dumping BLE pin settings "), ChassisLogList(chassisBLE, NUM_BLE_PINS));
     
     // dumping the generic settings
-    writeToOutput("Dumping generic settings");
-    writeToOutput("   ConfigFile "  + configFile); 
-    writeToOutput("   CommandFile " + commandFile);
-    writeToOutput("   Run cycles "  + String(runCycles));
+    LOG_INFO(F("Dumping generic settings"));
+    LOG_INFO(F("   ConfigFile "), configFile);
+    LOG_INFO(F("   CommandFile "), commandFile);
+    LOG_INFO(F("   Run cycles "), runCycles);
+    flushWire();
+
+    // dumping the speed control settings
+    LOG_INFO(F("Dumping speed control settings"));
+    LOG_INFO(F("   Speed control "), speedControl ? F("YES") : F("NO"));
+    LOG_INFO(F("   Speed gains "), ChassisLogList(speedGains, 4));
+    LOG_INFO(F("   Track width "), odometry.getTrackWidth());
+    LOG_INFO(F("   Motion profile "), ChassisLogList(profileSettings, 3));
+    flushWire();
+
+    // circumferences go up to 65535, printed one by one rather than as a list of ints
+    chassisLog.begin();
+    chassisLog.print(F("   Wheel calibration {"));
+    for (int i=0; i < NUM_WHEELS; i++)
+    {
+        chassisLog.print('{');
+        chassisLog.print(wheelDistances[i].getCircumference());
+        chassisLog.print(',');
+        chassisLog.print(wheelDistances[i].getPulsesPerTurn());
+        chassisLog.print((i != NUM_WHEELS-1) ? F("},") : F("}"));
+    }
+    chassisLog.print('}');
+    chassisLog.end();
+    flushWire();
+#endif
 }
 
 //
@@ -639,18 +1404,11 @@ void Chassis::dumpSettings()
 //
 // returns true  when found
 // returns false when not found
-bool Chassis::validateCommand(String cmdString)
+bool Chassis::validateCommand(const char *cmdString)
 {
-    bool found = false;
-    int pos = 0;
-    
-    while ((!found) && (pos < NUM_OF_COMMANDS))
-    {
-        found = commandsAvailable[pos][0].equals(cmdString);
-        pos++;
-    }
-    
-    return found;
+    ChassisText command = {cmdString, (uint8_t) strlen(cmdString)};
+
+    return chassisFindCommand(command) >= 0;
 }
 
 //
@@ -667,207 +1425,293 @@ int Chassis::getRunCycles()
 //
 // THEY RESIDE OUTSIDE THE CHASSIS CLASS
 //
-volatile byte numPulses[NUM_WHEELS];
-unsigned int cumulativeDistances[NUM_WHEELS];
+volatile uint16_t numPulses[NUM_WHEELS];
+volatile uint16_t pulseTotals[NUM_WHEELS];   // free running, never cleared
+
+//
+// pulses to whole mm for doPulseCalculation(), the remainders are carried so no distance is lost
+//
+ChassisPulseConverter pulseConverters[NUM_WHEELS] = {
+                                    ChassisPulseConverter(0, WHEEL_CIRCUM_FLW * 100, PULSES_PER_TURN),
+                                    ChassisPulseConverter(0, WHEEL_CIRCUM_FRW * 100, PULSES_PER_TURN),
+                                    ChassisPulseConverter(0, WHEEL_CIRCUM_RLW * 100, PULSES_PER_TURN),
+                                    ChassisPulseConverter(0, WHEEL_CIRCUM_RRW * 100, PULSES_PER_TURN)
+                                                    };
+volatile uint32_t cumulativeDistances[NUM_WHEELS];
 int pulseCounters[NUM_WHEELS] = {18, 19, 2, 3};
+
+//
+// attach the pulse counter of every wheel, generated and unrolled at compile time
+//
+template <uint8_t Wheel>
+struct PulseCounters
+{
+    static void attach()
+    {
+        attachInterrupt(digitalPinToInterrupt(pulseCounters[Wheel]), pulseCounter<Wheel>, PULSE_DETECTION);
+        PulseCounters<Wheel + 1>::attach();
+    }
+};
+
+template <>
+struct PulseCounters<NUM_WHEELS>
+{
+    static void attach() {}
+};
+
 bool initialisePulseCounters()
 {
-    attachInterrupt(digitalPinToInterrupt(pulseCounters[0]), pulseCounterFLW, PULSE_DETECTION);  // FLW sits on INT 2
-    attachInterrupt(digitalPinToInterrupt(pulseCounters[1]), pulseCounterFRW, PULSE_DETECTION);  // FRW sits on INT 3
-    attachInterrupt(digitalPinToInterrupt(pulseCounters[2]), pulseCounterRLW, PULSE_DETECTION);  // RLW sits on INT 0
-    attachInterrupt(digitalPinToInterrupt(pulseCounters[3]), pulseCounterRRW, PULSE_DETECTION);  // RRW sits on INT 1
-     
-    for (int i=0; i < NUM_WHEELS; i++)
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
     {
-        numPulses[i] = 0;
-        cumulativeDistances[i] = 0;
+        for (int i=0; i < NUM_WHEELS; i++)
+        {
+            numPulses[i] = 0;
+            cumulativeDistances[i] = 0;
+        }
     }
-    
+
+    // on the ATmega2560 pin 18 (FLW) is INT3, 19 (FRW) INT2, 2 (RLW) INT4 and 3 (RRW) INT5,
+    // attachInterrupt() numbers 5, 4, 0 and 1, which digitalPinToInterrupt() looks up
+    PulseCounters<0>::attach();
+
     return true;
 }
 
-void doPulseCalculation()
+//
+// copy and clear the pulse counters in one short atomic section
+//
+// the handlers stay attached, a pulse arriving during the copy is simply counted
+// in the next snapshot
+//
+void snapshotPulses(uint16_t pulses[NUM_WHEELS])
 {
-    //Don't process interrupts during calculations
-    
-    noInterrupts();
-    cli();
-    
-    //
-    // assume at least a 1/2 turn for proper calculation
-    //
-    if (
-        (numPulses[0] >= (PULSES_PER_TURN / 2)) ||
-        (numPulses[1] >= (PULSES_PER_TURN / 2)) ||
-        (numPulses[2] >= (PULSES_PER_TURN / 2)) ||
-        (numPulses[3] >= (PULSES_PER_TURN / 2))
-       )
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
     {
-   
-        if (DEBUG) Serial.println("START doPulseCalculation");
-
         for (int i=0; i < NUM_WHEELS; i++)
-            detachInterrupt(i);
-
-        if (DEBUG)
         {
-             Serial.print("CUMU DIST ....");
-             for (int i=0; i < NUM_WHEELS; i++)
-             {
-               Serial.print(cumulativeDistances[i]);
-               Serial.print(" ");
-             }
-              Serial.println("");
-        }
-        
-        cumulativeDistances[0] += (WHEEL_CIRCUM_FLW * numPulses[0]) / PULSES_PER_TURN;
-        cumulativeDistances[1] += (WHEEL_CIRCUM_FRW * numPulses[1]) / PULSES_PER_TURN;
-        cumulativeDistances[2] += (WHEEL_CIRCUM_RLW * numPulses[2]) / PULSES_PER_TURN;
-        cumulativeDistances[3] += (WHEEL_CIRCUM_RRW * numPulses[3]) / PULSES_PER_TURN;
-   
-        if (DEBUG)
-        {
-            Serial.print("NUM PULSES ....");
-            for (int i=0; i < NUM_WHEELS; i++)
-            {
-                Serial.print(numPulses[i]);
-                Serial.print(" ");
-            }
-            Serial.println("");
+            pulses[i] = numPulses[i];
+            numPulses[i] = 0;
         }
+    }
+}
+
+//
+// tear free read of the distance travelled by a wheel in mm
+//
+uint32_t readCumulativeDistance(int wheel)
+{
+    uint32_t distance;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        distance = cumulativeDistances[wheel];
+    }
 
+    return distance;
+}
+
+//
+// copy the free running pulse totals, differences between two snapshots are the pulses
+// in between, also across a wrap
+//
+void snapshotPulseTotals(uint16_t totals[NUM_WHEELS])
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
         for (int i=0; i < NUM_WHEELS; i++)
-            numPulses[i] = 0;
-        
-        if (DEBUG)
-        {
-            Serial.print("CUMU DIST ....");
-            for (int i=0; i < NUM_WHEELS; i++)
-            {
-                Serial.print(cumulativeDistances[i]);
-                Serial.print(" ");
-            }
-            Serial.println("");
-        }
-    
-        //Restart the interrupt processing
-        attachInterrupt(digitalPinToInterrupt(2),  pulseCounterRLW, PULSE_DETECTION);  // RLW sits on INT 0
-        attachInterrupt(digitalPinToInterrupt(3),  pulseCounterRRW, PULSE_DETECTION);  // RRW sits on INT 1
-        attachInterrupt(digitalPinToInterrupt(21), pulseCounterFLW, PULSE_DETECTION);  // FLW sits on INT 2
-        attachInterrupt(digitalPinToInterrupt(20), pulseCounterFRW, PULSE_DETECTION);  // FRW sits on INT 3
+            totals[i] = pulseTotals[i];
+    }
+}
 
-        if (DEBUG) Serial.println("END doPulseCalculation");
+void resetCumulativeDistances()
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        for (int i=0; i < NUM_WHEELS; i++)
+            cumulativeDistances[i] = 0;
     }
-    
-    sei();
-    interrupts();
+}
+
+//
+// convert the pulses counted so far into distance, call from a timer interrupt or from loop()
+// but not from both
+//
+// the part of a mm left over is carried to the next call, so it can be called as often as
+// needed without losing distance
+//
+void doPulseCalculation()
+{
+    uint16_t pulses[NUM_WHEELS];
+    uint32_t distances[NUM_WHEELS];
+
+    LOG_DEBUG(F("START doPulseCalculation"));
+
+    snapshotPulses(pulses);
+
+    for (int i=0; i < NUM_WHEELS; i++)
+        distances[i] = pulseConverters[i].convert(pulses[i]);
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        for (int i=0; i < NUM_WHEELS; i++)
+            cumulativeDistances[i] += distances[i];
+    }
+
+    LOG_DEBUG(F("NUM PULSES ...."), pulses[0], ' ', pulses[1], ' ', pulses[2], ' ', pulses[3]);
+    LOG_DEBUG(F("CUMU DIST ...."), readCumulativeDistance(0), ' ', readCumulativeDistance(1), ' ',
+              readCumulativeDistance(2), ' ', readCumulativeDistance(3));
+    LOG_DEBUG(F("END doPulseCalculation"));
 }
 
 
 //
-// pulse counting
+// stream status frames to output at rate frames per second, e.g. over the BLE serial link
 //
-void pulseCounterFLW()
+// a frame of a driving chassis is about ten bytes, so 20 frames per second fit in 9600 baud
+// with room to spare. The first frame is a key frame a receiver can start from
+//
+void Chassis::setTelemetry(Print &output, uint8_t rate)
 {
-    numPulses[0]++;
+    telemetryOutput = &output;
+    telemetryPeriod = (rate > 0) ? (1000 / rate) : 0;
+    nextTelemetry   = millis();
+    telemetryLength = 0;
+    telemetrySent   = 0;
+    telemetryEncoder.reset();
 }
 
-void pulseCounterFRW()
+//
+// write as much of the current frame as the output takes without waiting, at least a byte
+//
+void Chassis::sendTelemetry()
 {
-    numPulses[1]++;
+    if (telemetrySent >= telemetryLength) return;
+
+    int room = telemetryOutput->availableForWrite();
+    int left = telemetryLength - telemetrySent;
+
+    if (room < 1)    room = 1;
+    if (room > left) room = left;
+
+    telemetrySent += telemetryOutput->write(&telemetryFrame[telemetrySent], room);
 }
 
-void pulseCounterRLW()
+//
+// current state in telemetry fields
+//
+void Chassis::getTelemetry(ChassisTelemetry &state)
 {
-    numPulses[2]++;
+    uint16_t totals[NUM_WHEELS];
+    uint32_t distance = 0;
+    int32_t  status = 0;
+
+    snapshotPulseTotals(totals);
+
+    for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+    {
+        state.values[TELEMETRY_PULSES + wheel] = totals[wheel];
+        state.values[TELEMETRY_SPEEDS + wheel] = measuredSpeeds[wheel];
+        distance += readCumulativeDistance(wheel);
+    }
+
+    for (int light=0; light < NUM_LIGHT_PINS; light++)
+        if (lightStatus[light]) status |= (1 << light);
+
+    if (manualMode) status |= TELEMETRY_STATUS_MANUAL;
+    if (isBusy())   status |= TELEMETRY_STATUS_BUSY;
+
+    state.values[TELEMETRY_DISTANCE] = distance / NUM_WHEELS;
+    state.values[TELEMETRY_STATUS]   = status;
 }
 
-void pulseCounterRRW()
+//
+// encode the next telemetry frame for a link of your own, returns its length
+//
+// frames are deltas of the frame before, send every frame or call setTelemetry() to start over
+//
+uint8_t Chassis::getTelemetryFrame(uint8_t frame[TELEMETRY_MAX_FRAME])
 {
-    numPulses[3]++;
+    ChassisTelemetry state;
+
+    getTelemetry(state);
+
+    return telemetryEncoder.encode(state, frame);
 }
 
 //
 // writeToOuput can be used to write to both serial and wire.
-// for wire we have start/stop bytes (first 2 bytes) of a frame containing max of 30 bytes of info
 //
-// A set of frames has two reserved bytes. The first two bytes are:
+// Serial is written straight away. For wire the text is only queued, update() sends it one frame
+// per call (see ChassisWireQueue.h for the framing), so writing costs no bus time. When the queue
+// is full the message is dropped and counted, see getWireDropped()
 //
-//  start = '06'
-//  continuation = '07'
-//  stop = '08'
-//
-// '06' '08' = 1 frame
-// '06' '07' followed by '07' '08' = 2 frames
-// '07' '07' for more than 2 frames. '06' '07' start frame; '07' '07' (one of more times); '07' '08' stop frame
+// The library itself logs through ChassisLog.h, which reaches the same outputs without building
+// Strings
 // 
 // Depending on the variable setting in myChassis it will output to Serial and/or Wire
 //
-const int frameSize = 30;   
-
 void Chassis::writeToOutput(String outputText)
 {
-  if (haveSerial)
-  {
-    Serial.println(outputText);
-  }
+  chassisLog.line(outputText);
+}                                              
 
-  if (haveWire)
-  {
-    //
-    // Wire can only send 32 bytes max at the time so we need to send in chunks
-    //
-    int lenText = outputText.length();
-    int numChunks = ceil(lenText / 30);
+//
+// send the next frame of queued wire output, a frame keeps the bus busy for about 3 ms at 100 kHz
+//
+// returns false when nothing was queued
+//
+bool Chassis::sendWireFrame()
+{
+    ChassisWireQueue &wireQueue = chassisLog.getWireQueue();
+    uint8_t frame[WIRE_FRAME_SIZE];
+    uint8_t length = wireQueue.peekFrame(frame);
 
-    int i = 0;
-    int endPos = 0;
+    if (length == 0) return false;
 
-    while (i <= numChunks)
-    {
-      endPos = (i+1)*frameSize > lenText?lenText:(i+1)*frameSize;
+    Wire.beginTransmission(receivingEnd);
+    Wire.write(frame, length);
 
-      Wire.beginTransmission(receivingEnd); // assume receivi
+    // a frame the receiver did not take is not sent again, the next frames would be late
+    if ((Wire.endTransmission() != 0) && (wireErrors < 0xFFFF)) wireErrors++;
 
-      if (i == 0)
-      {
-        // start frame
-        Wire.write(6);
-        Wire.write((numChunks > 0)?7:8);
-        Wire.print(outputText.substring(i*frameSize, endPos));
+    wireQueue.popFrame();
 
-        // Serial.print("Writing  6+"); Serial.println((numChunks > 1)?7:8);
-      }
-      else if (i == numChunks)
-      {
-        // end frame
-        Wire.write((numChunks > 0)?7:6);
-        Wire.write(8);
-        Wire.print(outputText.substring(i*frameSize, endPos));
+    return true;
+}
 
-        // Serial.print("Writing ");Serial.print((numChunks > 0)?7:6);Serial.println("+8");
-      }
-      else
-      {
-        // middle frame
-        Wire.write(7);
-        Wire.write(7);
-        Wire.print(outputText.substring(i*30, endPos));
+//
+// send all queued wire output now, e.g. before a reset or outside the update() loop
+//
+void Chassis::flushWire()
+{
+    while (sendWireFrame());
+}
 
-        // Serial.println("Writing 7+7");
-      }
+int Chassis::getWireQueued()
+{
+    return chassisLog.getWireQueue().getQueued();
+}
 
-      Wire.endTransmission();
-      i++;
-    }
-  }
-}                                              
+unsigned int Chassis::getWireDropped()
+{
+    return chassisLog.getWireQueue().getDropped();
+}
+
+unsigned int Chassis::getWireOversized()
+{
+    return chassisLog.getWireQueue().getOversized();
+}
+
+unsigned int Chassis::getWireErrors()
+{
+    return wireErrors;
+}
 
 //
 // setting serial
 bool Chassis::setSerial(bool setting)
 {
-    haveSerial = setting;
+    chassisLog.setSerial(setting);
     
     return true;
 }
@@ -876,7 +1720,7 @@ bool Chassis::setSerial(bool setting)
 // setting Wire
 bool Chassis::setWire(bool setting)
 {
-    haveWire = setting;
+    chassisLog.setWire(setting);
 
     return true;
 }
@@ -0,0 +1,180 @@
+//
+//  ChassisCommands.cpp
+//
+//
+//  Commands in their parsed form, shared by every front end.
+//
+
+#include "ChassisCommands.h"
+
+#if defined(__AVR__)
+#  include <avr/pgmspace.h>
+#endif
+
+#ifndef PROGMEM
+#  define PROGMEM
+#endif
+#ifndef pgm_read_byte
+#  define pgm_read_byte(address) (*(const uint8_t *) (address))
+#endif
+
+//
+// operands per command, in ChassisCommand order
+//
+static const uint8_t commandArgs[NUM_OF_COMMANDS] PROGMEM = {
+    4,    // WHEELS
+    1,    // FORWARD
+    1,    // BACKWARD
+    0,    // FULLSTOP
+    1,    // ROTATE
+    1,    // LIGHTS
+    2,    // DURATION
+    1     // DISTANCE
+};
+
+uint8_t chassisCommandArgs(uint8_t command)
+{
+    return (command < NUM_OF_COMMANDS) ? pgm_read_byte(&commandArgs[command]) : 0;
+}
+
+//
+// the range of an operand value of a command, checked before it is narrowed to int16
+//
+static bool argInRange(uint8_t command, long value)
+{
+    switch (command)
+    {
+        case CMD_WHEELS:
+        case CMD_FORWARD:
+        case CMD_BACKWARD:
+            return (value >= -COMMAND_MAX_SPEED) && (value <= COMMAND_MAX_SPEED);
+
+        case CMD_ROTATE:
+            return (value >= -COMMAND_MAX_ANGLE) && (value <= COMMAND_MAX_ANGLE);
+
+        case CMD_LIGHTS:
+            return (value >= 0) && (value <= 0x0F);
+
+        case CMD_DURATION:
+            return (value >= 0) && (value <= COMMAND_MAX_DURATION);
+
+        case CMD_DISTANCE:
+            return (value >= 0) && (value <= COMMAND_MAX_DISTANCE);
+
+        default:
+            return false;
+    }
+}
+
+//
+// check a command from any source before it is executed, e.g. the operands passed to
+// Chassis::execute() over I2C
+//
+bool chassisCommandInRange(const ChassisParsedCommand &parsed)
+{
+    if ((parsed.command >= NUM_OF_COMMANDS) || (parsed.numArgs != chassisCommandArgs(parsed.command)))
+        return false;
+
+    // the low word of a DURATION is any 16 bits, the high word keeps it positive
+    if (parsed.command == CMD_DURATION) return parsed.args[1] >= 0;
+
+    for (uint8_t i=0; i < parsed.numArgs; i++)
+        if (!argInRange(parsed.command, parsed.args[i])) return false;
+
+    return true;
+}
+
+//
+// the items of a (...) value as int16 operands
+//
+static bool tupleToArgs(const ChassisStatement &statement, ChassisParsedCommand &parsed)
+{
+    if ((statement.valueType != VALUE_TUPLE) || (statement.numItems != parsed.numArgs))
+        return false;
+
+    for (uint8_t i=0; i < parsed.numArgs; i++)
+    {
+        long value = 0;
+
+        if (!chassisTextToInt(statement.items[i], value) || !argInRange(parsed.command, value)) return false;
+        parsed.args[i] = value;
+    }
+
+    return true;
+}
+
+//
+// turn a command statement into its parsed form
+//
+// parsed.command is set as soon as the keyword is known, so callers can name it in errors
+//
+ChassisCommandResult chassisParseCommand(const ChassisStatement &statement, ChassisParsedCommand &parsed)
+{
+    int8_t command = chassisFindCommand(statement.key);
+
+    if (command < 0) return COMMAND_UNKNOWN;
+
+    parsed.command = command;
+    parsed.numArgs = chassisCommandArgs(command);
+
+    for (uint8_t i=0; i < MAX_COMMAND_ARGS; i++)
+        parsed.args[i] = 0;
+
+    if (chassisCommandNeedsValue(command) && (statement.valueType == VALUE_NONE))
+        return COMMAND_MISSING_VALUE;
+
+    switch (command)
+    {
+        case CMD_WHEELS:
+            if (!tupleToArgs(statement, parsed)) return COMMAND_INVALID_VALUE;
+            break;
+
+        case CMD_LIGHTS:
+        {
+            // lfl rfl rll rrl, ON or OFF each
+            if ((statement.valueType != VALUE_TUPLE) || (statement.numItems != 4))
+                return COMMAND_INVALID_VALUE;
+
+            for (uint8_t light=0; light < 4; light++)
+            {
+                bool setting = false;
+
+                if (!chassisTextToSwitch(statement.items[light], setting)) return COMMAND_INVALID_VALUE;
+                if (setting) parsed.args[0] |= (1 << light);
+            }
+            break;
+        }
+
+        case CMD_DURATION:
+        {
+            long value = 0;
+
+            if ((statement.valueType != VALUE_SCALAR) || !chassisTextToInt(statement.items[0], value) ||
+                !argInRange(command, value))
+                return COMMAND_INVALID_VALUE;
+
+            parsed.args[0] = (uint32_t) value & 0xFFFF;
+            parsed.args[1] = (uint32_t) value >> 16;
+            break;
+        }
+
+        case CMD_FULLSTOP:
+            break;
+
+        default:
+        {
+            long value = 0;
+
+            // FORWARD and BACKWARD without a speed are a speed of 0
+            if ((statement.valueType != VALUE_NONE) &&
+                ((statement.valueType != VALUE_SCALAR) || !chassisTextToInt(statement.items[0], value) ||
+                 !argInRange(command, value)))
+                return COMMAND_INVALID_VALUE;
+
+            parsed.args[0] = value;
+            break;
+        }
+    }
+
+    return COMMAND_OK;
+}
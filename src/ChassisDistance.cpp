@@ -0,0 +1,75 @@
+//
+//  ChassisDistance.cpp
+//
+//
+//  Exact conversion of wheel encoder pulses into distance.
+//
+
+#include "ChassisDistance.h"
+
+#define PULSE_CHUNK               128       // pulses per step of convert(), keeps the products within 32 bits
+
+void ChassisPulseConverter::setCalibration(uint16_t wheelCircumference, uint16_t wheelPulsesPerTurn)
+{
+    circumference = wheelCircumference;
+    pulsesPerTurn = (wheelPulsesPerTurn > 0) ? wheelPulsesPerTurn : 1;
+    residue       = 0;
+}
+
+uint16_t ChassisPulseConverter::getCircumference()
+{
+    return circumference;
+}
+
+uint16_t ChassisPulseConverter::getPulsesPerTurn()
+{
+    return pulsesPerTurn;
+}
+
+//
+// distance of the pulses, the remainder of the division is carried to the next call
+//
+uint32_t ChassisPulseConverter::convert(uint16_t pulses)
+{
+    uint32_t divisor  = (uint32_t) pulsesPerTurn * 100;
+    uint32_t distance = 0;
+
+    while (pulses > 0)
+    {
+        uint16_t chunk = (pulses > PULSE_CHUNK) ? PULSE_CHUNK : pulses;
+        uint32_t numerator = (((uint32_t) chunk * circumference) << fractionBits) + residue;
+
+        distance += numerator / divisor;
+        residue   = numerator % divisor;
+        pulses   -= chunk;
+    }
+
+    return distance;
+}
+
+void ChassisPulseConverter::reset()
+{
+    residue = 0;
+}
+
+uint32_t ChassisPulseConverter::toDistance(uint16_t pulses)
+{
+    return ((uint32_t) pulses * circumference) / ((uint32_t) pulsesPerTurn * 100);
+}
+
+uint16_t ChassisPulseConverter::toPulses(uint32_t distance)
+{
+    if (circumference == 0) return 0;
+
+    // distance * pulsesPerTurn * 100 stays within 32 bits up to about 2 km for 20 pulses per turn
+    uint32_t pulses = ((distance * pulsesPerTurn * 100) + (circumference / 2)) / circumference;
+
+    return (pulses > 0xFFFF) ? 0xFFFF : pulses;
+}
+
+uint16_t ChassisPulseConverter::toSpeed(uint16_t pulses, uint16_t milliseconds)
+{
+    if (milliseconds == 0) return 0;
+
+    return ((uint32_t) pulses * circumference * 10) / ((uint32_t) pulsesPerTurn * milliseconds);
+}
@@ -0,0 +1,191 @@
+//
+//  ChassisKeywords.cpp
+//
+//
+//  Keywords of the configuration and command files, kept in flash.
+//
+
+#include "ChassisKeywords.h"
+
+#if defined(__AVR__)
+#  include <avr/pgmspace.h>
+#endif
+
+#ifndef PROGMEM
+#  define PROGMEM
+#endif
+#ifndef pgm_read_byte
+#  define pgm_read_byte(address) (*(const uint8_t *) (address))
+#endif
+#ifndef pgm_read_ptr
+#  define pgm_read_ptr(address) (*(const void * const *) (address))
+#endif
+
+static const char confLights[]           PROGMEM = "LIGHTS";
+static const char confLightsOverride[]   PROGMEM = "LIGHTS_OVERRIDE";
+static const char confLightPins[]        PROGMEM = "LIGHT_PINS";
+static const char confWheelPins[]        PROGMEM = "WHEEL_PINS";
+static const char confBlePins[]          PROGMEM = "BLE_PINS";
+static const char confCycle[]            PROGMEM = "CYCLE";
+static const char confMovements[]        PROGMEM = "MOVEMENTS";
+static const char confSpeedControl[]     PROGMEM = "SPEED_CONTROL";
+static const char confSpeedGains[]       PROGMEM = "SPEED_GAINS";
+static const char confTrackWidth[]       PROGMEM = "TRACK_WIDTH";
+static const char confWheelCalibration[] PROGMEM = "WHEEL_CALIBRATION";
+static const char confMotionProfile[]    PROGMEM = "MOTION_PROFILE";
+
+static const char *const confItemNames[NUM_CONFIG_ITEMS] PROGMEM = {
+    confLights, confLightsOverride, confLightPins, confWheelPins, confBlePins, confCycle,
+    confMovements, confSpeedControl, confSpeedGains, confTrackWidth, confWheelCalibration,
+    confMotionProfile
+};
+
+static const char cmdWheels[]            PROGMEM = "WHEELS";
+static const char cmdForward[]           PROGMEM = "FORWARD";
+static const char cmdBackward[]          PROGMEM = "BACKWARD";
+static const char cmdFullStop[]          PROGMEM = "FULLSTOP";
+static const char cmdRotate[]            PROGMEM = "ROTATE";
+static const char cmdLights[]            PROGMEM = "LIGHTS";
+static const char cmdDuration[]          PROGMEM = "DURATION";
+static const char cmdDistance[]          PROGMEM = "DISTANCE";
+
+static const char *const commandNames[NUM_OF_COMMANDS] PROGMEM = {
+    cmdWheels, cmdForward, cmdBackward, cmdFullStop, cmdRotate, cmdLights, cmdDuration, cmdDistance
+};
+
+static const char ctrlRepeat[]           PROGMEM = "REPEAT";
+static const char ctrlEnd[]              PROGMEM = "END";
+static const char ctrlLabel[]            PROGMEM = "LABEL";
+static const char ctrlGoto[]             PROGMEM = "GOTO";
+static const char ctrlCall[]             PROGMEM = "CALL";
+
+static const char *const controlNames[NUM_OF_CONTROLS] PROGMEM = {
+    ctrlRepeat, ctrlEnd, ctrlLabel, ctrlGoto, ctrlCall
+};
+
+// 1 when the command needs a value
+static const uint8_t commandValues[NUM_OF_COMMANDS] PROGMEM = {1, 0, 0, 0, 1, 1, 1, 1};
+
+static char upper(char c)
+{
+    return ((c >= 'a') && (c <= 'z')) ? c - ('a' - 'A') : c;
+}
+
+//
+// case insensitive compare of a text view with a name in flash
+//
+static bool matches(const ChassisText &text, const char *name)
+{
+    uint8_t i = 0;
+
+    for (; i < text.length; i++)
+    {
+        char c = pgm_read_byte(name + i);
+
+        if ((c == '\0') || (upper(text.text[i]) != c)) return false;
+    }
+
+    return pgm_read_byte(name + i) == '\0';
+}
+
+static int8_t confCandidate(const ChassisText &key)
+{
+    switch (key.length)
+    {
+        case 5:  return CONF_CYCLE;
+        case 6:  return CONF_LIGHTS;
+        case 8:  return CONF_BLE_PINS;
+        case 9:  return CONF_MOVEMENTS;
+        case 10: return (upper(key.text[0]) == 'W') ? CONF_WHEEL_PINS : CONF_LIGHT_PINS;
+        case 11: return (upper(key.text[0]) == 'T') ? CONF_TRACK_WIDTH : CONF_SPEED_GAINS;
+        case 13: return CONF_SPEED_CONTROL;
+        case 14: return CONF_MOTION_PROFILE;
+        case 15: return CONF_LIGHTS_OVERRIDE;
+        case 17: return CONF_WHEEL_CALIBRATION;
+    }
+
+    return -1;
+}
+
+static int8_t commandCandidate(const ChassisText &key)
+{
+    switch (key.length)
+    {
+        case 6:
+            switch (upper(key.text[0]))
+            {
+                case 'W': return CMD_WHEELS;
+                case 'R': return CMD_ROTATE;
+                case 'L': return CMD_LIGHTS;
+            }
+            break;
+
+        case 7:
+            return CMD_FORWARD;
+
+        case 8:
+            switch (upper(key.text[0]))
+            {
+                case 'B': return CMD_BACKWARD;
+                case 'F': return CMD_FULLSTOP;
+                case 'D': return (upper(key.text[7]) == 'N') ? CMD_DURATION : CMD_DISTANCE;
+            }
+            break;
+    }
+
+    return -1;
+}
+
+static int8_t controlCandidate(const ChassisText &key)
+{
+    switch (key.length)
+    {
+        case 3:  return CTRL_END;
+        case 4:  return (upper(key.text[0]) == 'G') ? CTRL_GOTO : CTRL_CALL;
+        case 5:  return CTRL_LABEL;
+        case 6:  return CTRL_REPEAT;
+    }
+
+    return -1;
+}
+
+int8_t chassisFindConfItem(const ChassisText &key)
+{
+    int8_t item = confCandidate(key);
+
+    return ((item >= 0) && matches(key, chassisConfItemName(item))) ? item : -1;
+}
+
+int8_t chassisFindCommand(const ChassisText &key)
+{
+    int8_t command = commandCandidate(key);
+
+    return ((command >= 0) && matches(key, chassisCommandName(command))) ? command : -1;
+}
+
+int8_t chassisFindControl(const ChassisText &key)
+{
+    int8_t control = controlCandidate(key);
+
+    return ((control >= 0) && matches(key, chassisControlName(control))) ? control : -1;
+}
+
+const char *chassisConfItemName(uint8_t item)
+{
+    return (const char *) pgm_read_ptr(&confItemNames[item]);
+}
+
+const char *chassisCommandName(uint8_t command)
+{
+    return (const char *) pgm_read_ptr(&commandNames[command]);
+}
+
+const char *chassisControlName(uint8_t control)
+{
+    return (const char *) pgm_read_ptr(&controlNames[control]);
+}
+
+bool chassisCommandNeedsValue(uint8_t command)
+{
+    return pgm_read_byte(&commandValues[command]) != 0;
+}
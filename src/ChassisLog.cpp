@@ -0,0 +1,89 @@
+//
+//  ChassisLog.cpp
+//
+//
+//  Flash resident logging to the Serial and Wire outputs.
+//
+
+#include "ChassisLog.h"
+
+ChassisLog chassisLog;
+
+static const char lineTooLong[] PROGMEM = "LOG line longer than WIRE_MAX_MESSAGE dropped";
+
+void ChassisLog::setSerial(bool setting)
+{
+    serial = setting;
+}
+
+void ChassisLog::setWire(bool setting)
+{
+    wire = setting;
+}
+
+ChassisWireQueue &ChassisLog::getWireQueue()
+{
+    return wireQueue;
+}
+
+//
+// a line is a single message in the wire queue, it is dropped as a whole when the queue runs full
+//
+void ChassisLog::begin()
+{
+    if (wire) wireQueue.beginMessage();
+}
+
+void ChassisLog::end()
+{
+    if (serial) Serial.println();
+
+    if (wire)
+    {
+        uint16_t oversized = wireQueue.getOversized();
+
+        // a line that can never fit is replaced by a notice, so the receiving end knows
+        if (!wireQueue.endMessage() && (wireQueue.getOversized() != oversized))
+        {
+            wireQueue.beginMessage();
+            for (const char *c = lineTooLong; pgm_read_byte(c) != '\0'; c++)
+                wireQueue.append(pgm_read_byte(c));
+            wireQueue.endMessage();
+        }
+    }
+}
+
+size_t ChassisLog::write(uint8_t c)
+{
+    if (serial) Serial.write(c);
+    if (wire) wireQueue.append(c);
+
+    return 1;
+}
+
+size_t ChassisLog::write(const uint8_t *buffer, size_t size)
+{
+    if (serial) Serial.write(buffer, size);
+
+    if (wire)
+        for (size_t i = 0; i < size; i++)
+            wireQueue.append(buffer[i]);
+
+    return size;
+}
+
+void ChassisLog::printItem(const ChassisText &text)
+{
+    write((const uint8_t *) text.text, text.length);
+}
+
+void ChassisLog::printItem(const ChassisLogList &list)
+{
+    write('{');
+    for (uint8_t i = 0; i < list.count; i++)
+    {
+        if (i > 0) write(',');
+        print(list.values[i]);
+    }
+    write('}');
+}
@@ -0,0 +1,139 @@
+//
+//  ChassisOdometry.cpp
+//
+//
+//  Fixed point dead reckoning from the left and right wheel distances.
+//
+
+#include "ChassisOdometry.h"
+
+#if defined(__AVR__)
+#  include <avr/pgmspace.h>
+#endif
+
+#ifndef PROGMEM
+#  define PROGMEM
+#endif
+#ifndef pgm_read_word
+#  define pgm_read_word(address) (*(const uint16_t *) (address))
+#endif
+
+//
+// 2^24 / (2 * pi * 256): heading units per Q8 mm of wheel difference, times the track width in mm.
+// The 0.378 left out is a scale error of 0.004%, well below what a track width calibration reaches
+//
+#define ODOMETRY_TURN_FACTOR      10430L
+
+//
+// quarter wave of sin(), 64 steps of 90/64 degrees, Q15
+//
+static const int16_t sineTable[65] PROGMEM = {
+        0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+     6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+    12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+    18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+    23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+    27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+    32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+    32767
+};
+
+//
+// sin() of the first quadrant, angle 0..0x4000, interpolated between the table entries
+//
+static int16_t quarterSin(uint16_t angle)
+{
+    uint8_t index = angle >> 8;
+    uint8_t fraction = angle & 0xFF;
+    int16_t low = (int16_t) pgm_read_word(&sineTable[index]);
+
+    if (index >= 64) return low;
+
+    int16_t high = (int16_t) pgm_read_word(&sineTable[index + 1]);
+
+    return low + (int16_t) (((int32_t) (high - low) * fraction) >> 8);
+}
+
+int16_t chassisSin(uint16_t angle)
+{
+    uint16_t inQuadrant = angle & 0x3FFF;
+    int16_t  value;
+
+    if (angle & 0x4000)
+        value = quarterSin(0x4000 - inQuadrant);   // second and fourth quadrant mirror the first
+    else
+        value = quarterSin(inQuadrant);
+
+    return (angle & 0x8000) ? -value : value;
+}
+
+int16_t chassisCos(uint16_t angle)
+{
+    return chassisSin(angle + 0x4000);
+}
+
+ChassisOdometry::ChassisOdometry()
+{
+    reset();
+}
+
+void ChassisOdometry::setTrackWidth(uint16_t newTrackWidth)
+{
+    if (newTrackWidth > 0) trackWidth = newTrackWidth;
+    turnResidue = 0;
+}
+
+uint16_t ChassisOdometry::getTrackWidth()
+{
+    return trackWidth;
+}
+
+//
+// back to (0, 0) heading 0
+//
+void ChassisOdometry::reset()
+{
+    x           = 0;
+    y           = 0;
+    heading     = 0;
+    turnResidue = 0;
+}
+
+//
+// integrate one step, left and right are the Q24.8 mm travelled by each side since the last
+// step. Steps are expected to stay below 256 mm per side, i.e. call at least every few
+// hundred ms at normal speeds
+//
+void ChassisOdometry::update(int32_t left, int32_t right)
+{
+    //
+    // turn, the remainder of the division is carried so slow turns are not lost
+    //
+    int32_t turn = ((right - left) * ODOMETRY_TURN_FACTOR) + turnResidue;
+    int32_t deltaHeading = turn / trackWidth;
+
+    turnResidue = turn - (deltaHeading * trackWidth);
+
+    //
+    // move along the heading halfway through the step
+    //
+    uint16_t middle = (uint32_t) (heading + (deltaHeading / 2)) >> (ODOMETRY_ANGLE_BITS - 16);
+    int32_t  distance = (left + right) / 2;
+
+    x += ((distance * chassisCos(middle)) + (1L << 14)) >> 15;
+    y += ((distance * chassisSin(middle)) + (1L << 14)) >> 15;
+
+    heading = (heading + deltaHeading) & ((1UL << ODOMETRY_ANGLE_BITS) - 1);
+}
+
+ChassisPose ChassisOdometry::getPose()
+{
+    ChassisPose pose;
+
+    pose.x       = x;
+    pose.y       = y;
+    pose.heading = heading >> (ODOMETRY_ANGLE_BITS - 16);
+
+    return pose;
+}
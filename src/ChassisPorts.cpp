@@ -0,0 +1,116 @@
+//
+//  ChassisPorts.cpp
+//
+//
+//  Direct port register output for the digital pins of the chassis.
+//
+
+#include "ChassisPorts.h"
+
+#include <util/atomic.h>
+
+ChassisPortSet::ChassisPortSet()
+{
+    clear();
+}
+
+//
+// forget all pins
+//
+void ChassisPortSet::clear()
+{
+    numPorts = 0;
+    numPins  = 0;
+}
+
+//
+// add a pin to the set, looking up its port register and bit once
+//
+// returns false when the pin has no port or the set is full, the pin still takes
+// up its index so set() on it is silently ignored
+//
+// the port writes bypass digitalWrite(), so a PWM capable pin has its timer output
+// switched off here, once, by a digitalWrite() of LOW
+//
+bool ChassisPortSet::addPin(int pin)
+{
+    if (numPins >= MAX_PORT_PINS) return false;
+
+    uint8_t pinIndex = numPins++;
+
+    pinPorts[pinIndex] = MAX_PORT_GROUPS;
+    pinMasks[pinIndex] = 0;
+
+    // the core looks the pin up in its tables without a range check
+    if ((pin < 0) || (pin >= NUM_DIGITAL_PINS)) return false;
+
+    uint8_t port = digitalPinToPort(pin);
+
+    if (port == NOT_A_PORT) return false;
+
+    if (digitalPinToTimer(pin) != NOT_ON_TIMER) digitalWrite(pin, LOW);
+
+    volatile uint8_t *portRegister = portOutputRegister(port);
+    uint8_t group = 0;
+
+    while ((group < numPorts) && (ports[group] != portRegister))
+        group++;
+
+    if (group == numPorts)
+    {
+        if (numPorts >= MAX_PORT_GROUPS) return false;
+
+        ports[group]      = portRegister;
+        portMasks[group]  = 0;
+        portValues[group] = 0;
+        numPorts++;
+    }
+
+    pinPorts[pinIndex] = group;
+    pinMasks[pinIndex] = digitalPinToBitMask(pin);
+    portMasks[group]  |= pinMasks[pinIndex];
+
+    return true;
+}
+
+//
+// request a level for a pin, nothing is written until write()
+//
+void ChassisPortSet::set(uint8_t pinIndex, bool value)
+{
+    if ((pinIndex >= numPins) || (pinPorts[pinIndex] >= MAX_PORT_GROUPS)) return;
+
+    if (value)
+        portValues[pinPorts[pinIndex]] |= pinMasks[pinIndex];
+    else
+        portValues[pinPorts[pinIndex]] &= ~pinMasks[pinIndex];
+}
+
+//
+// apply the requested levels, the current port value doubles as shadow state so ports
+// without changes are skipped
+//
+void ChassisPortSet::write()
+{
+    for (uint8_t group=0; group < numPorts; group++)
+    {
+        volatile uint8_t *port = ports[group];
+        uint8_t mask = portMasks[group];
+
+        if ((*port & mask) == portValues[group]) continue;
+
+        // other pins on the port may be changed from interrupts, keep the read-modify-write atomic
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            *port = (*port & ~mask) | portValues[group];
+        }
+    }
+}
+
+//
+// number of distinct ports, i.e. the maximum number of stores done by write()
+//
+uint8_t ChassisPortSet::getNumPorts()
+{
+    return numPorts;
+}
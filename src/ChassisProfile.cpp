@@ -0,0 +1,166 @@
+//
+//  ChassisProfile.cpp
+//
+//
+//  Acceleration and jerk limited ramps of the wheel PWM values.
+//
+
+#include "ChassisProfile.h"
+
+#define PROFILE_MAX_PERIOD        1000      // ms, longest tick
+#define PROFILE_MAX_STEP          (2L * PROFILE_PWM_LIMIT << PROFILE_Q)    // a full reversal in one tick
+
+ChassisProfileTable::ChassisProfileTable()
+{
+    setLimits(PROFILE_NONE, 0, 0, 1);
+}
+
+//
+// compute the step table, acceleration in pwm/s, jerk in pwm/s^2 and the tick in ms
+//
+bool ChassisProfileTable::setLimits(uint8_t newMode, uint16_t acceleration, uint16_t jerk, uint16_t period)
+{
+    if ((newMode > PROFILE_S_CURVE) || (period == 0) || (period > PROFILE_MAX_PERIOD) ||
+        ((newMode != PROFILE_NONE) && (acceleration == 0)) || ((newMode == PROFILE_S_CURVE) && (jerk == 0)))
+        return false;
+
+    mode     = newMode;
+    numSteps = 0;
+
+    if (mode == PROFILE_NONE) return true;
+
+    // Q7 speed change of a tick at full acceleration
+    uint32_t accelerationStep = (((uint32_t) acceleration * period) << PROFILE_Q) / 1000;
+
+    if (accelerationStep < 1) accelerationStep = 1;
+    if (accelerationStep > PROFILE_MAX_STEP) accelerationStep = PROFILE_MAX_STEP;
+
+    //
+    // ticks to build up the acceleration at the jerk limit: acceleration / (jerk * tick)
+    //
+    numSteps = 1;
+    if (mode == PROFILE_S_CURVE)
+    {
+        uint32_t jerkTicks = (uint32_t) jerk * period;
+        uint32_t ticks = (((uint32_t) acceleration * 1000) + jerkTicks - 1) / jerkTicks;
+
+        numSteps = (ticks > PROFILE_MAX_STEPS) ? PROFILE_MAX_STEPS : ((ticks < 1) ? 1 : ticks);
+    }
+
+    uint32_t sum = 0;
+
+    for (uint8_t i=0; i < numSteps; i++)
+    {
+        uint32_t step = (accelerationStep * (i + 1) + numSteps - 1) / numSteps;
+
+        sum      += step;
+        steps[i]  = step;
+        brakes[i] = (sum > 0xFFFF) ? 0xFFFF : sum;
+    }
+
+    return true;
+}
+
+uint8_t ChassisProfileTable::getMode() const
+{
+    return mode;
+}
+
+uint8_t ChassisProfileTable::getNumSteps() const
+{
+    return numSteps;
+}
+
+uint16_t ChassisProfileTable::step(uint8_t level) const
+{
+    return ((level == 0) || (level > numSteps)) ? 0 : steps[level - 1];
+}
+
+uint16_t ChassisProfileTable::brake(uint8_t level) const
+{
+    return ((level == 0) || (level > numSteps)) ? 0 : brakes[level - 1];
+}
+
+void ChassisRamp::setTarget(int16_t pwm)
+{
+    if (pwm > PROFILE_PWM_LIMIT)  pwm = PROFILE_PWM_LIMIT;
+    if (pwm < -PROFILE_PWM_LIMIT) pwm = -PROFILE_PWM_LIMIT;
+
+    target = pwm * (1 << PROFILE_Q);
+}
+
+void ChassisRamp::reset(int16_t pwm)
+{
+    setTarget(pwm);
+
+    value = target;
+    level = 0;
+}
+
+//
+// one tick of the ramp
+//
+int16_t ChassisRamp::update(const ChassisProfileTable &table)
+{
+    int32_t error     = (int32_t) target - value;
+    int8_t  direction = (error > 0) ? 1 : ((error < 0) ? -1 : 0);
+    uint8_t current   = (level < 0) ? -level : level;
+    uint8_t next;
+
+    if ((current > 0) && (direction != ((level > 0) ? 1 : -1)))
+    {
+        //
+        // moving the wrong way after a new target, ease out of the old direction first
+        //
+        direction = (level > 0) ? 1 : -1;
+        next      = current - 1;
+    }
+    else if (direction == 0)
+    {
+        return getValue();
+    }
+    else
+    {
+        //
+        // one level up when it can still brake in time, else hold or one level down
+        //
+        uint16_t remaining = (error < 0) ? -error : error;
+
+        next = (current < table.getNumSteps()) ? current + 1 : current;
+        while ((next > 1) && (next + 1 > current) && (table.brake(next) > remaining))
+            next--;
+
+        if (table.step(next) >= remaining)
+        {
+            value = target;
+            level = 0;
+            return getValue();
+        }
+    }
+
+    int32_t moved = (int32_t) value + direction * (int32_t) table.step(next);
+    int32_t limit = (int32_t) PROFILE_PWM_LIMIT << PROFILE_Q;
+
+    value = (moved > limit) ? limit : ((moved < -limit) ? -limit : moved);
+    level = direction * next;
+
+    return getValue();
+}
+
+//
+// the pwm, rounded the same way on both sides of 0 so a reversal has no double step
+//
+int16_t ChassisRamp::getValue() const
+{
+    return ((int32_t) value + (1 << (PROFILE_Q - 1))) >> PROFILE_Q;
+}
+
+int16_t ChassisRamp::getTarget() const
+{
+    return target >> PROFILE_Q;
+}
+
+bool ChassisRamp::isDone() const
+{
+    return (value == target) && (level == 0);
+}
@@ -0,0 +1,1221 @@
+//
+//  ChassisProgram.cpp
+//
+//
+//  Movement program compiler and interpreter for the Chassis class.
+//
+//  The command file is parsed and validated once into a compact opcode stream
+//  held in SRAM (see ChassisOpcode in Chassis.h). Every run cycle replays that
+//  stream without touching the SD card or the text parser again.
+//
+
+#include "Chassis.h"
+
+#define JUMP_TO_CALL_FILE         0x80      // target of a compiled jump is a CALLed file, not a label
+
+//
+// bookkeeping of a compile run, on the stack only while compiling
+//
+struct ChassisCompileLabel
+{
+    char     name[MAX_LABEL_LENGTH + 1];
+    uint8_t  file;                          // 0 = command file, n = n-th CALLed file
+    uint8_t  scope;                         // REPEAT the label is in, 0 = none
+    bool     defined;
+    uint16_t position;
+};
+
+struct ChassisCompileJump
+{
+    uint16_t operand;                       // program position of the target to fill in
+    uint16_t line;
+    uint8_t  target;                        // label, or CALLed file with JUMP_TO_CALL_FILE
+    uint8_t  file;
+    uint8_t  scope;
+};
+
+struct ChassisCompileState
+{
+    ChassisCompileLabel labels[MAX_PROGRAM_LABELS];
+    ChassisCompileJump  jumps[MAX_PROGRAM_JUMPS];
+    char                callFiles[MAX_CALL_FILES][MAX_FILE_NAME_LENGTH];
+    uint16_t            callPositions[MAX_CALL_FILES];
+    uint16_t            repeatOperands[MAX_CALL_DEPTH];     // of the open REPEATs, filled in at their END
+    uint8_t             repeatScopes[MAX_CALL_DEPTH];
+    uint8_t             numLabels;
+    uint8_t             numJumps;
+    uint8_t             numCallFiles;
+    uint8_t             repeatDepth;
+    uint8_t             numScopes;
+    uint8_t             file;                               // being compiled, 0 = command file
+};
+
+//
+// compile the configured command file into the program buffer
+//
+// nothing is compiled again when the command file did not change since it was last compiled.
+// When the program cache is enabled a previously compiled .BIN file next to the command file is
+// used as long as it matches the size and checksum of the command file, otherwise it is rebuilt
+//
+// returns true when every command compiled and the program fits in MAX_PROGRAM_SIZE
+// returns false otherwise, invalid commands are reported and skipped
+//
+bool Chassis::compileCommandFile()
+{
+    File cmdFile;
+
+    cmdFile = SD.open(commandFile);
+    if (!cmdFile)
+    {
+        LOG_ERROR(F("Chassis::compileCommandFile ERROR cannot open file: "), commandFile);
+        programLength   = 0;
+        numBlocks       = 0;
+        programSourceOk = false;
+        return false;
+    }
+
+    uint32_t sourceSize     = cmdFile.size();
+    uint16_t sourceChecksum = sourceFileChecksum(cmdFile);
+    bool     success        = true;
+
+    if (programSourceOk && (sourceSize == programSourceSize) && (sourceChecksum == programSourceChecksum))
+    {
+        // the program and its block index are still those of this file
+    }
+    else if (!programCache || !loadProgramCache(sourceSize, sourceChecksum))
+    {
+        ChassisReader reader(cmdFile);
+
+        success = compileCommandReader(reader);
+
+        // the checksum does not cover CALLed files, a program with sub-routes is not cached
+        if (success && programCache && !programCalls)
+            saveProgramCache(sourceSize, sourceChecksum);
+    }
+
+    cmdFile.close();
+
+    // a program with errors is compiled again next time, so the errors are reported again
+    programSourceOk       = success && !programCalls;
+    programSourceSize     = sourceSize;
+    programSourceChecksum = sourceChecksum;
+
+    return success;
+}
+
+//
+// compile movement blocks read from a Stream into the program buffer, replacing the program
+//
+// returns true when every command compiled and the program fits in MAX_PROGRAM_SIZE
+// returns false otherwise
+//
+bool Chassis::compileCommandStream(Stream &source)
+{
+    ChassisReader reader(source);
+
+    return compileCommandReader(reader);
+}
+
+bool Chassis::compileCommandReader(ChassisReader &reader)
+{
+    ChassisCompileState state;
+    bool                success;
+
+    memset(&state, 0, sizeof(state));
+
+    programLength   = 0;
+    programOverflow = false;
+    programSourceOk = false;
+    numBlocks       = 0;
+
+    success = compileLines(reader, state);
+
+    //
+    // sub-routes follow the main program, every file is compiled once however often it is CALLed.
+    // numCallFiles grows while the sub-routes CALL files of their own
+    //
+    if (state.numCallFiles > 0) emitByte(OP_END_OF_PROGRAM);
+
+    for (uint8_t file=0; (file < state.numCallFiles) && !programOverflow; file++)
+        success = compileCallFile(state, file) && success;
+
+    success = resolveJumps(state) && success;
+    programCalls = (state.numCallFiles > 0);
+
+    if (programOverflow)
+    {
+        LOG_ERROR(F("Chassis::compileCommandFile ERROR program exceeds "), MAX_PROGRAM_SIZE, F(" bytes"));
+        programLength = 0;
+        numBlocks     = 0;
+        success = false;
+    }
+
+    return success;
+}
+
+//
+// compile the lines of the main command file or of a CALLed file
+//
+// the main file only compiles what is inside <MOVEMENT> blocks, a CALLed file is a sub-route and
+// compiles every line, block markers in it are ignored
+//
+bool Chassis::compileLines(ChassisReader &reader, ChassisCompileState &state)
+{
+    bool        success    = true;
+    bool        subRoute   = (state.file > 0);
+    bool        inBlock    = subRoute;
+    bool        truncated  = false;
+    uint16_t    blockStart = 0;
+    uint16_t    blockSum1  = 0;
+    uint16_t    blockSum2  = 0;
+    int         lineNumber = 0;
+    ChassisText lineText;
+
+    while (!programOverflow && reader.next('\n', lineText, truncated))
+    {
+        lineNumber++;
+
+        if (truncated)
+        {
+            LOG_ERROR(F("Chassis::compileCommandFile ERROR line "), lineNumber, F(" too long"));
+            success = false;
+            continue;
+        }
+
+        ChassisTokenizer   tokenizer(lineText.text, lineText.length, '\n');
+        ChassisStatement   statement;
+        ChassisParseResult result = tokenizer.next(statement);
+
+        if (result == PARSE_END) continue;
+
+        if (result == PARSE_ERROR)
+        {
+            LOG_ERROR(F("Chassis::compileCommandFile ERROR line "), lineNumber, ' ', LOG_FLASH(tokenizer.getError()));
+            success = false;
+            continue;
+        }
+
+        statement.line = lineNumber;
+
+        if (chassisTextEquals(statement.key, START_BLOCK_IDENTIFIER))
+        {
+            if (subRoute) continue;
+
+            inBlock = true;
+            blockStart = programLength;
+            blockSum1 = blockSum2 = 0;
+        }
+        else if (chassisTextEquals(statement.key, END_BLOCK_IDENTIFIER))
+        {
+            if (subRoute) continue;
+
+            if (inBlock)
+            {
+                success = closeRepeats(state) && success;
+
+                emitByte(OP_END_OF_BLOCK);
+                indexBlock(blockStart, (blockSum2 << 8) | blockSum1);
+            }
+            inBlock = false;
+        }
+        else if (inBlock)
+        {
+            // the block hash leaves out line ends, a file saved with other line ends hashes the same
+            uint8_t length = lineText.length;
+
+            if ((length > 0) && (lineText.text[length - 1] == '\r')) length--;
+            fletcher16(blockSum1, blockSum2, (const uint8_t *) lineText.text, length);
+
+            int8_t control = chassisFindControl(statement.key);
+
+            if (control >= 0)
+                success = compileControl(statement, control, state) && success;
+            else
+                success = compileCommand(statement) && success;
+        }
+    }
+
+    if (subRoute)
+    {
+        success = closeRepeats(state) && success;
+    }
+    else if (inBlock)
+    {
+        //
+        // an unterminated block is never executed, drop what we compiled of it
+        //
+        LOG_ERROR(F("Chassis::compileCommandFile ERROR missing " END_BLOCK_IDENTIFIER " at end of file"));
+        programLength = blockStart;
+        state.repeatDepth = 0;
+        success = false;
+    }
+
+    return success;
+}
+
+//
+// a REPEAT ends within its block or sub-route
+//
+bool Chassis::closeRepeats(ChassisCompileState &state)
+{
+    if (state.repeatDepth == 0) return true;
+
+    LOG_ERROR(F("Chassis::compileCommandFile ERROR missing END of "), state.repeatDepth, F(" REPEAT"));
+    state.repeatDepth = 0;
+
+    return false;
+}
+
+//
+// compile REPEAT, END, LABEL, GOTO and CALL
+//
+// GOTO and CALL are emitted with a placeholder, resolveJumps() fills in their targets once all
+// labels and sub-routes are known. A REPEAT is patched with the position behind its END
+//
+bool Chassis::compileControl(const ChassisStatement &statement, int8_t control, ChassisCompileState &state)
+{
+    const ChassisText &value = statement.items[0];
+    uint8_t            scope = (state.repeatDepth > 0) ? state.repeatScopes[state.repeatDepth - 1] : 0;
+    long               count = 0;
+
+    if ((control != CTRL_END) && (statement.valueType != VALUE_SCALAR))
+    {
+        LOG_ERROR(F("Chassis::compileCommandFile ERROR line "), statement.line, F(" missing argument for "), LOG_FLASH(chassisControlName(control)));
+        return false;
+    }
+
+    switch (control)
+    {
+        case CTRL_REPEAT:
+            if (!chassisTextToInt(value, count) || (count < 0) || (count > 0x7FFF)) break;
+
+            if (state.repeatDepth >= MAX_CALL_DEPTH)
+            {
+                LOG_ERROR(F("Chassis::compileCommandFile ERROR line "), statement.line, F(" REPEAT nested too deep"));
+                return false;
+            }
+
+            emitByte(OP_REPEAT);
+            emitWord(count);
+            state.repeatOperands[state.repeatDepth] = programLength;
+            state.repeatScopes[state.repeatDepth]   = ++state.numScopes;
+            state.repeatDepth++;
+            emitWord(0);
+            return true;
+
+        case CTRL_END:
+            if (state.repeatDepth == 0)
+            {
+                LOG_ERROR(F("Chassis::compileCommandFile ERROR line "), statement.line, F(" END without REPEAT"));
+                return false;
+            }
+
+            emitByte(OP_END_REPEAT);
+            state.repeatDepth--;
+            patchWord(state.repeatOperands[state.repeatDepth], programLength);
+            return true;
+
+        case CTRL_LABEL:
+        {
+            int8_t label = findLabel(state, value);
+
+            if (label < 0) break;
+
+            if (state.labels[label].defined)
+            {
+                LOG_ERROR(F("Chassis::compileCommandFile ERROR line "), statement.line, F(" duplicate LABEL "), value);
+                return false;
+            }
+
+            state.labels[label].defined  = true;
+            state.labels[label].position = programLength;
+            state.labels[label].scope    = scope;
+            return true;
+        }
+
+        case CTRL_GOTO:
+        case CTRL_CALL:
+        {
+            int8_t target = (control == CTRL_GOTO) ? findLabel(state, value) : findCallFile(state, value);
+
+            if (target < 0) break;
+
+            if (state.numJumps >= MAX_PROGRAM_JUMPS)
+            {
+                LOG_ERROR(F("Chassis::compileCommandFile ERROR line "), statement.line, F(" more than "), MAX_PROGRAM_JUMPS, F(" GOTO and CALL"));
+                return false;
+            }
+
+            ChassisCompileJump &jump = state.jumps[state.numJumps++];
+
+            jump.operand = programLength + 1;
+            jump.line    = statement.line;
+            jump.target  = target | ((control == CTRL_CALL) ? JUMP_TO_CALL_FILE : 0);
+            jump.file    = state.file;
+            jump.scope   = scope;
+
+            emitByte((control == CTRL_GOTO) ? OP_GOTO : OP_CALL);
+            emitWord(0);
+            return true;
+        }
+    }
+
+    LOG_ERROR(F("Chassis::compileCommandFile ERROR line "), statement.line, F(" invalid arguments for "), LOG_FLASH(chassisControlName(control)));
+    return false;
+}
+
+//
+// the label of a name in the current file, added when new. -1 when the name is too long or the table is full
+//
+int8_t Chassis::findLabel(ChassisCompileState &state, const ChassisText &name)
+{
+    if ((name.length == 0) || (name.length > MAX_LABEL_LENGTH)) return -1;
+
+    for (uint8_t label=0; label < state.numLabels; label++)
+        if ((state.labels[label].file == state.file) && chassisTextEquals(name, state.labels[label].name))
+            return label;
+
+    if (state.numLabels >= MAX_PROGRAM_LABELS) return -1;
+
+    ChassisCompileLabel &label = state.labels[state.numLabels];
+
+    memcpy(label.name, name.text, name.length);
+    label.name[name.length] = '\0';
+    label.file = state.file;
+
+    return state.numLabels++;
+}
+
+//
+// the sub-route of a file name, added when new. -1 when the name is too long or the table is full
+//
+int8_t Chassis::findCallFile(ChassisCompileState &state, const ChassisText &name)
+{
+    if ((name.length == 0) || (name.length >= MAX_FILE_NAME_LENGTH)) return -1;
+
+    for (uint8_t file=0; file < state.numCallFiles; file++)
+        if (chassisTextEquals(name, state.callFiles[file]))
+            return file;
+
+    if (state.numCallFiles >= MAX_CALL_FILES) return -1;
+
+    memcpy(state.callFiles[state.numCallFiles], name.text, name.length);
+    state.callFiles[state.numCallFiles][name.length] = '\0';
+
+    return state.numCallFiles++;
+}
+
+//
+// compile a CALLed file behind the program, a sub-route ends with a RETURN
+//
+bool Chassis::compileCallFile(ChassisCompileState &state, uint8_t file)
+{
+    File callFile = SD.open(state.callFiles[file]);
+
+    if (!callFile)
+    {
+        LOG_ERROR(F("Chassis::compileCommandFile ERROR cannot open file: "), state.callFiles[file]);
+        return false;
+    }
+
+    state.callPositions[file] = programLength;
+    state.file = file + 1;
+
+    ChassisReader reader(callFile);
+    bool          success = compileLines(reader, state);
+
+    emitByte(OP_RETURN);
+    callFile.close();
+
+    if (!success)
+        LOG_ERROR(F("Chassis::compileCommandFile ERROR in called file "), state.callFiles[file]);
+
+    return success;
+}
+
+//
+// fill in the targets of all GOTOs and CALLs
+//
+// a GOTO stays within its file and its REPEAT, so the REPEATs and CALLs on the stack of the
+// executor always end in the order they started
+//
+bool Chassis::resolveJumps(ChassisCompileState &state)
+{
+    bool success = true;
+
+    for (uint8_t i=0; i < state.numJumps; i++)
+    {
+        ChassisCompileJump &jump = state.jumps[i];
+
+        if (jump.target & JUMP_TO_CALL_FILE)
+        {
+            patchWord(jump.operand, state.callPositions[jump.target & ~JUMP_TO_CALL_FILE]);
+            continue;
+        }
+
+        ChassisCompileLabel &label = state.labels[jump.target];
+
+        if (!label.defined)
+        {
+            LOG_ERROR(F("Chassis::compileCommandFile ERROR line "), jump.line, F(" undefined LABEL "), label.name);
+            success = false;
+        }
+        else if (label.scope != jump.scope)
+        {
+            LOG_ERROR(F("Chassis::compileCommandFile ERROR line "), jump.line, F(" GOTO "), label.name, F(" into or out of a REPEAT"));
+            success = false;
+        }
+        else
+            patchWord(jump.operand, label.position);
+    }
+
+    return success;
+}
+
+//
+// compile a single command statement into the program
+//
+// returns false when the command is invalid, nothing is emitted in that case
+//
+bool Chassis::compileCommand(const ChassisStatement &statement)
+{
+    ChassisParsedCommand parsed;
+
+    switch (chassisParseCommand(statement, parsed))
+    {
+        case COMMAND_OK:
+            break;
+
+        case COMMAND_UNKNOWN:
+            LOG_ERROR(F("Chassis::compileCommandFile ERROR line "), statement.line, F(" invalid command"));
+            return false;
+
+        case COMMAND_MISSING_VALUE:
+            LOG_ERROR(F("Chassis::compileCommandFile ERROR line "), statement.line, F(" missing argument for "), LOG_FLASH(chassisCommandName(parsed.command)));
+            return false;
+
+        default:
+            LOG_ERROR(F("Chassis::compileCommandFile ERROR line "), statement.line, F(" invalid arguments for "), LOG_FLASH(chassisCommandName(parsed.command)));
+            return false;
+    }
+
+    //
+    // the program keeps the operands at their natural size, LIGHTS fits a byte
+    //
+    emitByte(parsed.command);
+
+    if (parsed.command == OP_LIGHTS)
+        emitByte(parsed.args[0]);
+    else
+        for (uint8_t i=0; i < parsed.numArgs; i++)
+            emitWord(parsed.args[i]);
+
+    return true;
+}
+
+//
+// add a compiled block to the block index, blocks beyond MAX_PROGRAM_BLOCKS run but cannot be started directly
+//
+void Chassis::indexBlock(uint16_t offset, uint16_t hash)
+{
+    if (numBlocks >= MAX_PROGRAM_BLOCKS)
+    {
+        LOG_WARNING(F("Chassis::compileCommandFile WARNING block "), numBlocks, F(" not indexed"));
+        return;
+    }
+
+    blocks[numBlocks].offset = offset;
+    blocks[numBlocks].hash   = hash;
+    numBlocks++;
+}
+
+//
+// Fletcher-16 of the command file and of the blocks, sum2 is the high byte of the result
+//
+void Chassis::fletcher16(uint16_t &sum1, uint16_t &sum2, const uint8_t *data, uint16_t length)
+{
+    for (uint16_t i=0; i < length; i++)
+    {
+        sum1 = (sum1 + data[i]) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+}
+
+//
+// program emitters, the overflow flag is checked once at the end of compilation
+//
+void Chassis::emitByte(uint8_t value)
+{
+    if (programLength < MAX_PROGRAM_SIZE)
+        program[programLength++] = value;
+    else
+        programOverflow = true;
+}
+
+void Chassis::emitWord(int value)
+{
+    emitByte(value & 0xFF);
+    emitByte((value >> 8) & 0xFF);
+}
+
+//
+// fill in an operand emitted before, nothing to do when the program overflowed before it
+//
+void Chassis::patchWord(uint16_t position, uint16_t value)
+{
+    if ((position + 1) < programLength)
+    {
+        program[position]     = value & 0xFF;
+        program[position + 1] = (value >> 8) & 0xFF;
+    }
+}
+
+int Chassis::readProgramWord(uint16_t pc)
+{
+    return (int16_t) (program[pc] | (program[pc+1] << 8));
+}
+
+//
+// start executing the compiled program for the configured number of run cycles
+//
+// the first cycle starts at the given block of the block index, later cycles start at the first
+// block. The program advances from update(), which has to be called from loop()
+//
+// returns false when there is no program or block, or the chassis is in manual mode
+//
+bool Chassis::startProgram(uint8_t block)
+{
+    if ((programLength == 0) || (runCycles <= 0) || manualMode)
+        return false;
+
+    if ((block > 0) && (block >= numBlocks))
+        return false;
+
+    programCounter = (block > 0) ? blocks[block].offset : 0;
+    callDepth      = 0;
+    cyclesDone     = 0;
+    executorState  = EXEC_RUNNING;
+    programRunning = true;
+
+    LOG_DEBUG(F("START CYCLE 0"));
+
+    return true;
+}
+
+//
+// advance the program executor, never waits for a command
+//
+// at most one instruction is executed per call, DURATION and DISTANCE are checked against
+// their deadline / distance target and return straight away when not reached yet
+//
+// the output is what a call can block on. With wire output queued a call sends one frame,
+// which holds the bus for up to about 3 ms at 100 kHz (Wire has no non-blocking transmit).
+// Telemetry is only written as far as availableForWrite() reports room, on an output without
+// a transmit buffer, e.g. SoftwareSerial, that is one byte per call: about 1 ms at 9600 baud
+//
+void Chassis::update()
+{
+    //
+    // the speed controller steps at a fixed rate, also when no program is running
+    //
+    if ((long) (millis() - nextSpeedTick) >= 0)
+    {
+        speedControlTick();
+
+        // after a stall carry on from now instead of catching up with a burst of steps
+        nextSpeedTick += SPEED_CONTROL_PERIOD;
+        if ((long) (millis() - nextSpeedTick) >= 0) nextSpeedTick = millis() + SPEED_CONTROL_PERIOD;
+    }
+
+    // ramps of the motion profile, only while the wheels have not reached their pwm
+    if (rampsActive && ((long) (millis() - nextProfileTick) >= 0))
+    {
+        profileTick();
+
+        nextProfileTick += PROFILE_PERIOD;
+        if ((long) (millis() - nextProfileTick) >= 0) nextProfileTick = millis() + PROFILE_PERIOD;
+    }
+
+    // queued wire output, one frame per call
+    sendWireFrame();
+
+    // status frames at the telemetry rate, skipped rather than sent in a burst after a stall
+    // or while the frame before is still going out
+    if (telemetryPeriod && ((long) (millis() - nextTelemetry) >= 0))
+    {
+        if (telemetrySent >= telemetryLength)
+        {
+            telemetryLength = getTelemetryFrame(telemetryFrame);
+            telemetrySent   = 0;
+        }
+
+        nextTelemetry += telemetryPeriod;
+        if ((long) (millis() - nextTelemetry) >= 0) nextTelemetry = millis() + telemetryPeriod;
+    }
+
+    sendTelemetry();
+
+    if (executorState == EXEC_IDLE) return;
+
+    //
+    // switching to manual mode preempts the program within one tick, a command sent by a
+    // front end in manual mode is left to finish its DURATION or DISTANCE
+    //
+    if (manualMode && programRunning)
+    {
+        abort();
+        return;
+    }
+
+    switch (executorState)
+    {
+        case EXEC_RUNNING:
+            if (programCounter < programLength)
+            {
+                programCounter = executeInstruction(programCounter);
+            }
+            else if (++cyclesDone < runCycles)
+            {
+                LOG_DEBUG(F("START CYCLE "), cyclesDone);
+
+                programCounter = 0;
+                callDepth      = 0;
+            }
+            else
+            {
+                LOG_DEBUG(F("END PROGRAM"));
+
+                executorState  = EXEC_IDLE;
+                programRunning = false;
+            }
+            break;
+
+        case EXEC_WAIT_DURATION:
+            if ((millis() - waitStart) >= waitDuration)
+            {
+                bool lights[NUM_LIGHT_PINS] = {false, false, false, false};
+
+                doFullStop();            // always a fullStop after a duration
+                switchLightsOn(lights);  // switch off the lights
+                executorState = programRunning ? EXEC_RUNNING : EXEC_IDLE;
+            }
+            break;
+
+        case EXEC_WAIT_DISTANCE:
+            if (!isMoving())
+            {
+                resetCumulativeDistances();
+
+                doFullStop();
+                executorState = programRunning ? EXEC_RUNNING : EXEC_IDLE;
+            }
+            break;
+    }
+}
+
+//
+// is a program or the wait of a command being executed?
+//
+bool Chassis::isBusy()
+{
+    return executorState != EXEC_IDLE;
+}
+
+//
+// stop the running program or command and the chassis
+//
+void Chassis::abort()
+{
+    programRunning = false;
+
+    if (executorState != EXEC_IDLE)
+    {
+        int directions[NUM_WHEELS] = {0, 0, 0, 0};
+
+        // not ramped, an abort stops at once
+        executorState = EXEC_IDLE;
+        driveWheels(directions, false);
+    }
+}
+
+//
+// continue the running program at the start of a block, the current movement is stopped
+//
+// returns false when no program is running or the block is not in the block index
+//
+bool Chassis::jumpToBlock(uint8_t block)
+{
+    if (!programRunning || (block >= numBlocks))
+        return false;
+
+    doFullStop();
+
+    programCounter = blocks[block].offset;
+    callDepth      = 0;
+    executorState  = EXEC_RUNNING;
+
+    return true;
+}
+
+//
+// block index, filled while compiling. The hash is the Fletcher-16 of the command lines of the
+// block without line ends, so a front end can tell which blocks of a file were edited
+//
+uint8_t Chassis::getNumBlocks()
+{
+    return numBlocks;
+}
+
+uint16_t Chassis::getBlockHash(uint8_t block)
+{
+    return (block < numBlocks) ? blocks[block].hash : 0;
+}
+
+//
+// the block the program is in, -1 when no program is running
+//
+int Chassis::getCurrentBlock()
+{
+    int block = numBlocks - 1;
+
+    if (!programRunning) return -1;
+
+    while ((block > 0) && (blocks[block].offset > programCounter))
+        block--;
+
+    return block;
+}
+
+//
+// run the compiled program for the configured number of cycles or until manual mode is set
+//
+// convenience for sketches that have nothing else to do, blocks until the program is done
+//
+void Chassis::runProgram()
+{
+    if (startProgram())
+        while (isBusy())
+            update();
+}
+
+//
+// execute a command of a front end (BLE, I2C, serial) straight away
+//
+// a DURATION or DISTANCE still waiting from an earlier front end command is replaced, a
+// running program is not interrupted. Meant for manual mode, update() completes the waits
+//
+// returns false when the command id, the number of operands or an operand value is wrong,
+// the operand ranges are those of ChassisCommands.h
+//
+bool Chassis::execute(const ChassisParsedCommand &command)
+{
+    if (!chassisCommandInRange(command))
+    {
+        LOG_ERROR(F("Chassis::execute ERROR invalid command "), command.command);
+        return false;
+    }
+
+    if (!programRunning) executorState = EXEC_IDLE;
+
+    dispatchCommand(command);
+    return true;
+}
+
+bool Chassis::execute(uint8_t commandId, const int16_t *args, uint8_t numArgs)
+{
+    ChassisParsedCommand command;
+
+    if (numArgs > MAX_COMMAND_ARGS) numArgs = MAX_COMMAND_ARGS + 1;   // rejected by execute()
+
+    command.command = commandId;
+    command.numArgs = numArgs;
+
+    for (uint8_t i=0; i < MAX_COMMAND_ARGS; i++)
+        command.args[i] = (i < numArgs) ? args[i] : 0;
+
+    return execute(command);
+}
+
+//
+// parse and execute one command line in command file syntax, e.g. "WHEELS = (100, 100, 100, 100)"
+//
+// returns false when the line is not a valid command, the error is logged
+//
+bool Chassis::executeLine(const char *line, int length)
+{
+    ChassisTokenizer     tokenizer(line, length, '\n');
+    ChassisStatement     statement;
+    ChassisParsedCommand command;
+
+    if (tokenizer.next(statement) != PARSE_OK)
+    {
+        if (tokenizer.getError() != NULL)
+            LOG_ERROR(F("Chassis::executeLine ERROR "), LOG_FLASH(tokenizer.getError()));
+        else
+            LOG_ERROR(F("Chassis::executeLine ERROR empty line"));
+        return false;
+    }
+
+    switch (chassisParseCommand(statement, command))
+    {
+        case COMMAND_OK:
+            return execute(command);
+
+        case COMMAND_UNKNOWN:
+            LOG_ERROR(F("Chassis::executeLine ERROR invalid command"));
+            return false;
+
+        default:
+            LOG_ERROR(F("Chassis::executeLine ERROR invalid arguments for "), LOG_FLASH(chassisCommandName(command.command)));
+            return false;
+    }
+}
+
+//
+// the one dispatch of a parsed command, used by the program executor and the front ends
+//
+// the command ids are dense from 0, so the switch compiles to a jump table. DURATION and
+// DISTANCE only set up the wait, update() completes them
+//
+void Chassis::dispatchCommand(const ChassisParsedCommand &command)
+{
+    switch (command.command)
+    {
+        case CMD_WHEELS:
+        {
+            int movements[NUM_WHEELS];
+
+            for (int wheel=0; wheel < NUM_WHEELS; wheel++)
+                movements[wheel] = command.args[wheel];
+
+            moveWheels(movements);
+            break;
+        }
+
+        case CMD_FORWARD:
+            moveForward(command.args[0]);
+            break;
+
+        case CMD_BACKWARD:
+            moveBackwards(command.args[0]);
+            break;
+
+        case CMD_FULLSTOP:
+            doFullStop();
+            break;
+
+        case CMD_ROTATE:
+            // waits for the rotation like a DISTANCE, no DURATION needed
+            if (doRotate(command.args[0]))
+                executorState = EXEC_WAIT_DISTANCE;
+            break;
+
+        case CMD_LIGHTS:
+        {
+            bool lights[NUM_LIGHT_PINS];
+
+            for (int light=0; light < NUM_LIGHT_PINS; light++)
+                lights[light] = command.args[0] & (1 << light);
+
+            switchLightsOn(lights);
+            break;
+        }
+
+        case CMD_DURATION:
+            waitStart     = millis();
+            waitDuration  = (uint16_t) command.args[0] | ((unsigned long) (uint16_t) command.args[1] << 16);
+            executorState = EXEC_WAIT_DURATION;
+            break;
+
+        case CMD_DISTANCE:
+            // the current movement continues for the distance, input is in cm -> target in mm
+            if (moveDistance(command.args[0] * 10L))
+                executorState = EXEC_WAIT_DISTANCE;
+            break;
+    }
+}
+
+//
+// execute the instruction at pc, returns the position of the next instruction
+//
+// the operands of a command are decoded into a ChassisParsedCommand and dispatched like any other
+// command, DURATION, DISTANCE and ROTATE only set up the wait, update() completes them
+//
+uint16_t Chassis::executeInstruction(uint16_t pc)
+{
+    ChassisParsedCommand parsed;
+
+    parsed.command = program[pc++];
+
+    if (parsed.command >= NUM_OF_COMMANDS)
+        return executeControl(parsed.command, pc);
+
+    parsed.numArgs = chassisCommandArgs(parsed.command);
+
+    if (!inProgram(pc, (parsed.command == OP_LIGHTS) ? 1 : parsed.numArgs * 2))
+        return invalidProgram(pc);
+
+    if (parsed.command == OP_LIGHTS)
+    {
+        parsed.args[0] = program[pc++];
+    }
+    else
+    {
+        for (uint8_t i=0; i < parsed.numArgs; i++, pc += 2)
+            parsed.args[i] = readProgramWord(pc);
+    }
+
+    // compiled operands are in range, a damaged .BIN cache may not be
+    if (!chassisCommandInRange(parsed))
+        return invalidProgram(pc);
+
+    dispatchCommand(parsed);
+
+    return pc;
+}
+
+//
+// execute a control flow instruction, pc is behind its opcode
+//
+// REPEATs and CALLs share a stack of MAX_CALL_DEPTH frames. A REPEAT frame holds the start of its
+// body and the rounds left, a CALL frame the return position and no rounds
+//
+// the compiler only emits valid control flow, the operands, targets and frames are checked anyway
+// as a damaged .BIN cache reaches this as well. The end of a REPEAT may be the end of the program
+//
+uint16_t Chassis::executeControl(uint8_t opcode, uint16_t pc)
+{
+    switch (opcode)
+    {
+        case OP_END_OF_BLOCK:
+            return pc;
+
+        case OP_REPEAT:
+        {
+            if (!inProgram(pc, 4)) return invalidProgram(pc);
+
+            int      count = readProgramWord(pc);
+            uint16_t end   = readProgramWord(pc + 2);
+
+            if (end > programLength) return invalidProgram(pc);
+
+            pc += 4;
+            if (count <= 0) return end;
+            if (!pushFrame(pc, count)) return programLength;
+            return pc;
+        }
+
+        case OP_END_REPEAT:
+        {
+            if ((callDepth == 0) || (callStack[callDepth - 1].remaining == 0)) return invalidProgram(pc);
+
+            ChassisStackFrame &frame = callStack[callDepth - 1];
+
+            if (--frame.remaining > 0) return frame.position;
+
+            callDepth--;
+            return pc;
+        }
+
+        case OP_GOTO:
+        case OP_CALL:
+        {
+            if (!inProgram(pc, 2)) return invalidProgram(pc);
+
+            uint16_t target = readProgramWord(pc);
+
+            if (target >= programLength) return invalidProgram(pc);
+            if ((opcode == OP_CALL) && !pushFrame(pc + 2, 0)) return programLength;
+            return target;
+        }
+
+        case OP_RETURN:
+            if ((callDepth == 0) || (callStack[callDepth - 1].remaining != 0)) return invalidProgram(pc);
+
+            return callStack[--callDepth].position;
+
+        case OP_END_OF_PROGRAM:
+            return programLength;
+    }
+
+    LOG_ERROR(F("Chassis::executeInstruction ERROR invalid opcode "), opcode);
+    return programLength;
+}
+
+//
+// are the size bytes of operands from pc on within the program?
+//
+bool Chassis::inProgram(uint16_t pc, uint8_t size)
+{
+    return ((uint32_t) pc + size) <= programLength;
+}
+
+//
+// end the program on an instruction the compiler cannot have emitted
+//
+uint16_t Chassis::invalidProgram(uint16_t pc)
+{
+    LOG_ERROR(F("Chassis::executeInstruction ERROR invalid program at "), pc, F(", program aborted"));
+    abort();
+    return programLength;
+}
+
+//
+// push a REPEAT or CALL frame, a CALL nesting too deep (e.g. a sub-route CALLing itself) aborts the program
+//
+bool Chassis::pushFrame(uint16_t position, uint16_t remaining)
+{
+    if (callDepth >= MAX_CALL_DEPTH)
+    {
+        LOG_ERROR(F("Chassis::executeInstruction ERROR more than "), MAX_CALL_DEPTH, F(" nested REPEAT and CALL"));
+        abort();
+        return false;
+    }
+
+    callStack[callDepth].position  = position;
+    callStack[callDepth].remaining = remaining;
+    callDepth++;
+
+    return true;
+}
+
+//
+// set the use of the .BIN program cache next to the command file
+//
+void Chassis::setProgramCache(bool setting)
+{
+    programCache = setting;
+}
+
+//
+// return the size of the compiled program in bytes
+//
+int Chassis::getProgramLength()
+{
+    return programLength;
+}
+
+//
+// the cache file name is the command file name with its extension replaced by PROGRAM_CACHE_EXTENSION
+//
+void Chassis::programCacheName(char name[MAX_FILE_NAME_LENGTH + sizeof(PROGRAM_CACHE_EXTENSION)])
+{
+    const char *dot   = strrchr(commandFile, '.');
+    const char *slash = strrchr(commandFile, '/');
+    size_t      base  = (dot && (!slash || (dot > slash))) ? (size_t) (dot - commandFile) : strlen(commandFile);
+
+    memcpy(name, commandFile, base);
+    strcpy(name + base, PROGRAM_CACHE_EXTENSION);
+}
+
+//
+// Fletcher-16 checksum over a command or configuration file, leaves the file positioned at its start
+//
+uint16_t Chassis::sourceFileChecksum(File &sourceFile)
+{
+    uint8_t  chunk[32];
+    uint16_t sum1 = 0;
+    uint16_t sum2 = 0;
+    int      numRead;
+
+    while ((numRead = sourceFile.read(chunk, sizeof(chunk))) > 0)
+        fletcher16(sum1, sum2, chunk, numRead);
+
+    sourceFile.seek(0);
+
+    return (sum2 << 8) | sum1;
+}
+
+//
+// CRC-8 of the block index and the program, chassisCrc8() takes at most 255 bytes at a time
+//
+static uint8_t programCacheCrc(const void *index, int indexSize, const uint8_t *code, uint16_t codeLength)
+{
+    uint8_t crc = chassisCrc8((const uint8_t *) index, indexSize);
+
+    for (uint16_t done = 0; done < codeLength; done += 255)
+        crc = chassisCrc8(code + done, ((codeLength - done) > 255) ? 255 : (codeLength - done), crc);
+
+    return crc;
+}
+
+//
+// cache layout: magic, version, source size (4), source checksum (2), program length (2), number of
+// blocks (1), the block index in the byte order of the device, program, CRC-8 of the block index and
+// program
+//
+// returns true when a cache matching the command file was loaded into the program buffer
+//
+bool Chassis::loadProgramCache(uint32_t sourceSize, uint16_t sourceChecksum)
+{
+    bool success = false;
+    char binName[MAX_FILE_NAME_LENGTH + sizeof(PROGRAM_CACHE_EXTENSION)];
+
+    programCacheName(binName);
+
+    File binFile = SD.open(binName);
+
+    if (binFile)
+    {
+        uint8_t header[11];
+
+        if (binFile.read(header, sizeof(header)) == sizeof(header))
+        {
+            uint32_t cachedSize     = header[2] | ((uint32_t) header[3] << 8) | ((uint32_t) header[4] << 16) | ((uint32_t) header[5] << 24);
+            uint16_t cachedChecksum = header[6] | (header[7] << 8);
+            uint16_t cachedLength   = header[8] | (header[9] << 8);
+            uint8_t  cachedBlocks   = header[10];
+            int      indexSize      = cachedBlocks * sizeof(ChassisBlockEntry);
+
+            if ((header[0] == PROGRAM_CACHE_MAGIC) && (header[1] == PROGRAM_CACHE_VERSION) &&
+                (cachedSize == sourceSize) && (cachedChecksum == sourceChecksum) &&
+                (cachedLength <= MAX_PROGRAM_SIZE) && (cachedBlocks <= MAX_PROGRAM_BLOCKS))
+            {
+                success = (binFile.read(blocks, indexSize) == indexSize) &&
+                          (binFile.read(program, cachedLength) == (int) cachedLength) &&
+                          (binFile.read() == programCacheCrc(blocks, indexSize, program, cachedLength));
+
+                for (uint8_t i=0; success && (i < cachedBlocks); i++)
+                    success = blocks[i].offset < cachedLength;
+
+                programLength = success ? cachedLength : 0;
+                numBlocks     = success ? cachedBlocks : 0;
+                programCalls  = false;
+            }
+        }
+
+        binFile.close();
+    }
+
+    return success;
+}
+
+void Chassis::saveProgramCache(uint32_t sourceSize, uint16_t sourceChecksum)
+{
+    char binName[MAX_FILE_NAME_LENGTH + sizeof(PROGRAM_CACHE_EXTENSION)];
+
+    programCacheName(binName);
+
+    SD.remove(binName);
+
+    File binFile = SD.open(binName, FILE_WRITE);
+    if (!binFile)
+    {
+        LOG_ERROR(F("Chassis::compileCommandFile ERROR cannot write program cache: "), binName);
+        return;
+    }
+
+    uint8_t header[11] = {
+        PROGRAM_CACHE_MAGIC, PROGRAM_CACHE_VERSION,
+        (uint8_t) sourceSize, (uint8_t) (sourceSize >> 8), (uint8_t) (sourceSize >> 16), (uint8_t) (sourceSize >> 24),
+        (uint8_t) sourceChecksum, (uint8_t) (sourceChecksum >> 8),
+        (uint8_t) programLength, (uint8_t) (programLength >> 8),
+        numBlocks
+    };
+
+    binFile.write(header, sizeof(header));
+    binFile.write((const uint8_t *) blocks, numBlocks * sizeof(ChassisBlockEntry));
+    binFile.write(program, programLength);
+    binFile.write(programCacheCrc(blocks, numBlocks * sizeof(ChassisBlockEntry), program, programLength));
+    binFile.close();
+}
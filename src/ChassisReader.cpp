@@ -0,0 +1,124 @@
+//
+//  ChassisReader.cpp
+//
+//
+//  Block buffered statement reader for the configuration and command files.
+//
+
+#include "ChassisReader.h"
+
+char ChassisReader::buffer[READER_BUFFER_SIZE];
+
+ChassisReader::ChassisReader(File &source) :
+    file(&source), stream(NULL), start(0), end(0), endOfSource(false), skipping(false), bytesRead(0)
+{
+}
+
+ChassisReader::ChassisReader(Stream &source) :
+    file(NULL), stream(&source), start(0), end(0), endOfSource(false), skipping(false), bytesRead(0)
+{
+}
+
+uint32_t ChassisReader::getBytesRead()
+{
+    return bytesRead;
+}
+
+//
+// move the unread tail to the front and read the next block behind it
+//
+// returns false when the source has no more bytes
+//
+bool ChassisReader::fill()
+{
+    uint16_t pending = end - start;
+    int      numRead = 0;
+
+    memmove(buffer, buffer + start, pending);
+    start = 0;
+    end   = pending;
+
+    if (file)
+    {
+        numRead = file->read(buffer + end, READER_BLOCK_SIZE);
+        if (numRead < 0) numRead = 0;
+    }
+    else
+    {
+        int c;
+
+        while ((numRead < READER_BLOCK_SIZE) && ((c = stream->read()) >= 0))
+            buffer[end + numRead++] = c;
+    }
+
+    end       += numRead;
+    bytesRead += numRead;
+    endOfSource = (numRead == 0);
+
+    return !endOfSource;
+}
+
+//
+// the next statement up to the terminator, the terminator is not included
+//
+// the last statement of the source does not need a terminator
+//
+bool ChassisReader::next(char terminator, ChassisText &statement, bool &truncated)
+{
+    uint16_t scan = start;
+
+    truncated = false;
+
+    for (;;)
+    {
+        const char *found = (const char *) memchr(buffer + scan, terminator, end - scan);
+
+        if (found)
+        {
+            uint16_t position = found - buffer;
+
+            if (skipping)
+            {
+                // the rest of a truncated statement, carry on with the one behind it
+                skipping = false;
+                start = scan = position + 1;
+                continue;
+            }
+
+            truncated = ((position - start) > (MAX_STATEMENT_LENGTH - 1));
+
+            statement.text   = buffer + start;
+            statement.length = truncated ? (MAX_STATEMENT_LENGTH - 1) : (position - start);
+            start = position + 1;
+            return true;
+        }
+
+        if (skipping)
+        {
+            start = end;
+        }
+        else if ((end - start) >= (MAX_STATEMENT_LENGTH - 1))
+        {
+            statement.text   = buffer + start;
+            statement.length = MAX_STATEMENT_LENGTH - 1;
+            truncated = true;
+            skipping  = true;
+            start = end;
+            return true;
+        }
+
+        uint16_t scanned = end - start;   // no terminator in there, not scanned again
+
+        if (endOfSource || !fill())
+        {
+            if (skipping || (start == end)) return false;
+
+            statement.text   = buffer + start;
+            statement.length = end - start;
+            start = end;
+            return true;
+        }
+
+        scan = scanned;
+    }
+}
@@ -0,0 +1,177 @@
+//
+//  ChassisScheduler.cpp
+//
+//
+//  Fixed rate tasks run from loop(), with the timer interrupt only counting ticks.
+//
+
+#include "ChassisScheduler.h"
+
+#include <Arduino.h>
+#include <util/atomic.h>
+
+#if defined(TIMSK1) && defined(SCHEDULER_USE_TIMER1)
+static ChassisScheduler *timerScheduler = NULL;
+
+ISR(TIMER1_COMPA_vect)
+{
+    if (timerScheduler != NULL) timerScheduler->tick();
+}
+#endif
+
+ChassisScheduler::ChassisScheduler()
+{
+}
+
+//
+// add a task called every period ms, or in the background for a period of 0, the first
+// periodic call is on the next run(). The budget in us only counts the overruns, a task
+// is never cut short
+//
+int8_t ChassisScheduler::addTask(ChassisTaskFunction function, void *context, uint16_t period, uint16_t budget)
+{
+    if ((function == NULL) || (numTasks >= SCHEDULER_MAX_TASKS) || (period > 0x7FFF)) return -1;
+
+    ChassisTask &task = tasks[numTasks];
+
+    task.function = function;
+    task.context  = context;
+    task.period   = period;
+    task.budget   = budget;
+    task.next     = now();
+    task.runs     = 0;
+    task.overruns = 0;
+    task.missed   = 0;
+    task.longest  = 0;
+
+    return numTasks++;
+}
+
+//
+// with SCHEDULER_USE_TIMER1 Timer1 in CTC mode at SCHEDULER_TICK_RATE, it takes the compare A
+// interrupt. The first tick carries on from millis(), so the tasks keep their phase
+//
+bool ChassisScheduler::begin()
+{
+#if defined(TIMSK1) && defined(SCHEDULER_USE_TIMER1)
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        timerScheduler = this;
+
+        TCCR1A = 0;
+        TCCR1B = 0;
+        TCNT1  = 0;
+        OCR1A  = (F_CPU / 64 / SCHEDULER_TICK_RATE) - 1;    // 249 at 16 MHz
+        TCCR1B = _BV(WGM12) | _BV(CS11) | _BV(CS10);        // CTC, prescaler 64
+        TIMSK1 |= _BV(OCIE1A);
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+//
+// the only work done in the interrupt, also for a tick from another timer
+//
+void ChassisScheduler::tick()
+{
+    // carry on from the millis() the tasks were scheduled with so far
+    if (!ticking) ticks = (uint16_t) millis();
+
+    ticks++;
+    ticking = true;
+}
+
+uint16_t ChassisScheduler::now()
+{
+    uint16_t current;
+
+    if (!ticking) return (uint16_t) millis();
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        current = ticks;
+    }
+
+    return current;
+}
+
+//
+// call the periodic tasks that are due, the background tasks when none was
+//
+void ChassisScheduler::run()
+{
+    bool busy = false;
+
+    for (uint8_t i=0; i < numTasks; i++)
+    {
+        ChassisTask &task = tasks[i];
+        int16_t late      = (int16_t) (now() - task.next);
+
+        if ((task.period == 0) || (late < 0)) continue;
+
+        // a late task runs once and skips the periods it missed
+        if ((uint16_t) late >= task.period)
+        {
+            uint16_t skipped = late / task.period;
+
+            task.missed = (skipped > (uint16_t) (0xFFFF - task.missed)) ? 0xFFFF : task.missed + skipped;
+            task.next  += skipped * task.period;
+        }
+        task.next += task.period;
+
+        call(task);
+        busy = true;
+    }
+
+    if (busy) return;
+
+    for (uint8_t i=0; i < numTasks; i++)
+        if (tasks[i].period == 0) call(tasks[i]);
+}
+
+void ChassisScheduler::call(ChassisTask &task)
+{
+    unsigned long start = micros();
+
+    task.function(task.context);
+
+    unsigned long duration = micros() - start;
+
+    if (task.runs < 0xFFFF) task.runs++;
+    if (duration > task.longest) task.longest = (duration > 0xFFFF) ? 0xFFFF : duration;
+    if ((task.budget > 0) && (duration > task.budget) && (task.overruns < 0xFFFF)) task.overruns++;
+}
+
+uint16_t ChassisScheduler::getRuns(int8_t task)
+{
+    return ((task >= 0) && (task < numTasks)) ? tasks[task].runs : 0;
+}
+
+uint16_t ChassisScheduler::getOverruns(int8_t task)
+{
+    return ((task >= 0) && (task < numTasks)) ? tasks[task].overruns : 0;
+}
+
+uint16_t ChassisScheduler::getMissed(int8_t task)
+{
+    return ((task >= 0) && (task < numTasks)) ? tasks[task].missed : 0;
+}
+
+uint16_t ChassisScheduler::getLongest(int8_t task)
+{
+    return ((task >= 0) && (task < numTasks)) ? tasks[task].longest : 0;
+}
+
+void ChassisScheduler::resetStatistics()
+{
+    for (uint8_t i=0; i < numTasks; i++)
+    {
+        tasks[i].runs     = 0;
+        tasks[i].overruns = 0;
+        tasks[i].missed   = 0;
+        tasks[i].longest  = 0;
+    }
+}
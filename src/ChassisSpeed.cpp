@@ -0,0 +1,101 @@
+//
+//  ChassisSpeed.cpp
+//
+//
+//  Fixed point closed loop speed control for a single wheel.
+//
+
+#include "ChassisSpeed.h"
+
+ChassisSpeedController::ChassisSpeedController()
+{
+    reset();
+}
+
+//
+// set the Q8 gains, 256 = 1.0
+//
+void ChassisSpeedController::setGains(int16_t newKp, int16_t newKi, int16_t newKd, int16_t newKff)
+{
+    kp  = newKp;
+    ki  = newKi;
+    kd  = newKd;
+    kff = newKff;
+
+    // largest integral for which ki * integral alone stays within full scale
+    integralLimit = (ki > 0) ? (((int32_t) SPEED_PWM_LIMIT << 8) / ki) : 0;
+
+    reset();
+}
+
+void ChassisSpeedController::setTarget(int16_t newTarget)
+{
+    // a change of direction starts from scratch, the history belongs to the other direction
+    if (((newTarget > 0) && (target < 0)) || ((newTarget < 0) && (target > 0)) || (newTarget == 0))
+        reset();
+
+    target = newTarget;
+}
+
+int16_t ChassisSpeedController::getTarget()
+{
+    return target;
+}
+
+void ChassisSpeedController::reset()
+{
+    integral  = 0;
+    lastError = 0;
+}
+
+//
+// one controller step, call at a fixed rate
+//
+// returns the pwm value, a target of 0 always returns 0 so a stopped wheel is not
+// kept twitching by the integral
+//
+int16_t ChassisSpeedController::update(int16_t measured)
+{
+    if (target == 0)
+    {
+        reset();
+        return 0;
+    }
+
+    // the difference of two int16 speeds needs 17 bits, saturated it keeps the sum of the
+    // Q8 terms below 2^31 for any gains
+    int32_t fullError = (int32_t) target - measured;
+    int16_t error = (fullError > SPEED_ERROR_LIMIT) ? SPEED_ERROR_LIMIT :
+                    (fullError < -SPEED_ERROR_LIMIT) ? -SPEED_ERROR_LIMIT : fullError;
+    int32_t output = ((int32_t) kff * target) + ((int32_t) kp * error) + ((int32_t) kd * ((int32_t) error - lastError));
+
+    lastError = error;
+
+    //
+    // integrate only when that does not drive a saturated output further into saturation
+    //
+    int32_t newIntegral = integral + error;
+
+    if (newIntegral >  integralLimit) newIntegral =  integralLimit;
+    if (newIntegral < -integralLimit) newIntegral = -integralLimit;
+
+    int32_t newOutput = output + ((int32_t) ki * newIntegral);
+    bool saturatedHigh = newOutput >  ((int32_t) SPEED_PWM_LIMIT << 8);
+    bool saturatedLow  = newOutput < -((int32_t) SPEED_PWM_LIMIT << 8);
+
+    if ((saturatedHigh && (error > 0)) || (saturatedLow && (error < 0)))
+        newOutput = output + ((int32_t) ki * integral);
+    else
+        integral = newIntegral;
+
+    newOutput >>= 8;
+
+    if (newOutput >  SPEED_PWM_LIMIT) newOutput =  SPEED_PWM_LIMIT;
+    if (newOutput < -SPEED_PWM_LIMIT) newOutput = -SPEED_PWM_LIMIT;
+
+    // never drive a wheel against its target direction, braking is done by slowing down
+    if ((target > 0) && (newOutput < 0)) newOutput = 0;
+    if ((target < 0) && (newOutput > 0)) newOutput = 0;
+
+    return newOutput;
+}
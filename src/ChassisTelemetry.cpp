@@ -0,0 +1,220 @@
+//
+//  ChassisTelemetry.cpp
+//
+//
+//  Compact binary status frames for low bandwidth links (BLE serial, I2C).
+//
+
+#include "ChassisTelemetry.h"
+
+#if defined(__AVR__)
+#  include <avr/pgmspace.h>
+#endif
+
+#ifndef PROGMEM
+#  define PROGMEM
+#endif
+#ifndef pgm_read_byte
+#  define pgm_read_byte(address) (*(const uint8_t *) (address))
+#endif
+
+#define TELEMETRY_KEY_FRAME       0x80      // header bit
+#define TELEMETRY_SEQUENCE_MASK   0x7F
+
+//
+// CRC-8 of one nibble, polynomial 0x07, 16 bytes of flash instead of 256
+//
+static const uint8_t crcNibbles[16] PROGMEM = {
+    0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15,
+    0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D
+};
+
+uint8_t chassisCrc8(const uint8_t *data, uint8_t length, uint8_t crc)
+{
+    while (length--)
+    {
+        crc ^= *data++;
+        crc = (crc << 4) ^ pgm_read_byte(&crcNibbles[crc >> 4]);
+        crc = (crc << 4) ^ pgm_read_byte(&crcNibbles[crc >> 4]);
+    }
+
+    return crc;
+}
+
+//
+// varints, 7 bits per byte, least significant first. Signed values are zigzagged so small
+// differences of either sign take a single byte
+//
+static uint8_t putVarint(uint8_t *out, uint32_t value)
+{
+    uint8_t length = 0;
+
+    while (value >= 0x80)
+    {
+        out[length++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    out[length++] = value;
+
+    return length;
+}
+
+static uint8_t putSigned(uint8_t *out, int32_t value)
+{
+    return putVarint(out, ((uint32_t) value << 1) ^ (uint32_t) (value >> 31));
+}
+
+//
+// returns false when the varint runs past end or is longer than 5 bytes
+//
+static bool getVarint(const uint8_t *&in, const uint8_t *end, uint32_t &value)
+{
+    value = 0;
+
+    for (uint8_t shift = 0; shift < 35; shift += 7)
+    {
+        if (in >= end) return false;
+
+        uint8_t byte = *in++;
+
+        value |= (uint32_t) (byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+
+    return false;
+}
+
+static bool getSigned(const uint8_t *&in, const uint8_t *end, int32_t &value)
+{
+    uint32_t zigzag;
+
+    if (!getVarint(in, end, zigzag)) return false;
+
+    value = (int32_t) (zigzag >> 1) ^ -(int32_t) (zigzag & 1);
+    return true;
+}
+
+ChassisTelemetryEncoder::ChassisTelemetryEncoder()
+{
+    for (uint8_t field = 0; field < NUM_TELEMETRY_FIELDS; field++)
+        last.values[field] = 0;
+
+    sequence = 0;
+    reset();
+}
+
+void ChassisTelemetryEncoder::reset()
+{
+    sinceKeyFrame = TELEMETRY_KEY_INTERVAL;
+}
+
+//
+// encode the state into the next frame, returns the frame length
+//
+uint8_t ChassisTelemetryEncoder::encode(const ChassisTelemetry &state, uint8_t frame[TELEMETRY_MAX_FRAME])
+{
+    bool    keyFrame = (sinceKeyFrame >= TELEMETRY_KEY_INTERVAL);
+    uint8_t pos = 3;
+
+    frame[0] = TELEMETRY_SYNC;
+    frame[2] = (sequence & TELEMETRY_SEQUENCE_MASK) | (keyFrame ? TELEMETRY_KEY_FRAME : 0);
+
+    if (keyFrame)
+    {
+        for (uint8_t field = 0; field < NUM_TELEMETRY_FIELDS; field++)
+            pos += putSigned(&frame[pos], state.values[field]);
+
+        sinceKeyFrame = 0;
+    }
+    else
+    {
+        uint16_t mask = 0;
+
+        for (uint8_t field = 0; field < NUM_TELEMETRY_FIELDS; field++)
+            if (state.values[field] != last.values[field]) mask |= (1 << field);
+
+        pos += putVarint(&frame[pos], mask);
+
+        for (uint8_t field = 0; field < NUM_TELEMETRY_FIELDS; field++)
+        {
+            int32_t delta = state.values[field] - last.values[field];
+
+            // the pulse counters wrap at 16 bits, so do their differences
+            if (field < TELEMETRY_DISTANCE) delta = (int16_t) delta;
+
+            if (mask & (1 << field))
+                pos += putSigned(&frame[pos], delta);
+        }
+    }
+
+    frame[1] = pos - 2;
+    frame[pos] = chassisCrc8(&frame[1], pos - 1);
+
+    last = state;
+    sequence++;
+    sinceKeyFrame++;
+
+    return pos + 1;
+}
+
+ChassisTelemetryDecoder::ChassisTelemetryDecoder()
+{
+    for (uint8_t field = 0; field < NUM_TELEMETRY_FIELDS; field++)
+        last.values[field] = 0;
+
+    sequence = 0;
+    synced   = false;
+}
+
+//
+// decode a complete frame, sync byte up to and including the CRC
+//
+bool ChassisTelemetryDecoder::decode(const uint8_t *frame, uint8_t length, ChassisTelemetry &state)
+{
+    if ((length < 4) || (frame[0] != TELEMETRY_SYNC) || (frame[1] != length - 3)) return false;
+    if (chassisCrc8(&frame[1], length - 2) != frame[length - 1]) return false;
+
+    const uint8_t   *in  = &frame[3];
+    const uint8_t   *end = &frame[length - 1];
+    uint8_t          header = frame[2];
+    ChassisTelemetry next = last;
+
+    if (header & TELEMETRY_KEY_FRAME)
+    {
+        for (uint8_t field = 0; field < NUM_TELEMETRY_FIELDS; field++)
+            if (!getSigned(in, end, next.values[field])) return false;
+    }
+    else
+    {
+        uint32_t mask;
+
+        // a delta only applies to the frame right before it
+        if (!synced || ((header & TELEMETRY_SEQUENCE_MASK) != ((sequence + 1) & TELEMETRY_SEQUENCE_MASK)))
+        {
+            synced = false;
+            return false;
+        }
+
+        if (!getVarint(in, end, mask)) return false;
+
+        for (uint8_t field = 0; field < NUM_TELEMETRY_FIELDS; field++)
+        {
+            int32_t delta;
+
+            if (!(mask & (1UL << field))) continue;
+            if (!getSigned(in, end, delta)) return false;
+            next.values[field] += delta;
+
+            if (field < TELEMETRY_DISTANCE) next.values[field] &= 0xFFFF;
+        }
+    }
+
+    if (in != end) return false;
+
+    last     = next;
+    sequence = header & TELEMETRY_SEQUENCE_MASK;
+    synced   = true;
+    state    = next;
+
+    return true;
+}
@@ -0,0 +1,361 @@
+//
+//  ChassisTokenizer.cpp
+//
+//
+//  Zero allocation tokenizer for the Chassis configuration and command files.
+//
+
+#include "ChassisTokenizer.h"
+
+#include <limits.h>
+
+#if defined(__AVR__)
+#  include <avr/pgmspace.h>
+#endif
+
+#ifndef PROGMEM
+#  define PROGMEM
+#endif
+
+//
+// the error descriptions stay in flash, print them with LOG_FLASH()
+//
+static const char errorMissingKey[]      PROGMEM = "missing key";
+static const char errorExpectedEquals[]  PROGMEM = "expected '='";
+static const char errorMissingValue[]    PROGMEM = "missing value";
+static const char errorTextAfterValue[]  PROGMEM = "unexpected text after value";
+static const char errorMissingClosing[]  PROGMEM = "missing closing bracket";
+static const char errorNestedTooDeep[]   PROGMEM = "arrays nested too deep";
+static const char errorMissingItem[]     PROGMEM = "missing item";
+static const char errorTooManyItems[]    PROGMEM = "too many items";
+static const char errorMismatched[]      PROGMEM = "mismatched bracket";
+
+ChassisTokenizer::ChassisTokenizer(const char *text, size_t textLength, char statementTerminator)
+{
+    buffer     = text;
+    length     = (text != NULL) ? textLength : 0;
+    pos        = 0;
+    terminator = statementTerminator;
+    line       = 1;
+    error      = NULL;
+}
+
+//
+// returns the next statement in the buffer
+//
+// PARSE_OK    statement is filled in
+// PARSE_END   no more statements
+// PARSE_ERROR the statement was malformed and skipped, getError() tells why
+//
+ChassisParseResult ChassisTokenizer::next(ChassisStatement &statement)
+{
+    //
+    // skip empty statements
+    //
+    skipSpaces();
+    while ((pos < length) && isTerminator(buffer[pos]))
+    {
+        if (buffer[pos] == '\n') line++;
+        pos++;
+        skipSpaces();
+    }
+
+    if (pos >= length) return PARSE_END;
+
+    statement.valueType = VALUE_NONE;
+    statement.numItems  = 0;
+    statement.numGroups = 0;
+    statement.line      = line;
+    statement.value.text   = buffer + pos;
+    statement.value.length = 0;
+
+    //
+    // the key runs up to a space, '=' or the terminator
+    //
+    size_t start = pos;
+    while ((pos < length) && !isTerminator(buffer[pos]) && !isSpace(buffer[pos]) && (buffer[pos] != '='))
+        pos++;
+
+    statement.key.text   = buffer + start;
+    statement.key.length = pos - start;
+
+    if (statement.key.length == 0) return fail(errorMissingKey);
+
+    skipSpaces();
+
+    if ((pos < length) && !isTerminator(buffer[pos]))
+    {
+        if (buffer[pos] != '=') return fail(errorExpectedEquals);
+
+        pos++;
+        skipSpaces();
+
+        if ((pos >= length) || isTerminator(buffer[pos])) return fail(errorMissingValue);
+
+        start = pos;
+        char opening = buffer[pos];
+
+        if ((opening == '{') || (opening == '('))
+        {
+            pos++;
+            statement.valueType = (opening == '{') ? VALUE_ARRAY : VALUE_TUPLE;
+
+            if (!parseGroup(statement, (opening == '{') ? '}' : ')', 1))
+            {
+                skipStatement();
+                return PARSE_ERROR;
+            }
+        }
+        else
+        {
+            while ((pos < length) && !isTerminator(buffer[pos]) && !isSpace(buffer[pos]))
+                pos++;
+
+            statement.valueType = VALUE_SCALAR;
+            statement.numItems  = 1;
+            statement.items[0].text   = buffer + start;
+            statement.items[0].length = pos - start;
+        }
+
+        statement.value.text   = buffer + start;
+        statement.value.length = pos - start;
+
+        skipSpaces();
+        if ((pos < length) && !isTerminator(buffer[pos])) return fail(errorTextAfterValue);
+    }
+
+    //
+    // consume the terminator
+    //
+    if (pos < length)
+    {
+        if (buffer[pos] == '\n') line++;
+        pos++;
+    }
+
+    return PARSE_OK;
+}
+
+//
+// parse the items of an array or tuple up to and including the closing bracket
+//
+bool ChassisTokenizer::parseGroup(ChassisStatement &statement, char closing, uint8_t depth)
+{
+    bool first = true;
+
+    while (true)
+    {
+        skipSpaces();
+        if ((pos >= length) || isTerminator(buffer[pos]))
+        {
+            error = errorMissingClosing;
+            return false;
+        }
+
+        char c = buffer[pos];
+
+        if (first && (c == closing))
+        {
+            pos++;
+            return true;  // empty group
+        }
+        first = false;
+
+        if ((c == '{') || (c == '('))
+        {
+            if (depth > 1)
+            {
+                error = errorNestedTooDeep;
+                return false;
+            }
+
+            pos++;
+            if (!parseGroup(statement, (c == '{') ? '}' : ')', depth + 1)) return false;
+            statement.numGroups++;
+        }
+        else
+        {
+            size_t start = pos;
+            while ((pos < length) && !isTerminator(buffer[pos]) && !isSpace(buffer[pos]) &&
+                   (buffer[pos] != ',') && (buffer[pos] != '{') && (buffer[pos] != '}') &&
+                   (buffer[pos] != '(') && (buffer[pos] != ')'))
+                pos++;
+
+            if (pos == start)
+            {
+                error = errorMissingItem;
+                return false;
+            }
+
+            if (statement.numItems >= MAX_STATEMENT_ITEMS)
+            {
+                error = errorTooManyItems;
+                return false;
+            }
+
+            statement.items[statement.numItems].text   = buffer + start;
+            statement.items[statement.numItems].length = pos - start;
+            statement.numItems++;
+        }
+
+        skipSpaces();
+        if ((pos >= length) || isTerminator(buffer[pos]))
+        {
+            error = errorMissingClosing;
+            return false;
+        }
+
+        c = buffer[pos++];
+        if (c == closing) return true;
+        if (c != ',')
+        {
+            error = errorMismatched;
+            return false;
+        }
+    }
+}
+
+//
+// description of the last error in flash, NULL when there was none
+//
+const char *ChassisTokenizer::getError()
+{
+    return error;
+}
+
+//
+// offset of the next statement in the buffer
+//
+size_t ChassisTokenizer::getPosition()
+{
+    return pos;
+}
+
+bool ChassisTokenizer::isTerminator(char c)
+{
+    return (c == terminator) || (c == '\0');
+}
+
+bool ChassisTokenizer::isSpace(char c)
+{
+    return (c == ' ') || (c == '\t') || (c == '\r') || ((c == '\n') && (terminator != '\n'));
+}
+
+void ChassisTokenizer::skipSpaces()
+{
+    while ((pos < length) && isSpace(buffer[pos]))
+    {
+        if (buffer[pos] == '\n') line++;
+        pos++;
+    }
+}
+
+void ChassisTokenizer::skipStatement()
+{
+    while ((pos < length) && !isTerminator(buffer[pos]))
+    {
+        if (buffer[pos] == '\n') line++;
+        pos++;
+    }
+
+    if (pos < length)
+    {
+        if (buffer[pos] == '\n') line++;
+        pos++;
+    }
+}
+
+ChassisParseResult ChassisTokenizer::fail(const char *message)
+{
+    error = message;
+    skipStatement();
+
+    return PARSE_ERROR;
+}
+
+//
+// case insensitive compare of a text view with a zero terminated string
+//
+bool chassisTextEquals(const ChassisText &text, const char *value)
+{
+    uint8_t i = 0;
+
+    for (; i < text.length; i++)
+    {
+        char a = text.text[i];
+        char b = value[i];
+
+        if (b == '\0') return false;
+        if ((a >= 'a') && (a <= 'z')) a -= 'a' - 'A';
+        if ((b >= 'a') && (b <= 'z')) b -= 'a' - 'A';
+        if (a != b) return false;
+    }
+
+    return value[i] == '\0';
+}
+
+//
+// convert a text view holding an optionally signed decimal number
+//
+// returns false when the text is not a number or does not fit a long
+//
+bool chassisTextToInt(const ChassisText &text, long &value)
+{
+    uint8_t i = 0;
+    bool negative = false;
+    unsigned long result = 0;
+    unsigned long limit  = LONG_MAX;
+
+    if ((text.length > 0) && ((text.text[0] == '-') || (text.text[0] == '+')))
+    {
+        negative = (text.text[0] == '-');
+        i++;
+    }
+
+    if (negative) limit++;     // LONG_MIN has one more
+
+    if (i >= text.length) return false;
+
+    for (; i < text.length; i++)
+    {
+        if ((text.text[i] < '0') || (text.text[i] > '9')) return false;
+
+        uint8_t digit = text.text[i] - '0';
+
+        if (result > ((limit - digit) / 10)) return false;
+        result = (result * 10) + digit;
+    }
+
+    value = negative ? -(long) (result - 1) - 1 : (long) result;
+    return true;
+}
+
+//
+// convert ON / OFF, returns false for anything else
+//
+bool chassisTextToSwitch(const ChassisText &text, bool &value)
+{
+    if (chassisTextEquals(text, "ON"))  {value = true;  return true;}
+    if (chassisTextEquals(text, "OFF")) {value = false; return true;}
+
+    return false;
+}
+
+//
+// copy a text view into a zero terminated string, truncating to size
+//
+uint8_t chassisTextCopy(const ChassisText &text, char *target, uint8_t size)
+{
+    uint8_t count = 0;
+
+    if (size == 0) return 0;
+
+    while ((count < text.length) && (count < (size - 1)))
+    {
+        target[count] = text.text[count];
+        count++;
+    }
+    target[count] = '\0';
+
+    return count;
+}
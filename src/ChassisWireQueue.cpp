@@ -0,0 +1,157 @@
+//
+//  ChassisWireQueue.cpp
+//
+//
+//  Fixed size ring buffer of output messages for the I2C link.
+//
+
+#include "ChassisWireQueue.h"
+
+ChassisWireQueue::ChassisWireQueue()
+{
+    clear();
+}
+
+//
+// queue a message, returns false and counts the drop when it does not fit
+//
+bool ChassisWireQueue::push(const char *text, uint16_t length)
+{
+    beginMessage();
+
+    for (uint16_t i = 0; i < length; i++)
+        append(text[i]);
+
+    return endMessage();
+}
+
+void ChassisWireQueue::beginMessage()
+{
+    messageStart  = head;
+    messageLength = 0;
+    messageFull   = (WIRE_QUEUE_SIZE - used) < 2;
+
+    if (!messageFull) head = (head + 2) % WIRE_QUEUE_SIZE;
+}
+
+void ChassisWireQueue::append(uint8_t c)
+{
+    if (!messageFull && ((used + 2 + messageLength) >= WIRE_QUEUE_SIZE)) messageFull = true;
+
+    if (!messageFull)
+    {
+        buffer[head] = c;
+        head = (head + 1) % WIRE_QUEUE_SIZE;
+    }
+
+    // the length of a dropped message tells whether it could ever have fitted
+    if (messageLength < 0xFFFF) messageLength++;
+}
+
+bool ChassisWireQueue::endMessage()
+{
+    if (messageFull)
+    {
+        head = messageStart;
+        if (dropped < 0xFFFF) dropped++;
+        if ((messageLength > WIRE_MAX_MESSAGE) && (oversized < 0xFFFF)) oversized++;
+        return false;
+    }
+
+    buffer[messageStart] = messageLength >> 8;
+    buffer[(messageStart + 1) % WIRE_QUEUE_SIZE] = messageLength & 0xFF;
+
+    used += messageLength + 2;
+
+    return true;
+}
+
+//
+// copy the next frame of the oldest message with its two framing bytes
+//
+// returns the frame length, 0 when nothing is queued. An empty message is a single 6 8 frame
+//
+uint8_t ChassisWireQueue::peekFrame(uint8_t frame[WIRE_FRAME_SIZE])
+{
+    if (used == 0) return 0;
+
+    uint16_t length = ((uint16_t) byteAt(0) << 8) | byteAt(1);
+    uint16_t data   = frameData(length);
+
+    frame[0] = (sent == 0) ? WIRE_FRAME_START : WIRE_FRAME_CONTINUE;
+    frame[1] = (sent + data >= length) ? WIRE_FRAME_STOP : WIRE_FRAME_CONTINUE;
+
+    for (uint16_t i = 0; i < data; i++)
+        frame[i + 2] = byteAt(2 + sent + i);
+
+    return data + 2;
+}
+
+void ChassisWireQueue::popFrame()
+{
+    if (used == 0) return;
+
+    uint16_t length = ((uint16_t) byteAt(0) << 8) | byteAt(1);
+
+    sent += frameData(length);
+
+    if (sent >= length)
+    {
+        tail  = (tail + length + 2) % WIRE_QUEUE_SIZE;
+        used -= length + 2;
+        sent  = 0;
+    }
+}
+
+//
+// empty the queue, a message being written is dropped as well and the counters start over
+//
+void ChassisWireQueue::clear()
+{
+    head = 0;
+    tail = 0;
+    used = 0;
+    sent = 0;
+
+    dropped   = 0;
+    oversized = 0;
+
+    messageStart  = 0;
+    messageLength = 0;
+    messageFull   = true;     // until the next beginMessage()
+}
+
+bool ChassisWireQueue::isEmpty()
+{
+    return used == 0;
+}
+
+uint16_t ChassisWireQueue::getQueued()
+{
+    return used;
+}
+
+uint16_t ChassisWireQueue::getDropped()
+{
+    return dropped;
+}
+
+uint16_t ChassisWireQueue::getOversized()
+{
+    return oversized;
+}
+
+uint8_t ChassisWireQueue::byteAt(uint16_t offset)
+{
+    return buffer[(tail + offset) % WIRE_QUEUE_SIZE];
+}
+
+//
+// message bytes in the next frame of a message of the given length
+//
+uint16_t ChassisWireQueue::frameData(uint16_t length)
+{
+    uint16_t remaining = length - sent;
+
+    return (remaining > WIRE_FRAME_DATA) ? WIRE_FRAME_DATA : remaining;
+}
@@ -4,4 +4,746 @@ void test_placeholder() {
     TEST_ASSERT_EQUAL(1, 1);
 }
 
-// setup()/loop() moved to test_runner.cpp
+//
+// the tests below drive the real Chassis class on the host HAL in hal/native
+//
+#ifndef ARDUINO
+
+#include <Chassis.h>
+#include <EEPROM.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static char cardRoot[64];
+
+//
+// fresh HAL state and an empty directory acting as the SD card
+//
+static void newCard() {
+  halReset();
+  Wire.clearFrames();
+  chassisLog.getWireQueue().clear();
+
+  strcpy(cardRoot, "/tmp/chassis-sd-XXXXXX");
+  TEST_ASSERT_NOT_NULL(mkdtemp(cardRoot));
+  halSetSDRoot(cardRoot);
+}
+
+static void writeCardFile(const char *name, const char *content) {
+  char path[128];
+
+  snprintf(path, sizeof(path), "%s/%s", cardRoot, name);
+  if (strchr(name, '/')) {
+    char dir[128];
+    snprintf(dir, sizeof(dir), "%s/%.*s", cardRoot, (int) (strrchr(name, '/') - name), name);
+    mkdir(dir, 0755);
+  }
+
+  FILE *file = fopen(path, "wb");
+  TEST_ASSERT_NOT_NULL(file);
+  fputs(content, file);
+  fclose(file);
+}
+
+static void runFor(Chassis &chassis, unsigned long ms) {
+  for (unsigned long i = 0; i < ms; i++) {
+    halAdvanceMicros(1000);
+    chassis.update();
+  }
+}
+
+void test_chassis_move_wheels() {
+  newCard();
+  Chassis chassis;
+  chassis.setLights(true);
+
+  chassis.moveForward(200);
+  TEST_ASSERT_EQUAL(200, halAnalogValue(4));
+  TEST_ASSERT_EQUAL(200, halAnalogValue(7));
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(31));   // flw forward
+  TEST_ASSERT_EQUAL(LOW, digitalRead(32));
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(42));   // front lights on
+  TEST_ASSERT_EQUAL(LOW, digitalRead(44));
+
+  chassis.moveBackwards(300);                 // clamped to the maximum
+  TEST_ASSERT_EQUAL(MAX_WHEEL_SPEED, halAnalogValue(5));
+  TEST_ASSERT_EQUAL(LOW, digitalRead(31));
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(32));
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(44));   // rear lights on
+
+  chassis.doFullStop();
+  TEST_ASSERT_EQUAL(0, halAnalogValue(6));
+  TEST_ASSERT_EQUAL(LOW, digitalRead(38));
+  TEST_ASSERT_EQUAL(LOW, digitalRead(39));
+}
+
+void test_chassis_config_from_file() {
+  newCard();
+  writeCardFile("CONF.TXT",
+                "LIGHTS = ON;\r\n"
+                "LIGHTS_OVERRIDE = ON;\r\n"
+                "CYCLE = 3;\r\n"
+                "WHEEL_PINS = {{8,22,23}, {9,24,25}, {10,26,27}, {11,28,29}};\r\n"
+                "MOVEMENTS = commands/TEST.TXT;\r\n");
+  Chassis chassis;
+
+  TEST_ASSERT_TRUE(chassis.initialiseFromFile("CONF.TXT"));
+  TEST_ASSERT_TRUE(chassis.areLightsEnabled());
+  TEST_ASSERT_TRUE(chassis.isLightsOverrideEnabled());
+  TEST_ASSERT_EQUAL(3, chassis.getRunCycles());
+
+  chassis.moveForward(100);
+  TEST_ASSERT_EQUAL(100, halAnalogValue(8));
+  TEST_ASSERT_EQUAL(0, halAnalogValue(4));
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(22));
+  TEST_ASSERT_EQUAL(OUTPUT, halPinMode(29));
+
+  // sketches written for the String parameters still build and work
+  Chassis fromString;
+  String  commandFile = "commands/OTHER.TXT";
+
+  TEST_ASSERT_TRUE(fromString.initialiseFromFile(String("CONF.TXT")));
+  TEST_ASSERT_EQUAL(3, fromString.getRunCycles());
+  TEST_ASSERT_TRUE(fromString.setCommandFile(commandFile));
+}
+
+void test_chassis_config_from_stream() {
+  newCard();
+  Chassis chassis;
+
+  Serial.input = "CYCLE = 4;\r\nLIGHTS = ON;\r\n";
+  TEST_ASSERT_TRUE(chassis.initialiseFromStream(Serial));
+  TEST_ASSERT_EQUAL(4, chassis.getRunCycles());
+  TEST_ASSERT_TRUE(chassis.areLightsEnabled());
+
+  Serial.input = "<MOVEMENT>\nFORWARD = 150\nDURATION = 10\n</MOVEMENT>\n";
+  TEST_ASSERT_TRUE(chassis.compileCommandStream(Serial));
+  TEST_ASSERT_TRUE(chassis.getProgramLength() > 0);
+}
+
+void test_chassis_program_runs() {
+  newCard();
+  writeCardFile("commands/TEST.TXT",
+                "<MOVEMENT>\r\n"
+                " FORWARD = 150\r\n"
+                " DURATION = 500\r\n"
+                "</MOVEMENT>\r\n");
+  Chassis chassis;
+
+  chassis.setCommandFile("commands/TEST.TXT");
+  chassis.setRunCycles(2);
+  chassis.setManualMode(false);
+  TEST_ASSERT_TRUE(chassis.compileCommandFile());
+  TEST_ASSERT_TRUE(chassis.startProgram());
+
+  runFor(chassis, 100);
+  TEST_ASSERT_TRUE(chassis.isBusy());
+  TEST_ASSERT_EQUAL(150, halAnalogValue(4));
+
+  runFor(chassis, 1000);
+  TEST_ASSERT_FALSE(chassis.isBusy());
+  TEST_ASSERT_EQUAL(0, halAnalogValue(4));
+
+  // switching to manual mode stops a running program within one update()
+  TEST_ASSERT_TRUE(chassis.startProgram());
+  runFor(chassis, 100);
+  chassis.setManualMode(true);
+  runFor(chassis, 1);
+  TEST_ASSERT_FALSE(chassis.isBusy());
+  TEST_ASSERT_EQUAL(0, halAnalogValue(4));
+}
+
+void test_chassis_block_index() {
+  newCard();
+  writeCardFile("commands/TEST.TXT",
+                "<MOVEMENT>\r\n FORWARD = 110\r\n DURATION = 100\r\n</MOVEMENT>\r\n"
+                "<MOVEMENT>\r\n FORWARD = 120\r\n DURATION = 100\r\n</MOVEMENT>\r\n"
+                "<MOVEMENT>\r\n BACKWARD = 130\r\n DURATION = 100\r\n</MOVEMENT>\r\n");
+  Chassis chassis;
+
+  chassis.setCommandFile("commands/TEST.TXT");
+  chassis.setRunCycles(1);
+  chassis.setManualMode(false);
+  TEST_ASSERT_TRUE(chassis.compileCommandFile());
+  TEST_ASSERT_EQUAL(3, chassis.getNumBlocks());
+  TEST_ASSERT_TRUE(chassis.getBlockHash(0) != chassis.getBlockHash(1));
+  TEST_ASSERT_EQUAL(-1, chassis.getCurrentBlock());
+
+  // straight to the last block
+  TEST_ASSERT_FALSE(chassis.startProgram(3));
+  TEST_ASSERT_TRUE(chassis.startProgram(2));
+  runFor(chassis, 50);
+  TEST_ASSERT_EQUAL(2, chassis.getCurrentBlock());
+  TEST_ASSERT_EQUAL(130, halAnalogValue(4));
+  runFor(chassis, 200);
+  TEST_ASSERT_FALSE(chassis.isBusy());
+
+  // jump back while the first block waits
+  TEST_ASSERT_TRUE(chassis.startProgram());
+  runFor(chassis, 50);
+  TEST_ASSERT_EQUAL(110, halAnalogValue(4));
+  TEST_ASSERT_TRUE(chassis.jumpToBlock(1));
+  runFor(chassis, 10);
+  TEST_ASSERT_EQUAL(1, chassis.getCurrentBlock());
+  TEST_ASSERT_EQUAL(120, halAnalogValue(4));
+  chassis.abort();
+  TEST_ASSERT_FALSE(chassis.jumpToBlock(0));
+
+  // other line ends hash the same, an edited block does not
+  uint16_t first = chassis.getBlockHash(0);
+  uint16_t last  = chassis.getBlockHash(2);
+
+  writeCardFile("commands/TEST.TXT",
+                "<MOVEMENT>\n FORWARD = 110\n DURATION = 100\n</MOVEMENT>\n"
+                "<MOVEMENT>\n FORWARD = 120\n DURATION = 100\n</MOVEMENT>\n"
+                "<MOVEMENT>\n BACKWARD = 140\n DURATION = 100\n</MOVEMENT>\n");
+  TEST_ASSERT_TRUE(chassis.compileCommandFile());
+  TEST_ASSERT_EQUAL(first, chassis.getBlockHash(0));
+  TEST_ASSERT_TRUE(last != chassis.getBlockHash(2));
+
+  // the index is kept in the program cache
+  Chassis cached;
+  Chassis loaded;
+  char    binPath[128];
+
+  cached.setCommandFile("commands/TEST.TXT");
+  cached.setProgramCache(true);
+  TEST_ASSERT_TRUE(cached.compileCommandFile());
+  snprintf(binPath, sizeof(binPath), "%s/commands/TEST.BIN", cardRoot);
+  TEST_ASSERT_EQUAL(0, access(binPath, R_OK));
+
+  loaded.setCommandFile("commands/TEST.TXT");
+  loaded.setProgramCache(true);
+  TEST_ASSERT_TRUE(loaded.compileCommandFile());
+  TEST_ASSERT_EQUAL(3, loaded.getNumBlocks());
+  TEST_ASSERT_EQUAL(chassis.getBlockHash(2), loaded.getBlockHash(2));
+}
+
+void test_chassis_control_flow() {
+  newCard();
+  writeCardFile("commands/TEST.TXT",
+                "<MOVEMENT>\r\n"
+                " REPEAT = 2\r\n"
+                "  FORWARD = 110\r\n"
+                "  DURATION = 100\r\n"
+                "  CALL = commands/TURN.TXT\r\n"
+                " END\r\n"
+                " GOTO = done\r\n"
+                " FORWARD = 200\r\n"
+                " DURATION = 100\r\n"
+                " LABEL = done\r\n"
+                " BACKWARD = 130\r\n"
+                " DURATION = 100\r\n"
+                "</MOVEMENT>\r\n");
+  writeCardFile("commands/TURN.TXT", "FORWARD = 120\r\nDURATION = 100\r\n");
+  Chassis chassis;
+
+  chassis.setCommandFile("commands/TEST.TXT");
+  chassis.setRunCycles(1);
+  chassis.setManualMode(false);
+  TEST_ASSERT_TRUE(chassis.compileCommandFile());
+  TEST_ASSERT_TRUE(chassis.startProgram());
+
+  const int expected[] = {110, 120, 110, 120, 130};
+
+  for (int step = 0; step < 5; step++) {
+    runFor(chassis, (step == 0) ? 50 : 100);
+    TEST_ASSERT_EQUAL(expected[step], halAnalogValue(4));
+  }
+  runFor(chassis, 100);
+  TEST_ASSERT_FALSE(chassis.isBusy());
+
+  // errors are found at compile time
+  writeCardFile("commands/TEST.TXT", "<MOVEMENT>\r\n FORWARD = 110\r\n END\r\n</MOVEMENT>\r\n");
+  TEST_ASSERT_FALSE(chassis.compileCommandFile());
+  writeCardFile("commands/TEST.TXT", "<MOVEMENT>\r\n GOTO = nowhere\r\n</MOVEMENT>\r\n");
+  TEST_ASSERT_FALSE(chassis.compileCommandFile());
+  writeCardFile("commands/TEST.TXT",
+                "<MOVEMENT>\r\n GOTO = inside\r\n REPEAT = 2\r\n  LABEL = inside\r\n END\r\n</MOVEMENT>\r\n");
+  TEST_ASSERT_FALSE(chassis.compileCommandFile());
+  writeCardFile("commands/TEST.TXT", "<MOVEMENT>\r\n CALL = commands/NONE.TXT\r\n</MOVEMENT>\r\n");
+  TEST_ASSERT_FALSE(chassis.compileCommandFile());
+
+  // a sub-route calling itself overflows the stack and aborts the program
+  writeCardFile("commands/TEST.TXT", "<MOVEMENT>\r\n CALL = commands/LOOP.TXT\r\n</MOVEMENT>\r\n");
+  writeCardFile("commands/LOOP.TXT", "FORWARD = 140\r\nCALL = commands/LOOP.TXT\r\n");
+  TEST_ASSERT_TRUE(chassis.compileCommandFile());
+  TEST_ASSERT_TRUE(chassis.startProgram());
+  runFor(chassis, 10);
+  TEST_ASSERT_FALSE(chassis.isBusy());
+  TEST_ASSERT_EQUAL(0, halAnalogValue(4));
+}
+
+//
+// replace the program in the .BIN cache of commands/TEST.TXT, with a CRC that matches
+//
+static void writeCachedProgram(const uint8_t *code, uint8_t length) {
+  char    path[128];
+  uint8_t header[11];
+
+  snprintf(path, sizeof(path), "%s/commands/TEST.BIN", cardRoot);
+  FILE *file = fopen(path, "rb");
+  TEST_ASSERT_NOT_NULL(file);
+  TEST_ASSERT_EQUAL(sizeof(header), fread(header, 1, sizeof(header), file));
+  fclose(file);
+
+  header[8]  = length;
+  header[9]  = 0;
+  header[10] = 0;     // no block index
+
+  file = fopen(path, "wb");
+  fwrite(header, 1, sizeof(header), file);
+  fwrite(code, 1, length, file);
+  fputc(chassisCrc8(code, length), file);
+  fclose(file);
+}
+
+void test_chassis_damaged_program_cache() {
+  newCard();
+  writeCardFile("commands/TEST.TXT", "<MOVEMENT>\r\n FORWARD = 110\r\n DURATION = 100\r\n</MOVEMENT>\r\n");
+  Chassis compiler;
+
+  compiler.setCommandFile("commands/TEST.TXT");
+  compiler.setProgramCache(true);
+  TEST_ASSERT_TRUE(compiler.compileCommandFile());
+
+  // a flipped bit fails the CRC and the command file is compiled again
+  char binPath[128];
+  snprintf(binPath, sizeof(binPath), "%s/commands/TEST.BIN", cardRoot);
+  FILE *file = fopen(binPath, "r+b");
+  TEST_ASSERT_NOT_NULL(file);
+  fseek(file, 11 + sizeof(ChassisBlockEntry) + 1, SEEK_SET);
+  int operand = fgetc(file);
+  fseek(file, 11 + sizeof(ChassisBlockEntry) + 1, SEEK_SET);
+  fputc(operand ^ 0x40, file);
+  fclose(file);
+
+  Chassis recompiled;
+  recompiled.setCommandFile("commands/TEST.TXT");
+  recompiled.setProgramCache(true);
+  recompiled.setRunCycles(1);
+  recompiled.setManualMode(false);
+  TEST_ASSERT_TRUE(recompiled.compileCommandFile());
+  TEST_ASSERT_TRUE(recompiled.startProgram());
+  runFor(recompiled, 50);
+  TEST_ASSERT_EQUAL(110, halAnalogValue(4));
+  recompiled.abort();
+
+  // programs the compiler cannot emit end at the bad instruction instead of running wild
+  const uint8_t damaged[][6] = {
+    {OP_END_REPEAT},                          // nothing to repeat
+    {OP_RETURN},                              // nothing to return to
+    {OP_CALL, 3, 0, OP_END_REPEAT},           // a CALL frame is not a REPEAT frame
+    {OP_REPEAT, 2, 0, 6, 0, OP_RETURN},       // and the other way round
+    {OP_REPEAT, 0, 0, 9, 0},                  // end behind the program
+    {OP_GOTO, 0xFF, 0},                       // target behind the program
+    {OP_CALL, 0x01},                          // operand cut off
+    {OP_FORWARD, 110},                        // operand cut off
+    {OP_FORWARD, 0xE8, 0x03},                 // speed 1000
+  };
+  const uint8_t lengths[] = {1, 1, 4, 6, 5, 3, 2, 2, 3};
+
+  for (uint8_t i = 0; i < sizeof(lengths); i++) {
+    writeCachedProgram(damaged[i], lengths[i]);
+
+    Chassis chassis;
+    chassis.setCommandFile("commands/TEST.TXT");
+    chassis.setProgramCache(true);
+    chassis.setRunCycles(3);
+    chassis.setManualMode(false);
+    TEST_ASSERT_TRUE(chassis.compileCommandFile());
+    TEST_ASSERT_EQUAL(lengths[i], chassis.getProgramLength());
+    TEST_ASSERT_TRUE(chassis.startProgram());
+    runFor(chassis, 10);
+    TEST_ASSERT_FALSE(chassis.isBusy());
+    TEST_ASSERT_EQUAL(0, halAnalogValue(4));
+  }
+}
+
+void test_chassis_motion_profile() {
+  newCard();
+  Chassis chassis;
+
+  Serial.input = "MOTION_PROFILE = {1, 500, 0};\r\n";
+  TEST_ASSERT_TRUE(chassis.initialiseFromStream(Serial));
+  TEST_ASSERT_EQUAL(PROFILE_TRAPEZOID, chassis.getMotionProfile());
+  TEST_ASSERT_FALSE(chassis.setMotionProfile(PROFILE_S_CURVE, 500, 0));
+
+  // 5 pwm per 10 ms tick, the first one right away
+  chassis.moveForward(200);
+  TEST_ASSERT_EQUAL(0, halAnalogValue(4));
+  TEST_ASSERT_TRUE(chassis.isRamping());
+  runFor(chassis, 95);
+  TEST_ASSERT_EQUAL(50, halAnalogValue(4));
+  runFor(chassis, 400);
+  TEST_ASSERT_EQUAL(200, halAnalogValue(4));
+  TEST_ASSERT_FALSE(chassis.isRamping());
+
+  // a stop ramps down as well, an abort does not
+  chassis.doFullStop();
+  runFor(chassis, 100);
+  TEST_ASSERT_EQUAL(150, halAnalogValue(4));
+
+  TEST_ASSERT_TRUE(chassis.executeLine("DURATION = 1000", 15));
+  TEST_ASSERT_TRUE(chassis.isBusy());
+  chassis.abort();
+  TEST_ASSERT_EQUAL(0, halAnalogValue(4));
+  TEST_ASSERT_FALSE(chassis.isRamping());
+
+  // switching the profile off ends a ramp on its targets
+  TEST_ASSERT_TRUE(chassis.setMotionProfile(PROFILE_S_CURVE, 500, 5000));
+  chassis.moveBackwards(120);
+  runFor(chassis, 50);
+  TEST_ASSERT_TRUE(halAnalogValue(4) < 20);
+  TEST_ASSERT_TRUE(chassis.setMotionProfile(PROFILE_NONE, 0, 0));
+  TEST_ASSERT_EQUAL(120, halAnalogValue(4));
+  TEST_ASSERT_FALSE(chassis.isRamping());
+}
+
+void test_chassis_rotate_by_angle() {
+  newCard();
+  writeCardFile("commands/TEST.TXT", "<MOVEMENT>\r\n ROTATE = 90\r\n FORWARD = 100\r\n</MOVEMENT>\r\n");
+  Chassis chassis;
+  int ticks = 0;
+  int travel[NUM_WHEELS] = {0, 0, 0, 0};
+
+  TEST_ASSERT_TRUE(initialisePulseCounters());
+  chassis.setCommandFile("commands/TEST.TXT");
+  chassis.setRunCycles(1);
+  chassis.setManualMode(false);
+  TEST_ASSERT_TRUE(chassis.compileCommandFile());
+  TEST_ASSERT_TRUE(chassis.startProgram());
+  runFor(chassis, 1);
+
+  // the left side turns forward and the right side backward
+  TEST_ASSERT_TRUE(chassis.isMoving());
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(31));
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(30));
+
+  // the wheels pulse at a rate proportional to their pwm until the program moves on to FORWARD
+  while (chassis.isMoving() || (halAnalogValue(4) != 100)) {
+    halAdvanceMicros(1000);
+    for (int wheel = 0; wheel < NUM_WHEELS; wheel++) {
+      travel[wheel] += halAnalogValue(4 + wheel);
+      if (travel[wheel] >= 2000) {
+        travel[wheel] -= 2000;
+        halFireInterrupt(digitalPinToInterrupt(pulseCounters[wheel]));
+      }
+    }
+    chassis.update();
+    TEST_ASSERT_TRUE(++ticks < 5000);
+  }
+
+  // 90 degrees over a 150 mm track is 118 mm or 11 pulses per side, a pulse is 8 degrees
+  ChassisPose pose = chassis.getPose();
+  long degrees = ((65536L - pose.heading) * 360L + 32768L) >> 16;
+
+  TEST_ASSERT_INT_WITHIN(8, 90, degrees);
+  TEST_ASSERT_FALSE(chassis.doRotate(0));
+}
+
+void test_chassis_ramped_moves() {
+  newCard();
+  Chassis chassis;
+  int ticks = 0;
+  int largest = 0;
+  int travel[NUM_WHEELS] = {0, 0, 0, 0};
+
+  TEST_ASSERT_TRUE(initialisePulseCounters());
+  TEST_ASSERT_TRUE(chassis.setMotionProfile(PROFILE_TRAPEZOID, 500, 0));
+
+  // a rotation starts through the ramps, 5 pwm per 10 ms tick
+  TEST_ASSERT_TRUE(chassis.doRotate(90));
+  TEST_ASSERT_TRUE(chassis.isRamping());
+  runFor(chassis, 1);
+  TEST_ASSERT_EQUAL(5, halAnalogValue(4));
+  TEST_ASSERT_EQUAL(5, halAnalogValue(5));
+
+  while (chassis.isMoving()) {
+    halAdvanceMicros(1000);
+    for (int wheel = 0; wheel < NUM_WHEELS; wheel++) {
+      travel[wheel] += halAnalogValue(4 + wheel);
+      if (travel[wheel] >= 2000) {
+        travel[wheel] -= 2000;
+        halFireInterrupt(digitalPinToInterrupt(pulseCounters[wheel]));
+      }
+    }
+    if (ticks == 50) largest = halAnalogValue(4);
+    chassis.update();
+    TEST_ASSERT_TRUE(++ticks < 5000);
+  }
+
+  // still ramping after 50 ms, then the final stop is at once
+  TEST_ASSERT_INT_WITHIN(5, 25, largest);
+  TEST_ASSERT_FALSE(chassis.isRamping());
+  for (int wheel = 0; wheel < NUM_WHEELS; wheel++)
+    TEST_ASSERT_EQUAL(0, halAnalogValue(4 + wheel));
+
+  // so does a distance move
+  TEST_ASSERT_TRUE(chassis.moveDistance(200, 300));
+  runFor(chassis, 21);
+  TEST_ASSERT_EQUAL(15, halAnalogValue(4));
+  TEST_ASSERT_TRUE(chassis.isMoving());
+}
+
+void test_chassis_config_cache() {
+  newCard();
+  halEEPROMErase();
+  writeCardFile("CONF.TXT",
+                "LIGHTS = ON;\r\n"
+                "CYCLE = 3;\r\n"
+                "WHEEL_PINS = {{8,22,23}, {9,24,25}, {10,26,27}, {11,28,29}};\r\n"
+                "MOTION_PROFILE = {1, 500, 0};\r\n");
+
+  // the first boot parses the file and stores the result
+  Chassis first;
+  first.setConfigCache(true);
+  TEST_ASSERT_TRUE(first.initialiseFromFile("CONF.TXT"));
+  unsigned long writes = halEEPROMWrites();
+  TEST_ASSERT_TRUE(writes > 0);
+
+  // the next boot takes it from EEPROM, without writing it again
+  Chassis second;
+  second.setConfigCache(true);
+  TEST_ASSERT_TRUE(second.initialiseFromFile("CONF.TXT"));
+  TEST_ASSERT_EQUAL(writes, halEEPROMWrites());
+  TEST_ASSERT_TRUE(second.areLightsEnabled());
+  TEST_ASSERT_EQUAL(3, second.getRunCycles());
+  TEST_ASSERT_EQUAL(PROFILE_TRAPEZOID, second.getMotionProfile());
+  second.setMotionProfile(PROFILE_NONE, 0, 0);
+  second.moveForward(100);
+  TEST_ASSERT_EQUAL(100, halAnalogValue(8));
+
+  // a changed file is parsed again
+  writeCardFile("CONF.TXT", "CYCLE = 5;\r\n");
+  Chassis third;
+  third.setConfigCache(true);
+  TEST_ASSERT_TRUE(third.initialiseFromFile("CONF.TXT"));
+  TEST_ASSERT_EQUAL(5, third.getRunCycles());
+  TEST_ASSERT_FALSE(third.areLightsEnabled());
+
+  // without a card the cached configuration is used
+  halSetSDPresent(false);
+  Chassis fourth;
+  fourth.setConfigCache(true);
+  TEST_ASSERT_TRUE(fourth.initialiseFromFile("CONF.TXT"));
+  TEST_ASSERT_EQUAL(5, fourth.getRunCycles());
+  halSetSDPresent(true);
+
+  // a file with errors fails and leaves the cache alone, even though it is partly applied
+  writeCardFile("CONF.TXT", "CYCLE = 7;\r\nCYCLE = seven;\r\n");
+  writes = halEEPROMWrites();
+  Chassis broken;
+  broken.setConfigCache(true);
+  TEST_ASSERT_FALSE(broken.initialiseFromFile("CONF.TXT"));
+  TEST_ASSERT_EQUAL(7, broken.getRunCycles());
+  TEST_ASSERT_EQUAL(writes, halEEPROMWrites());
+  Chassis cached;
+  TEST_ASSERT_TRUE(cached.initialiseFromCache());
+  TEST_ASSERT_EQUAL(5, cached.getRunCycles());
+
+  // a corrupted record is not used
+  EEPROM.write(CONFIG_CACHE_ADDRESS + 8, EEPROM.read(CONFIG_CACHE_ADDRESS + 8) ^ 0x01);
+  Chassis fifth;
+  TEST_ASSERT_FALSE(fifth.initialiseFromCache());
+}
+
+void test_chassis_execute_commands() {
+  newCard();
+  Chassis chassis;
+  const char line[] = "WHEELS = (120, 120, 120, 120)";
+  int16_t speed = 180;
+
+  // front end commands in manual mode take the same path as the program
+  TEST_ASSERT_TRUE(chassis.executeLine(line, strlen(line)));
+  TEST_ASSERT_EQUAL(120, halAnalogValue(4));
+
+  TEST_ASSERT_TRUE(chassis.execute(CMD_FORWARD, &speed, 1));
+  TEST_ASSERT_EQUAL(180, halAnalogValue(7));
+  TEST_ASSERT_FALSE(chassis.execute(CMD_FORWARD, &speed, 2));
+  TEST_ASSERT_FALSE(chassis.execute(NUM_OF_COMMANDS, &speed, 0));
+  TEST_ASSERT_FALSE(chassis.executeLine("JUMP = 1", 8));
+
+  // operands out of range are refused, whatever the front end
+  int16_t tooFast = 1000;
+  TEST_ASSERT_FALSE(chassis.execute(CMD_FORWARD, &tooFast, 1));
+  TEST_ASSERT_FALSE(chassis.executeLine("DISTANCE = 40000", 16));
+  TEST_ASSERT_EQUAL(180, halAnalogValue(7));
+
+  // a DURATION waits in update() and ends idle, not in a program
+  TEST_ASSERT_TRUE(chassis.executeLine("DURATION = 200", 14));
+  runFor(chassis, 100);
+  TEST_ASSERT_TRUE(chassis.isBusy());
+  TEST_ASSERT_EQUAL(180, halAnalogValue(7));
+
+  runFor(chassis, 150);
+  TEST_ASSERT_FALSE(chassis.isBusy());
+  TEST_ASSERT_EQUAL(0, halAnalogValue(7));
+}
+
+//
+// collects telemetry frames, split on their length byte
+//
+class FrameCapture : public Print {
+public:
+  uint8_t bytes[1024];
+  size_t  length = 0;
+  int     room   = 64;      // free transmit buffer reported
+  size_t  largestWrite = 0;
+
+  size_t write(uint8_t c) {
+    if (length < sizeof(bytes)) bytes[length++] = c;
+    return 1;
+  }
+
+  size_t write(const uint8_t *buffer, size_t size) {
+    if (size > largestWrite) largestWrite = size;
+    for (size_t i = 0; i < size; i++) write(buffer[i]);
+    return size;
+  }
+
+  int availableForWrite() { return room; }
+};
+
+void test_chassis_telemetry_rate() {
+  newCard();
+  Chassis chassis;
+  FrameCapture capture;
+  ChassisTelemetryDecoder decoder;
+  ChassisTelemetry state;
+  int frames = 0;
+
+  chassis.setLights(true);
+  chassis.setTelemetry(capture, 20);
+  chassis.moveForward(200);
+  runFor(chassis, 1000);
+
+  for (size_t pos = 0; pos < capture.length; frames++) {
+    uint8_t length = capture.bytes[pos + 1] + 3;
+
+    TEST_ASSERT_TRUE(decoder.decode(&capture.bytes[pos], length, state));
+    pos += length;
+  }
+
+  TEST_ASSERT_EQUAL(21, frames);     // one at the start, then every 50 ms
+  TEST_ASSERT_EQUAL(0x03 | TELEMETRY_STATUS_MANUAL, state.values[TELEMETRY_STATUS]);   // front lights
+
+  // an output without a transmit buffer gets a byte per update(), the frames still arrive whole
+  capture.length = 0;
+  capture.room = 0;
+  capture.largestWrite = 0;
+  chassis.setTelemetry(capture, 20);
+  runFor(chassis, 500);
+  TEST_ASSERT_EQUAL(1, capture.largestWrite);
+
+  frames = 0;
+  for (size_t pos = 0; pos + 1 < capture.length; frames++) {
+    uint8_t length = capture.bytes[pos + 1] + 3;
+
+    if (pos + length > capture.length) break;     // still being sent
+    TEST_ASSERT_TRUE(decoder.decode(&capture.bytes[pos], length, state));
+    pos += length;
+  }
+  TEST_ASSERT_TRUE(frames >= 9);
+
+  chassis.setTelemetry(capture, 0);
+  capture.length = 0;
+  runFor(chassis, 200);
+  TEST_ASSERT_EQUAL(0, capture.length);
+}
+
+void test_chassis_wire_frames() {
+  newCard();
+  Chassis chassis;
+  chassis.setWire(true);
+
+  chassis.writeToOutput("0123456789012345678901234567890123456789012345678901234567890123456789");
+  TEST_ASSERT_EQUAL(0, Wire.numFrames);       // queued, nothing on the bus yet
+
+  runFor(chassis, 1);
+  TEST_ASSERT_EQUAL(1, Wire.numFrames);       // one frame per update()
+  runFor(chassis, 5);
+
+  TEST_ASSERT_EQUAL(3, Wire.numFrames);
+  TEST_ASSERT_EQUAL(0x08, Wire.frames[0].address);
+  TEST_ASSERT_EQUAL(6, Wire.frames[0].data[0]);   // start frame
+  TEST_ASSERT_EQUAL(7, Wire.frames[0].data[1]);
+  TEST_ASSERT_EQUAL(32, Wire.frames[0].length);
+  TEST_ASSERT_EQUAL(7, Wire.frames[1].data[0]);   // middle frame
+  TEST_ASSERT_EQUAL(7, Wire.frames[1].data[1]);
+  TEST_ASSERT_EQUAL(7, Wire.frames[2].data[0]);   // stop frame
+  TEST_ASSERT_EQUAL(8, Wire.frames[2].data[1]);
+  TEST_ASSERT_EQUAL(12, Wire.frames[2].length);
+  TEST_ASSERT_EQUAL(0, chassis.getWireQueued());
+
+  // an exact multiple of the frame size has no empty trailing frame
+  Wire.clearFrames();
+  chassis.writeToOutput("012345678901234567890123456789012345678901234567890123456789");
+  chassis.flushWire();
+  TEST_ASSERT_EQUAL(2, Wire.numFrames);
+  TEST_ASSERT_EQUAL(8, Wire.frames[1].data[1]);
+  TEST_ASSERT_EQUAL(32, Wire.frames[1].length);
+
+  // a line the queue can never hold arrives as a notice instead
+  char longLine[WIRE_MAX_MESSAGE + 2];
+  unsigned int oversized = chassis.getWireOversized();
+
+  memset(longLine, 'x', sizeof(longLine) - 1);
+  longLine[sizeof(longLine) - 1] = '\0';
+  Wire.clearFrames();
+  chassis.writeToOutput(longLine);
+  chassis.flushWire();
+  TEST_ASSERT_EQUAL(oversized + 1, chassis.getWireOversized());
+  TEST_ASSERT_EQUAL(2, Wire.numFrames);
+  TEST_ASSERT_EQUAL_MEMORY("LOG line longer", Wire.frames[0].data + 2, 15);
+}
+
+void test_chassis_log_output() {
+  newCard();
+  Chassis chassis;
+  chassis.setSerial(true);
+  chassis.setWire(true);
+  Serial.output = "";
+
+  chassis.dumpSettings();
+  TEST_ASSERT_NOT_NULL(strstr(Serial.output.c_str(), "Dumping wheel pin settings \r\n   {4,31,32}\r\n   {5,24,30}\r\n"));
+  TEST_ASSERT_NOT_NULL(strstr(Serial.output.c_str(), "   Lights enabled NO\r\n"));
+  TEST_ASSERT_NOT_NULL(strstr(Serial.output.c_str(), "   Wheel calibration {{21200,20},"));
+
+  // the same lines go out over wire, each line is one message
+  TEST_ASSERT_EQUAL(0, chassis.getWireDropped());
+  TEST_ASSERT_EQUAL(6, Wire.frames[0].data[0]);
+  TEST_ASSERT_EQUAL(7, Wire.frames[0].data[1]);
+  TEST_ASSERT_EQUAL_MEMORY("Dumping current configured set", Wire.frames[0].data + 2, 30);
+  TEST_ASSERT_EQUAL(8, Wire.frames[1].data[1]);
+  TEST_ASSERT_EQUAL_MEMORY("tings", Wire.frames[1].data + 2, 5);
+  TEST_ASSERT_EQUAL(6, Wire.frames[2].data[0]);
+
+  // errors reach the outputs without a String being built
+  Serial.output = "";
+  TEST_ASSERT_FALSE(chassis.setWheelCalibration(7, 100, 20));
+  TEST_ASSERT_EQUAL_STRING("Chassis::setWheelCalibration ERROR invalid calibration for wheel 7\r\n", Serial.output.c_str());
+}
+
+void test_chassis_pulse_distance() {
+  newCard();
+  Chassis chassis;
+
+  TEST_ASSERT_TRUE(initialisePulseCounters());
+
+  for (int pulse = 0; pulse < 25; pulse++)
+    halFireInterrupt(digitalPinToInterrupt(pulseCounters[0]));
+
+  doPulseCalculation();
+  TEST_ASSERT_EQUAL(265, readCumulativeDistance(0));   // 25 pulses of 10.6 mm
+  TEST_ASSERT_EQUAL(0, readCumulativeDistance(1));
+
+  resetCumulativeDistances();
+  TEST_ASSERT_EQUAL(0, readCumulativeDistance(0));
+}
+
+#endif
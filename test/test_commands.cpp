@@ -0,0 +1,91 @@
+#include <unity.h>
+#include <string.h>
+
+#include <ChassisCommands.h>
+
+static ChassisCommandResult parse(const char *line, ChassisParsedCommand &parsed) {
+  ChassisTokenizer tokenizer(line, strlen(line), '\n');
+  ChassisStatement statement;
+
+  TEST_ASSERT_EQUAL(PARSE_OK, tokenizer.next(statement));
+  return chassisParseCommand(statement, parsed);
+}
+
+void test_commands_parse_operands() {
+  ChassisParsedCommand parsed;
+
+  TEST_ASSERT_EQUAL(COMMAND_OK, parse("WHEELS = (100, -100, 255, 0)", parsed));
+  TEST_ASSERT_EQUAL(CMD_WHEELS, parsed.command);
+  TEST_ASSERT_EQUAL(4, parsed.numArgs);
+  TEST_ASSERT_EQUAL(-100, parsed.args[1]);
+  TEST_ASSERT_EQUAL(255, parsed.args[2]);
+
+  TEST_ASSERT_EQUAL(COMMAND_OK, parse("lights = (ON, OFF, OFF, ON)", parsed));
+  TEST_ASSERT_EQUAL(CMD_LIGHTS, parsed.command);
+  TEST_ASSERT_EQUAL(1, parsed.numArgs);
+  TEST_ASSERT_EQUAL(0x09, parsed.args[0]);
+
+  TEST_ASSERT_EQUAL(COMMAND_OK, parse("DURATION = 100000", parsed));
+  TEST_ASSERT_EQUAL(2, parsed.numArgs);
+  TEST_ASSERT_EQUAL(100000L, (uint16_t) parsed.args[0] | ((long) (uint16_t) parsed.args[1] << 16));
+
+  TEST_ASSERT_EQUAL(COMMAND_OK, parse("FORWARD", parsed));
+  TEST_ASSERT_EQUAL(CMD_FORWARD, parsed.command);
+  TEST_ASSERT_EQUAL(1, parsed.numArgs);
+  TEST_ASSERT_EQUAL(0, parsed.args[0]);
+
+  TEST_ASSERT_EQUAL(COMMAND_OK, parse("FULLSTOP", parsed));
+  TEST_ASSERT_EQUAL(0, parsed.numArgs);
+
+  for (uint8_t command = 0; command < NUM_OF_COMMANDS; command++)
+    TEST_ASSERT_TRUE(chassisCommandArgs(command) <= MAX_COMMAND_ARGS);
+}
+
+void test_commands_parse_errors() {
+  ChassisParsedCommand parsed;
+
+  TEST_ASSERT_EQUAL(COMMAND_UNKNOWN, parse("JUMP = 10", parsed));
+  TEST_ASSERT_EQUAL(COMMAND_MISSING_VALUE, parse("WHEELS", parsed));
+  TEST_ASSERT_EQUAL(CMD_WHEELS, parsed.command);
+  TEST_ASSERT_EQUAL(COMMAND_INVALID_VALUE, parse("WHEELS = (1, 2, 3)", parsed));
+  TEST_ASSERT_EQUAL(COMMAND_INVALID_VALUE, parse("LIGHTS = (ON, OFF, DIM, ON)", parsed));
+  TEST_ASSERT_EQUAL(COMMAND_INVALID_VALUE, parse("FORWARD = (1, 2)", parsed));
+  TEST_ASSERT_EQUAL(COMMAND_INVALID_VALUE, parse("DISTANCE = far", parsed));
+}
+
+void test_commands_operand_ranges() {
+  ChassisParsedCommand parsed;
+
+  // values that would wrap in an int16 operand are rejected, the limits are not
+  TEST_ASSERT_EQUAL(COMMAND_INVALID_VALUE, parse("WHEELS = (40000, 100, 100, 100)", parsed));
+  TEST_ASSERT_EQUAL(COMMAND_INVALID_VALUE, parse("WHEELS = (100, 100, 100, -256)", parsed));
+  TEST_ASSERT_EQUAL(COMMAND_OK, parse("WHEELS = (-255, 255, 0, 0)", parsed));
+  TEST_ASSERT_EQUAL(COMMAND_INVALID_VALUE, parse("FORWARD = 256", parsed));
+  TEST_ASSERT_EQUAL(COMMAND_INVALID_VALUE, parse("BACKWARD = 1000", parsed));
+  TEST_ASSERT_EQUAL(COMMAND_INVALID_VALUE, parse("DISTANCE = 40000", parsed));
+  TEST_ASSERT_EQUAL(COMMAND_INVALID_VALUE, parse("DISTANCE = -5", parsed));
+  TEST_ASSERT_EQUAL(COMMAND_OK, parse("DISTANCE = 32767", parsed));
+  TEST_ASSERT_EQUAL(32767, parsed.args[0]);
+  TEST_ASSERT_EQUAL(COMMAND_INVALID_VALUE, parse("DURATION = -5", parsed));
+  TEST_ASSERT_EQUAL(COMMAND_INVALID_VALUE, parse("DURATION = 99999999999999999999", parsed));
+  TEST_ASSERT_EQUAL(COMMAND_INVALID_VALUE, parse("DURATION = 2147483648", parsed));   // fits a 64 bit long
+  TEST_ASSERT_EQUAL(COMMAND_INVALID_VALUE, parse("ROTATE = 361", parsed));
+  TEST_ASSERT_EQUAL(COMMAND_OK, parse("ROTATE = -360", parsed));
+
+  // the same limits for a command that did not come from text
+  TEST_ASSERT_TRUE(chassisCommandInRange(parsed));
+  parsed.command = CMD_FORWARD;
+  parsed.args[0] = 1000;
+  TEST_ASSERT_FALSE(chassisCommandInRange(parsed));
+  parsed.args[0] = -255;
+  TEST_ASSERT_TRUE(chassisCommandInRange(parsed));
+  parsed.numArgs = 2;
+  TEST_ASSERT_FALSE(chassisCommandInRange(parsed));
+
+  TEST_ASSERT_EQUAL(COMMAND_OK, parse("DURATION = 2147483647", parsed));
+  TEST_ASSERT_TRUE(chassisCommandInRange(parsed));
+  parsed.args[1] = -1;
+  TEST_ASSERT_FALSE(chassisCommandInRange(parsed));
+  parsed.command = NUM_OF_COMMANDS;
+  TEST_ASSERT_FALSE(chassisCommandInRange(parsed));
+}
@@ -0,0 +1,47 @@
+#include <unity.h>
+
+#include <ChassisDistance.h>
+
+void test_distance_no_drift() {
+  ChassisPulseConverter millimetres(0, 21200, 20);   // 10.6 mm per pulse
+  ChassisPulseConverter fixedPoint(8, 21100, 20);    // Q24.8, 10.55 mm per pulse
+  uint64_t totalPulses = 0;
+  uint64_t totalMillimetres = 0;
+  uint64_t totalFixedPoint = 0;
+  uint32_t seed = 12345;
+
+  // millions of pulses in batches of random size, as a timer tick would see them
+  while (totalPulses < 5000000) {
+    seed = (seed * 1103515245UL) + 12345UL;
+    uint16_t pulses = (seed >> 16) % 40;
+
+    totalMillimetres += millimetres.convert(pulses);
+    totalFixedPoint  += fixedPoint.convert(pulses);
+    totalPulses      += pulses;
+  }
+
+  // the sum equals the exact distance of all pulses, not a single unit lost
+  TEST_ASSERT_TRUE(totalMillimetres == (totalPulses * 21200) / 2000);
+  TEST_ASSERT_TRUE(totalFixedPoint == ((totalPulses * 21100) << 8) / 2000);
+}
+
+void test_distance_large_batches() {
+  ChassisPulseConverter fixedPoint(8, 65535, 100);
+
+  // pulses * largest circumference in Q8 does not fit 32 bits, batches are split internally
+  TEST_ASSERT_TRUE(fixedPoint.convert(60000) == ((uint64_t) 60000 * 65535 * 256) / 10000);
+}
+
+void test_distance_conversions() {
+  ChassisPulseConverter converter(0, 21200, 20);
+
+  TEST_ASSERT_EQUAL(10, converter.toDistance(1));
+  TEST_ASSERT_EQUAL(1060, converter.toDistance(100));
+  TEST_ASSERT_EQUAL(94, converter.toPulses(1000));    // 999.6 mm
+  TEST_ASSERT_EQUAL(212, converter.toSpeed(20, 1000));
+  TEST_ASSERT_EQUAL(530, converter.toSpeed(2, 40));
+
+  converter.setCalibration(31415, 40);
+  TEST_ASSERT_EQUAL(40, converter.getPulsesPerTurn());
+  TEST_ASSERT_EQUAL(314, converter.toDistance(40));
+}
@@ -0,0 +1,38 @@
+#include <unity.h>
+#include <ChassisKeywords.h>
+
+#include <string.h>
+
+static ChassisText text(const char *value) {
+    ChassisText view = {value, (uint8_t) strlen(value)};
+    return view;
+}
+
+void test_keywords_every_name_found() {
+    for (uint8_t item = 0; item < NUM_CONFIG_ITEMS; item++)
+        TEST_ASSERT_EQUAL(item, chassisFindConfItem(text(chassisConfItemName(item))));
+
+    for (uint8_t command = 0; command < NUM_OF_COMMANDS; command++)
+        TEST_ASSERT_EQUAL(command, chassisFindCommand(text(chassisCommandName(command))));
+
+    for (uint8_t control = 0; control < NUM_OF_CONTROLS; control++)
+        TEST_ASSERT_EQUAL(control, chassisFindControl(text(chassisControlName(control))));
+
+    TEST_ASSERT_EQUAL(CMD_DURATION, chassisFindCommand(text("duration")));
+    TEST_ASSERT_EQUAL(CMD_DISTANCE, chassisFindCommand(text("Distance")));
+    TEST_ASSERT_EQUAL(CONF_TRACK_WIDTH, chassisFindConfItem(text("track_width")));
+}
+
+void test_keywords_unknown() {
+    TEST_ASSERT_EQUAL(-1, chassisFindConfItem(text("")));
+    TEST_ASSERT_EQUAL(-1, chassisFindConfItem(text("LIGHTX")));
+    TEST_ASSERT_EQUAL(-1, chassisFindConfItem(text("WHEELS")));
+    TEST_ASSERT_EQUAL(-1, chassisFindCommand(text("LIGHTS_OVERRIDE")));
+    TEST_ASSERT_EQUAL(-1, chassisFindCommand(text("DISTANCX")));
+    TEST_ASSERT_EQUAL(-1, chassisFindCommand(text("FORWARDS")));
+    TEST_ASSERT_EQUAL(-1, chassisFindControl(text("WHEELS")));
+    TEST_ASSERT_EQUAL(-1, chassisFindControl(text("GOTA")));
+
+    TEST_ASSERT_TRUE(chassisCommandNeedsValue(CMD_WHEELS));
+    TEST_ASSERT_FALSE(chassisCommandNeedsValue(CMD_FULLSTOP));
+}
@@ -0,0 +1,90 @@
+#include <unity.h>
+
+#include <ChassisKinematics.h>
+
+void test_kinematics_drives() {
+  bool lights[4];
+
+  // skid steering: the sides differ by the turn, sideways is ignored
+  TEST_ASSERT_EQUAL(100, SkidDrive::wheelSpeed(0, 150, 80, 50));
+  TEST_ASSERT_EQUAL(200, SkidDrive::wheelSpeed(1, 150, 80, 50));
+  TEST_ASSERT_EQUAL(100, SkidDrive::wheelSpeed(4, 150, 80, 50));
+  TEST_ASSERT_TRUE(SkidDrive::supports(2) && SkidDrive::supports(6));
+  TEST_ASSERT_FALSE(SkidDrive::supports(3));
+
+  // mecanum: to the left the front left and rear right wheels run backward
+  TEST_ASSERT_EQUAL(-100, MecanumDrive::wheelSpeed(0, 0, 100, 0));
+  TEST_ASSERT_EQUAL(100, MecanumDrive::wheelSpeed(1, 0, 100, 0));
+  TEST_ASSERT_EQUAL(100, MecanumDrive::wheelSpeed(2, 0, 100, 0));
+  TEST_ASSERT_EQUAL(-100, MecanumDrive::wheelSpeed(3, 0, 100, 0));
+  TEST_ASSERT_EQUAL(-50, MecanumDrive::wheelSpeed(2, 0, 0, 50));
+  TEST_ASSERT_FALSE(MecanumDrive::supports(6));
+
+  // lights from the sides: forward, back, turning left
+  chassisMovementLights(200, 200, lights);
+  TEST_ASSERT_TRUE(lights[0] && lights[1] && !lights[2] && !lights[3]);
+  chassisMovementLights(-200, -200, lights);
+  TEST_ASSERT_TRUE(!lights[0] && !lights[1] && lights[2] && lights[3]);
+  chassisMovementLights(-200, 200, lights);
+  TEST_ASSERT_TRUE(lights[0] && !lights[1] && !lights[2] && !lights[3]);
+}
+
+//
+// the compile time wired chassis drives the pins of the host HAL
+//
+#ifndef ARDUINO
+
+#include <StaticChassis.h>
+
+struct TwoWheelWiring
+{
+  static constexpr uint8_t wheels[2][NUM_WHEEL_PINS] = {{4, 31, 32}, {5, 24, 30}};
+  static constexpr uint8_t lights[NUM_LIGHT_PINS] = {42, 43, 44, 45};
+  static constexpr uint8_t encoders[2] = {18, 19};
+};
+
+struct MecanumWiring
+{
+  static constexpr uint8_t wheels[4][NUM_WHEEL_PINS] = {{4, 31, 32}, {5, 24, 30}, {6, 38, 39}, {7, 27, 28}};
+  static constexpr uint8_t lights[NUM_LIGHT_PINS] = {42, 43, 44, 45};
+};
+
+void test_static_chassis_drives() {
+  halReset();
+
+  StaticChassis<TwoWheelWiring> twoWheels;
+
+  TEST_ASSERT_EQUAL(2, StaticChassis<TwoWheelWiring>::numWheels);
+  twoWheels.begin();
+  twoWheels.drive(100, 0, 50);
+  TEST_ASSERT_EQUAL(50, halAnalogValue(4));
+  TEST_ASSERT_EQUAL(150, halAnalogValue(5));
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(42));
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(43));
+
+  // beyond full speed the wheels are scaled down together
+  twoWheels.drive(200, 0, 200);
+  TEST_ASSERT_EQUAL(0, twoWheels.getWheelSpeed(0));
+  TEST_ASSERT_EQUAL(255, twoWheels.getWheelSpeed(1));
+  TEST_ASSERT_EQUAL(0, twoWheels.getWheelSpeed(2));
+
+  twoWheels.beginEncoders();
+  uint16_t before = twoWheels.getPulses(1);
+  halFireInterrupt(digitalPinToInterrupt(19));
+  halFireInterrupt(digitalPinToInterrupt(19));
+  TEST_ASSERT_EQUAL(2, (uint16_t) (twoWheels.getPulses(1) - before));
+
+  StaticChassis<MecanumWiring, MecanumDrive> mecanum;
+
+  mecanum.begin();
+  mecanum.moveSideways(120);
+  TEST_ASSERT_EQUAL(120, halAnalogValue(4));
+  TEST_ASSERT_EQUAL(LOW, digitalRead(31));     // front left backward
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(24));    // front right forward
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(38));    // rear left forward
+  TEST_ASSERT_EQUAL(LOW, digitalRead(27));     // rear right backward
+  mecanum.doFullStop();
+  TEST_ASSERT_EQUAL(0, halAnalogValue(7));
+}
+
+#endif
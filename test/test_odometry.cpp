@@ -0,0 +1,66 @@
+#include <unity.h>
+
+#include <ChassisOdometry.h>
+
+#define MM(value) ((int32_t) (value) << ODOMETRY_Q)
+
+void test_odometry_sine_table() {
+  TEST_ASSERT_EQUAL(0, chassisSin(0));
+  TEST_ASSERT_EQUAL(32767, chassisSin(0x4000));
+  TEST_ASSERT_EQUAL(-32767, chassisSin(0xC000));
+  TEST_ASSERT_INT_WITHIN(2, 23170, chassisSin(0x2000));    // 45 degrees
+  TEST_ASSERT_INT_WITHIN(4, 16384, chassisCos(0x2AAB));    // 60 degrees
+  TEST_ASSERT_INT_WITHIN(4, -16384, chassisSin(0xEAAB));   // -30 degrees
+}
+
+void test_odometry_straight_line() {
+  ChassisOdometry odometry;
+
+  for (int step = 0; step < 100; step++)
+    odometry.update(MM(10), MM(10));
+
+  ChassisPose pose = odometry.getPose();
+  TEST_ASSERT_EQUAL(MM(1000), pose.x);
+  TEST_ASSERT_EQUAL(0, pose.y);
+  TEST_ASSERT_EQUAL(0, pose.heading);
+}
+
+void test_odometry_turn_in_place() {
+  ChassisOdometry odometry;
+
+  odometry.setTrackWidth(150);
+
+  // a full turn on the spot: each side runs the circumference of the track circle, 471.2 mm
+  for (int step = 0; step < 471; step++)
+    odometry.update(-MM(1), MM(1));
+
+  ChassisPose pose = odometry.getPose();
+  TEST_ASSERT_INT_WITHIN(150, 0, (int16_t) pose.heading);   // within 1 degree
+  TEST_ASSERT_EQUAL(0, pose.x);
+  TEST_ASSERT_EQUAL(0, pose.y);
+}
+
+void test_odometry_square_returns_home() {
+  ChassisOdometry odometry;
+
+  odometry.setTrackWidth(150);
+
+  for (int side = 0; side < 4; side++) {
+    for (int step = 0; step < 50; step++)
+      odometry.update(MM(10), MM(10));
+
+    // quarter turn left: 117.8 mm per side
+    for (int step = 0; step < 118; step++)
+      odometry.update(-MM(1), MM(1));
+  }
+
+  ChassisPose pose = odometry.getPose();
+  TEST_ASSERT_INT_WITHIN(MM(5), 0, pose.x);
+  TEST_ASSERT_INT_WITHIN(MM(5), 0, pose.y);
+  TEST_ASSERT_INT_WITHIN(200, 0, (int16_t) pose.heading);
+
+  odometry.reset();
+  pose = odometry.getPose();
+  TEST_ASSERT_EQUAL(0, pose.x);
+  TEST_ASSERT_EQUAL(0, pose.heading);
+}
@@ -0,0 +1,34 @@
+#include <unity.h>
+
+//
+// the port sets write the fake port registers of the host HAL
+//
+#ifndef ARDUINO
+
+#include <ChassisPorts.h>
+
+void test_ports_add_pins() {
+  ChassisPortSet pins;
+
+  halReset();
+
+  // pins outside the core's tables are refused before they are looked up
+  TEST_ASSERT_FALSE(pins.addPin(-1));
+  TEST_ASSERT_FALSE(pins.addPin(NUM_DIGITAL_PINS));
+
+  // a light on a PWM pin has its PWM switched off, or the port writes would not show
+  analogWrite(44, 100);
+  TEST_ASSERT_TRUE(pins.addPin(44));
+  TEST_ASSERT_TRUE(pins.addPin(42));
+  TEST_ASSERT_EQUAL(0, halAnalogValue(44));
+  TEST_ASSERT_EQUAL(1, pins.getNumPorts());
+
+  // the refused pins keep their index and are ignored
+  pins.set(0, true);
+  pins.set(2, true);
+  pins.write();
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(44));
+  TEST_ASSERT_EQUAL(LOW, digitalRead(42));
+}
+
+#endif
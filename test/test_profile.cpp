@@ -0,0 +1,81 @@
+#include <unity.h>
+#include <stdlib.h>
+
+#include <ChassisProfile.h>
+
+//
+// ramp to the target and check the limits of every tick, returns the ticks taken
+//
+static int rampTo(ChassisRamp &ramp, const ChassisProfileTable &table, int16_t target,
+                  int maxStep, int maxChange, int previousStep = 0) {
+  int previous = ramp.getValue();
+  int ticks = 0;
+
+  ramp.setTarget(target);
+  while (!ramp.isDone()) {
+    int value = ramp.update(table);
+    int step  = value - previous;
+
+    TEST_ASSERT_TRUE(abs(step) <= maxStep);
+    TEST_ASSERT_TRUE(abs(step - previousStep) <= maxChange);
+    TEST_ASSERT_TRUE((target >= previous) ? (value <= target) : (value >= target));   // no overshoot
+
+    previous = value;
+    previousStep = step;
+    TEST_ASSERT_TRUE(++ticks < 1000);
+  }
+
+  TEST_ASSERT_EQUAL(target, ramp.getValue());
+  return ticks;
+}
+
+void test_profile_trapezoid() {
+  ChassisProfileTable table;
+  ChassisRamp ramp;
+
+  TEST_ASSERT_FALSE(table.setLimits(PROFILE_TRAPEZOID, 0, 0, 10));
+  TEST_ASSERT_FALSE(table.setLimits(PROFILE_S_CURVE, 500, 0, 10));
+
+  // 500 pwm/s at 10 ms ticks is 5 pwm per tick, 0 to 200 in 40 ticks
+  TEST_ASSERT_TRUE(table.setLimits(PROFILE_TRAPEZOID, 500, 0, 10));
+  TEST_ASSERT_EQUAL(1, table.getNumSteps());
+  TEST_ASSERT_EQUAL(5 << PROFILE_Q, table.step(1));
+
+  TEST_ASSERT_EQUAL(40, rampTo(ramp, table, 200, 5, 5));
+  TEST_ASSERT_EQUAL(80, rampTo(ramp, table, -200, 5, 5));
+
+  ramp.reset(0);
+  TEST_ASSERT_TRUE(ramp.isDone());
+  TEST_ASSERT_EQUAL(0, ramp.update(table));
+}
+
+void test_profile_s_curve() {
+  ChassisProfileTable table;
+  ChassisRamp ramp;
+
+  // the acceleration builds up in 500 / (2500 * 0.01) = 20 ticks, limited to the table
+  TEST_ASSERT_TRUE(table.setLimits(PROFILE_S_CURVE, 500, 5000, 10));
+  TEST_ASSERT_EQUAL(10, table.getNumSteps());
+  TEST_ASSERT_TRUE(table.step(1) < table.step(10));
+  TEST_ASSERT_EQUAL(table.step(1) + table.step(2), table.brake(2));
+  TEST_ASSERT_TRUE(table.setLimits(PROFILE_S_CURVE, 500, 2500, 10));
+  TEST_ASSERT_EQUAL(PROFILE_MAX_STEPS, table.getNumSteps());
+
+  // the steps change by at most one pwm per tick, i.e. the jerk of 100 pwm/s^2 per tick
+  TEST_ASSERT_TRUE(table.setLimits(PROFILE_S_CURVE, 500, 5000, 10));
+  int up = rampTo(ramp, table, 255, 5, 2);
+  TEST_ASSERT_TRUE(up > 51);
+
+  // a new target while ramping eases out of the old direction
+  int previous = ramp.getValue();
+  int step = 0;
+
+  ramp.setTarget(0);
+  for (int i = 0; i < 20; i++) {
+    step = ramp.update(table) - previous;
+    previous += step;
+  }
+  TEST_ASSERT_TRUE((step < -4) && (previous > 0));
+  rampTo(ramp, table, 100, 5, 2, step);
+  rampTo(ramp, table, -100, 5, 2);
+}
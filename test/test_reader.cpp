@@ -0,0 +1,77 @@
+#include <unity.h>
+#include <string.h>
+
+#include <ChassisReader.h>
+
+//
+// read only Stream over text in memory
+//
+class TextStream : public Stream {
+public:
+  TextStream(const char *streamText) : text(streamText), position(0) {}
+
+  int available() { return strlen(text + position); }
+  int read()      { return text[position] ? (uint8_t) text[position++] : -1; }
+  int peek()      { return text[position] ? (uint8_t) text[position] : -1; }
+  size_t write(uint8_t) { return 0; }
+
+private:
+  const char *text;
+  size_t      position;
+};
+
+void test_reader_statements_across_blocks() {
+  static char text[4 * READER_BLOCK_SIZE];
+  size_t      length = 0;
+  int         count = 0;
+
+  // statements of a growing length so they end at every position of a block
+  for (int i = 0; length + 20 < sizeof(text); i++)
+    length += sprintf(text + length, " FORWARD = %d\r\n", i * 37);
+
+  TextStream    source(text);
+  ChassisReader reader(source);
+  ChassisText   line;
+  bool          truncated;
+
+  while (reader.next('\n', line, truncated)) {
+    char expected[24];
+
+    TEST_ASSERT_FALSE(truncated);
+    sprintf(expected, " FORWARD = %d\r", count * 37);
+    TEST_ASSERT_EQUAL(strlen(expected), line.length);
+    TEST_ASSERT_EQUAL_MEMORY(expected, line.text, line.length);
+    count++;
+  }
+
+  TEST_ASSERT_TRUE(count > 0);
+  TEST_ASSERT_EQUAL(length, reader.getBytesRead());
+}
+
+void test_reader_truncated_and_last_statement() {
+  static char text[3 * MAX_STATEMENT_LENGTH];
+  ChassisText line;
+  bool        truncated;
+
+  memset(text, 'X', 2 * MAX_STATEMENT_LENGTH);
+  strcpy(text + 2 * MAX_STATEMENT_LENGTH, ";CYCLE = 2;LIGHTS = ON");
+
+  TextStream    source(text);
+  ChassisReader reader(source);
+
+  // a statement too long is cut, the rest of it is skipped
+  TEST_ASSERT_TRUE(reader.next(';', line, truncated));
+  TEST_ASSERT_TRUE(truncated);
+  TEST_ASSERT_EQUAL(MAX_STATEMENT_LENGTH - 1, line.length);
+
+  TEST_ASSERT_TRUE(reader.next(';', line, truncated));
+  TEST_ASSERT_FALSE(truncated);
+  TEST_ASSERT_EQUAL_MEMORY("CYCLE = 2", line.text, line.length);
+
+  // the last statement needs no terminator
+  TEST_ASSERT_TRUE(reader.next(';', line, truncated));
+  TEST_ASSERT_EQUAL_MEMORY("LIGHTS = ON", line.text, line.length);
+  TEST_ASSERT_EQUAL(11, line.length);
+
+  TEST_ASSERT_FALSE(reader.next(';', line, truncated));
+}
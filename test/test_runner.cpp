@@ -4,13 +4,132 @@
 void test_parse_config();
 void test_placeholder();
 void test_clamp();
+void test_tokenizer_config_statements();
+void test_tokenizer_command_lines();
+void test_tokenizer_bracket_errors();
+void test_tokenizer_numbers();
+void test_speed_reaches_target_under_load();
+void test_speed_zero_target_stops();
+void test_speed_output_saturates_without_windup();
+void test_speed_backward_never_drives_forward();
+void test_speed_extreme_values_do_not_wrap();
+void test_odometry_sine_table();
+void test_odometry_straight_line();
+void test_odometry_turn_in_place();
+void test_odometry_square_returns_home();
+void test_distance_no_drift();
+void test_distance_large_batches();
+void test_distance_conversions();
+void test_wire_queue_framing();
+void test_wire_queue_exact_multiple();
+void test_wire_queue_full();
+void test_wire_queue_oversized_and_clear();
+void test_keywords_every_name_found();
+void test_keywords_unknown();
+void test_commands_parse_operands();
+void test_commands_parse_errors();
+void test_commands_operand_ranges();
+void test_telemetry_round_trip();
+void test_telemetry_lost_and_corrupt_frames();
+void test_reader_statements_across_blocks();
+void test_reader_truncated_and_last_statement();
+void test_profile_trapezoid();
+void test_profile_s_curve();
+void test_kinematics_drives();
+#ifndef ARDUINO
+void test_chassis_move_wheels();
+void test_chassis_config_from_file();
+void test_chassis_config_from_stream();
+void test_chassis_program_runs();
+void test_chassis_block_index();
+void test_chassis_control_flow();
+void test_chassis_damaged_program_cache();
+void test_chassis_motion_profile();
+void test_chassis_rotate_by_angle();
+void test_chassis_ramped_moves();
+void test_chassis_config_cache();
+void test_static_chassis_drives();
+void test_scheduler_rates();
+void test_scheduler_ticks();
+void test_ports_add_pins();
+void test_chassis_execute_commands();
+void test_chassis_telemetry_rate();
+void test_chassis_wire_frames();
+void test_chassis_log_output();
+void test_chassis_pulse_distance();
+#endif
 
-extern "C" void setup() {
+static int runTests() {
   UNITY_BEGIN();
   RUN_TEST(test_parse_config);
   RUN_TEST(test_placeholder);
   RUN_TEST(test_clamp);
-  UNITY_END();
+  RUN_TEST(test_tokenizer_config_statements);
+  RUN_TEST(test_tokenizer_command_lines);
+  RUN_TEST(test_tokenizer_bracket_errors);
+  RUN_TEST(test_tokenizer_numbers);
+  RUN_TEST(test_speed_reaches_target_under_load);
+  RUN_TEST(test_speed_zero_target_stops);
+  RUN_TEST(test_speed_output_saturates_without_windup);
+  RUN_TEST(test_speed_backward_never_drives_forward);
+  RUN_TEST(test_speed_extreme_values_do_not_wrap);
+  RUN_TEST(test_odometry_sine_table);
+  RUN_TEST(test_odometry_straight_line);
+  RUN_TEST(test_odometry_turn_in_place);
+  RUN_TEST(test_odometry_square_returns_home);
+  RUN_TEST(test_distance_no_drift);
+  RUN_TEST(test_distance_large_batches);
+  RUN_TEST(test_distance_conversions);
+  RUN_TEST(test_wire_queue_framing);
+  RUN_TEST(test_wire_queue_exact_multiple);
+  RUN_TEST(test_wire_queue_full);
+  RUN_TEST(test_wire_queue_oversized_and_clear);
+  RUN_TEST(test_keywords_every_name_found);
+  RUN_TEST(test_keywords_unknown);
+  RUN_TEST(test_commands_parse_operands);
+  RUN_TEST(test_commands_parse_errors);
+  RUN_TEST(test_commands_operand_ranges);
+  RUN_TEST(test_telemetry_round_trip);
+  RUN_TEST(test_telemetry_lost_and_corrupt_frames);
+  RUN_TEST(test_reader_statements_across_blocks);
+  RUN_TEST(test_reader_truncated_and_last_statement);
+  RUN_TEST(test_profile_trapezoid);
+  RUN_TEST(test_profile_s_curve);
+  RUN_TEST(test_kinematics_drives);
+#ifndef ARDUINO
+  RUN_TEST(test_chassis_move_wheels);
+  RUN_TEST(test_chassis_config_from_file);
+  RUN_TEST(test_chassis_config_from_stream);
+  RUN_TEST(test_chassis_program_runs);
+  RUN_TEST(test_chassis_block_index);
+  RUN_TEST(test_chassis_control_flow);
+  RUN_TEST(test_chassis_damaged_program_cache);
+  RUN_TEST(test_chassis_motion_profile);
+  RUN_TEST(test_chassis_rotate_by_angle);
+  RUN_TEST(test_chassis_ramped_moves);
+  RUN_TEST(test_chassis_config_cache);
+  RUN_TEST(test_static_chassis_drives);
+  RUN_TEST(test_scheduler_rates);
+  RUN_TEST(test_scheduler_ticks);
+  RUN_TEST(test_ports_add_pins);
+  RUN_TEST(test_chassis_execute_commands);
+  RUN_TEST(test_chassis_telemetry_rate);
+  RUN_TEST(test_chassis_wire_frames);
+  RUN_TEST(test_chassis_log_output);
+  RUN_TEST(test_chassis_pulse_distance);
+#endif
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+extern "C" void setup() {
+  runTests();
 }
 
 extern "C" void loop() {}
+#else
+// native build on the host HAL
+int main() {
+  return runTests();
+}
+#endif
@@ -0,0 +1,97 @@
+#include <unity.h>
+
+//
+// the scheduler takes its ticks from the simulated clock of the host HAL
+//
+#ifndef ARDUINO
+
+#include <ChassisScheduler.h>
+#include <Arduino.h>
+
+static unsigned long taskTime;
+
+static void countTask(void *context) {
+  (*(int *) context)++;
+  halAdvanceMicros(taskTime);
+}
+
+static void runFor(ChassisScheduler &scheduler, unsigned long ms) {
+  for (unsigned long i = 0; i < ms; i++) {
+    halAdvanceMicros(1000 - taskTime);
+    scheduler.run();
+  }
+}
+
+void test_scheduler_rates() {
+  ChassisScheduler scheduler;
+  int control = 0, telemetry = 0, background = 0;
+
+  halReset();
+  taskTime = 0;
+
+  int8_t controlTask    = scheduler.addTask(countTask, &control, 10, 500);
+  int8_t telemetryTask  = scheduler.addTask(countTask, &telemetry, 100);
+  int8_t backgroundTask = scheduler.addTask(countTask, &background, 0);
+
+  TEST_ASSERT_EQUAL(0, controlTask);
+  TEST_ASSERT_EQUAL(2, backgroundTask);
+
+  // the periodic tasks start on the first pass, the background only runs when they are not due
+  scheduler.run();
+  runFor(scheduler, 999);
+  TEST_ASSERT_EQUAL(100, control);
+  TEST_ASSERT_EQUAL(10, telemetry);
+  TEST_ASSERT_EQUAL(900, background);
+  TEST_ASSERT_EQUAL(0, scheduler.getOverruns(controlTask));
+  TEST_ASSERT_EQUAL(0, scheduler.getMissed(telemetryTask));
+
+  // a slow control task counts its overruns
+  taskTime = 700;
+  runFor(scheduler, 100);
+  TEST_ASSERT_EQUAL(10, scheduler.getOverruns(controlTask));
+  TEST_ASSERT_EQUAL(700, scheduler.getLongest(controlTask));
+  TEST_ASSERT_EQUAL(0, scheduler.getOverruns(telemetryTask));   // no budget
+
+  // a late run calls a task once and counts the periods it missed
+  taskTime = 0;
+  scheduler.resetStatistics();
+  halAdvanceMicros(35000);
+  scheduler.run();
+  TEST_ASSERT_EQUAL(1, scheduler.getRuns(controlTask));
+  TEST_ASSERT_EQUAL(3, scheduler.getMissed(controlTask));
+  runFor(scheduler, 10);
+  TEST_ASSERT_EQUAL(2, scheduler.getRuns(controlTask));   // back at its rate, no catching up
+
+  TEST_ASSERT_EQUAL(0, scheduler.getRuns(-1));
+  TEST_ASSERT_EQUAL(0, scheduler.getRuns(SCHEDULER_MAX_TASKS));
+}
+
+void test_scheduler_ticks() {
+  ChassisScheduler scheduler;
+  int control = 0;
+
+  halReset();
+  taskTime = 0;
+
+  for (int i = 0; i < SCHEDULER_MAX_TASKS; i++)
+    TEST_ASSERT_TRUE(scheduler.addTask(countTask, &control, 1000) >= 0);
+  TEST_ASSERT_EQUAL(-1, scheduler.addTask(countTask, &control, 10));
+
+  // once ticks come in the clock no longer counts, only the ticks do
+  ChassisScheduler ticked;
+  int8_t task = ticked.addTask(countTask, &control, 10);
+
+  control = 0;
+  ticked.run();
+  TEST_ASSERT_EQUAL(1, control);
+  for (int i = 0; i < 9; i++) ticked.tick();
+  halAdvanceMicros(50000);
+  ticked.run();
+  TEST_ASSERT_EQUAL(1, control);
+  ticked.tick();
+  ticked.run();
+  TEST_ASSERT_EQUAL(2, control);
+  TEST_ASSERT_EQUAL(0, ticked.getMissed(task));
+}
+
+#endif
@@ -0,0 +1,88 @@
+#include <unity.h>
+
+#include <ChassisSpeed.h>
+
+//
+// crude wheel model: speed follows pwm with a first order lag, a load takes off a fixed amount
+//
+static int16_t plantStep(int16_t speed, int16_t pwm, int16_t mmPerPwm10, int16_t load) {
+  int32_t steady = ((int32_t) pwm * mmPerPwm10) / 10 - load;
+  if ((pwm > 0) && (steady < 0)) steady = 0;
+  return speed + (steady - speed) / 4;
+}
+
+void test_speed_reaches_target_under_load() {
+  ChassisSpeedController light, heavy;
+  int16_t lightSpeed = 0, heavySpeed = 0;
+
+  light.setGains(64, 8, 0, 96);
+  heavy.setGains(64, 8, 0, 96);
+  light.setTarget(300);
+  heavy.setTarget(300);
+
+  for (int step = 0; step < 200; step++) {
+    lightSpeed = plantStep(lightSpeed, light.update(lightSpeed), 27, 0);
+    heavySpeed = plantStep(heavySpeed, heavy.update(heavySpeed), 27, 120);
+  }
+
+  // both wheels end up at the same speed despite the different load
+  TEST_ASSERT_INT_WITHIN(10, 300, lightSpeed);
+  TEST_ASSERT_INT_WITHIN(10, 300, heavySpeed);
+}
+
+void test_speed_zero_target_stops() {
+  ChassisSpeedController controller;
+
+  controller.setGains(64, 8, 0, 96);
+  controller.setTarget(200);
+  for (int step = 0; step < 20; step++) controller.update(0);
+
+  controller.setTarget(0);
+  TEST_ASSERT_EQUAL(0, controller.update(150));
+  TEST_ASSERT_EQUAL(0, controller.update(0));
+}
+
+void test_speed_output_saturates_without_windup() {
+  ChassisSpeedController controller;
+
+  controller.setGains(64, 8, 0, 96);
+  controller.setTarget(2000);   // far beyond what the wheel can do
+
+  for (int step = 0; step < 100; step++)
+    TEST_ASSERT_EQUAL(SPEED_PWM_LIMIT, controller.update(500));
+
+  // once the target is reachable the output drops straight away, no integral to unwind
+  controller.setTarget(300);
+  TEST_ASSERT_TRUE(controller.update(500) < SPEED_PWM_LIMIT);
+}
+
+void test_speed_backward_never_drives_forward() {
+  ChassisSpeedController controller;
+
+  controller.setGains(64, 8, 0, 96);
+  controller.setTarget(-200);
+
+  TEST_ASSERT_TRUE(controller.update(0) < 0);
+  TEST_ASSERT_EQUAL(0, controller.update(-900));   // far too fast backward: coast, do not reverse
+}
+
+void test_speed_extreme_values_do_not_wrap() {
+  ChassisSpeedController controller;
+
+  // 32767 - -32768 does not fit an int16, the error must not wrap to -1
+  controller.setGains(64, 0, 0, 0);
+  controller.setTarget(32767);
+  TEST_ASSERT_EQUAL(SPEED_PWM_LIMIT, controller.update(-32768));
+
+  controller.reset();
+  controller.setTarget(-32768);
+  TEST_ASSERT_EQUAL(-SPEED_PWM_LIMIT, controller.update(32767));
+
+  // the largest gains with the error swinging end to end stay in range too
+  controller.reset();
+  controller.setGains(32767, 0, 32767, 32767);
+  controller.setTarget(32767);
+  TEST_ASSERT_EQUAL(SPEED_PWM_LIMIT, controller.update(-32768));
+  controller.setTarget(-32768);
+  TEST_ASSERT_EQUAL(-SPEED_PWM_LIMIT, controller.update(32767));
+}
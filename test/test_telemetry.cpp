@@ -0,0 +1,68 @@
+#include <unity.h>
+#include <string.h>
+
+#include <ChassisTelemetry.h>
+
+static void driving(ChassisTelemetry &state, int32_t step) {
+  for (uint8_t wheel = 0; wheel < 4; wheel++) {
+    state.values[TELEMETRY_PULSES + wheel] = (uint16_t) (65530 + step * 3);   // wraps halfway
+    state.values[TELEMETRY_SPEEDS + wheel] = 400;
+  }
+  state.values[TELEMETRY_DISTANCE] = step * 32;
+  state.values[TELEMETRY_STATUS] = 0x03;
+}
+
+void test_telemetry_round_trip() {
+  ChassisTelemetryEncoder encoder;
+  ChassisTelemetryDecoder decoder;
+  ChassisTelemetry sent, received;
+  uint8_t frame[TELEMETRY_MAX_FRAME];
+
+  for (int32_t step = 0; step < 2 * TELEMETRY_KEY_INTERVAL; step++) {
+    driving(sent, step);
+
+    uint8_t length = encoder.encode(sent, frame);
+
+    TEST_ASSERT_EQUAL_HEX8(TELEMETRY_SYNC, frame[0]);
+    if ((step % TELEMETRY_KEY_INTERVAL) != 0)
+      TEST_ASSERT_TRUE(length <= 10);          // driving straight, 5 fields of one byte
+
+    TEST_ASSERT_TRUE(decoder.decode(frame, length, received));
+    TEST_ASSERT_EQUAL_MEMORY(sent.values, received.values, sizeof(sent.values));
+  }
+
+  // standing still costs the header, an empty mask and the CRC
+  TEST_ASSERT_TRUE(encoder.encode(sent, frame) > 10);     // key frame
+  TEST_ASSERT_EQUAL(5, encoder.encode(sent, frame));
+  TEST_ASSERT_EQUAL(0xF4, chassisCrc8((const uint8_t *) "123456789", 9));   // CRC-8 check value
+}
+
+void test_telemetry_lost_and_corrupt_frames() {
+  ChassisTelemetryEncoder encoder;
+  ChassisTelemetryDecoder decoder;
+  ChassisTelemetry sent, received;
+  uint8_t frame[TELEMETRY_MAX_FRAME];
+  uint8_t length;
+
+  driving(sent, 0);
+  length = encoder.encode(sent, frame);
+  TEST_ASSERT_TRUE(decoder.decode(frame, length, received));
+
+  // a flipped bit fails the CRC
+  driving(sent, 1);
+  length = encoder.encode(sent, frame);
+  frame[4] ^= 0x10;
+  TEST_ASSERT_FALSE(decoder.decode(frame, length, received));
+
+  // the frame was lost for the receiver, deltas are ignored up to the next key frame
+  for (int32_t step = 2; step < TELEMETRY_KEY_INTERVAL; step++) {
+    driving(sent, step);
+    length = encoder.encode(sent, frame);
+    TEST_ASSERT_FALSE(decoder.decode(frame, length, received));
+  }
+
+  driving(sent, TELEMETRY_KEY_INTERVAL);
+  length = encoder.encode(sent, frame);
+  TEST_ASSERT_TRUE(decoder.decode(frame, length, received));
+  TEST_ASSERT_EQUAL_MEMORY(sent.values, received.values, sizeof(sent.values));
+}
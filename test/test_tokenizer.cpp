@@ -0,0 +1,118 @@
+#include <unity.h>
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+#include <avr/pgmspace.h>
+
+#include <ChassisTokenizer.h>
+
+static const char confText[] =
+  "LIGHTS = OFF;\r\n"
+  "LIGHT_PINS = {42, 43, 44, 45};\r\n"
+  "WHEEL_PINS = {{4,31,32}, {5,24,30}, {6,38,39}, {7,27,28}};\r\n"
+  "MOVEMENTS = commands/GUIDE.TXT;\r\n";
+
+void test_tokenizer_config_statements() {
+  ChassisTokenizer tokenizer(confText, strlen(confText), ';');
+  ChassisStatement statement;
+  long value = 0;
+
+  TEST_ASSERT_EQUAL(PARSE_OK, tokenizer.next(statement));
+  TEST_ASSERT_TRUE(chassisTextEquals(statement.key, "LIGHTS"));
+  TEST_ASSERT_EQUAL(VALUE_SCALAR, statement.valueType);
+  TEST_ASSERT_TRUE(chassisTextEquals(statement.items[0], "off"));
+
+  TEST_ASSERT_EQUAL(PARSE_OK, tokenizer.next(statement));
+  TEST_ASSERT_EQUAL(VALUE_ARRAY, statement.valueType);
+  TEST_ASSERT_EQUAL(4, statement.numItems);
+  TEST_ASSERT_TRUE(chassisTextToInt(statement.items[3], value));
+  TEST_ASSERT_EQUAL(45, value);
+
+  TEST_ASSERT_EQUAL(PARSE_OK, tokenizer.next(statement));
+  TEST_ASSERT_EQUAL(12, statement.numItems);
+  TEST_ASSERT_EQUAL(4, statement.numGroups);
+  TEST_ASSERT_TRUE(chassisTextToInt(statement.items[5], value));
+  TEST_ASSERT_EQUAL(30, value);
+  TEST_ASSERT_EQUAL(3, statement.line);
+
+  TEST_ASSERT_EQUAL(PARSE_OK, tokenizer.next(statement));
+  TEST_ASSERT_TRUE(chassisTextEquals(statement.items[0], "commands/GUIDE.TXT"));
+
+  TEST_ASSERT_EQUAL(PARSE_END, tokenizer.next(statement));
+}
+
+void test_tokenizer_command_lines() {
+  const char text[] = "<MOVEMENT>\n LIGHTS = (OFF, ON, ON, OFF)\n FULLSTOP\n DURATION  = -2000\n";
+  ChassisTokenizer tokenizer(text, strlen(text), '\n');
+  ChassisStatement statement;
+  bool setting = false;
+  long value = 0;
+
+  TEST_ASSERT_EQUAL(PARSE_OK, tokenizer.next(statement));
+  TEST_ASSERT_TRUE(chassisTextEquals(statement.key, "<MOVEMENT>"));
+  TEST_ASSERT_EQUAL(VALUE_NONE, statement.valueType);
+
+  TEST_ASSERT_EQUAL(PARSE_OK, tokenizer.next(statement));
+  TEST_ASSERT_EQUAL(VALUE_TUPLE, statement.valueType);
+  TEST_ASSERT_EQUAL(4, statement.numItems);
+  TEST_ASSERT_TRUE(chassisTextToSwitch(statement.items[1], setting));
+  TEST_ASSERT_TRUE(setting);
+
+  TEST_ASSERT_EQUAL(PARSE_OK, tokenizer.next(statement));
+  TEST_ASSERT_TRUE(chassisTextEquals(statement.key, "FULLSTOP"));
+
+  TEST_ASSERT_EQUAL(PARSE_OK, tokenizer.next(statement));
+  TEST_ASSERT_TRUE(chassisTextToInt(statement.items[0], value));
+  TEST_ASSERT_EQUAL(-2000, value);
+  TEST_ASSERT_EQUAL(4, statement.line);
+}
+
+void test_tokenizer_bracket_errors() {
+  const char text[] = "A = {1, 2;B = (1, 2};C = {1, 2) ;D = {1,,2};E = 1 2;F = {3};";
+  ChassisTokenizer tokenizer(text, strlen(text), ';');
+  ChassisStatement statement;
+
+  TEST_ASSERT_EQUAL(PARSE_ERROR, tokenizer.next(statement));   // missing closing bracket
+  TEST_ASSERT_EQUAL(0, strcmp_P("missing closing bracket", tokenizer.getError()));   // kept in flash
+  TEST_ASSERT_EQUAL(PARSE_ERROR, tokenizer.next(statement));   // tuple closed as array
+  TEST_ASSERT_EQUAL(PARSE_ERROR, tokenizer.next(statement));   // array closed as tuple
+  TEST_ASSERT_EQUAL(PARSE_ERROR, tokenizer.next(statement));   // empty item
+  TEST_ASSERT_EQUAL(PARSE_ERROR, tokenizer.next(statement));   // trailing text
+
+  // errors never swallow the next statement
+  TEST_ASSERT_EQUAL(PARSE_OK, tokenizer.next(statement));
+  TEST_ASSERT_TRUE(chassisTextEquals(statement.key, "F"));
+}
+
+void test_tokenizer_numbers() {
+  ChassisText number = {"-255", 4};
+  ChassisText word   = {"12a", 3};
+  ChassisText sign   = {"-", 1};
+  long value = 0;
+
+  TEST_ASSERT_TRUE(chassisTextToInt(number, value));
+  TEST_ASSERT_EQUAL(-255, value);
+  TEST_ASSERT_FALSE(chassisTextToInt(word, value));
+  TEST_ASSERT_FALSE(chassisTextToInt(sign, value));
+
+  // the limits of a long still fit, one more does not
+  char text[24];
+  ChassisText limit = {text, 0};
+
+  limit.length = snprintf(text, sizeof(text), "%ld", LONG_MAX);
+  TEST_ASSERT_TRUE(chassisTextToInt(limit, value));
+  TEST_ASSERT_TRUE(value == LONG_MAX);
+  text[limit.length - 1]++;
+  TEST_ASSERT_FALSE(chassisTextToInt(limit, value));
+
+  limit.length = snprintf(text, sizeof(text), "%ld", LONG_MIN);
+  TEST_ASSERT_TRUE(chassisTextToInt(limit, value));
+  TEST_ASSERT_TRUE(value == LONG_MIN);
+  text[limit.length - 1]++;
+  TEST_ASSERT_FALSE(chassisTextToInt(limit, value));
+
+  ChassisText huge = {"99999999999999999999", 20};
+  TEST_ASSERT_FALSE(chassisTextToInt(huge, value));
+}
+
+// setup()/loop() moved to test_runner.cpp
@@ -0,0 +1,114 @@
+#include <unity.h>
+#include <ChassisWireQueue.h>
+
+#include <string.h>
+
+void test_wire_queue_framing() {
+    ChassisWireQueue queue;
+    uint8_t frame[WIRE_FRAME_SIZE];
+
+    TEST_ASSERT_EQUAL(0, queue.peekFrame(frame));
+
+    TEST_ASSERT_TRUE(queue.push("hello", 5));
+    TEST_ASSERT_TRUE(queue.push("", 0));
+
+    TEST_ASSERT_EQUAL(7, queue.peekFrame(frame));   // single frame
+    TEST_ASSERT_EQUAL(WIRE_FRAME_START, frame[0]);
+    TEST_ASSERT_EQUAL(WIRE_FRAME_STOP, frame[1]);
+    TEST_ASSERT_EQUAL_MEMORY("hello", frame + 2, 5);
+    queue.popFrame();
+
+    TEST_ASSERT_EQUAL(2, queue.peekFrame(frame));   // an empty message still marks its start and stop
+    TEST_ASSERT_EQUAL(WIRE_FRAME_START, frame[0]);
+    TEST_ASSERT_EQUAL(WIRE_FRAME_STOP, frame[1]);
+    queue.popFrame();
+
+    TEST_ASSERT_TRUE(queue.isEmpty());
+}
+
+void test_wire_queue_exact_multiple() {
+    ChassisWireQueue queue;
+    uint8_t frame[WIRE_FRAME_SIZE];
+    char text[91];
+
+    for (int i = 0; i < 90; i++) text[i] = 'a' + (i % 26);
+
+    TEST_ASSERT_TRUE(queue.push(text, 90));
+
+    const uint8_t headers[3][2] = {{6, 7}, {7, 7}, {7, 8}};
+    for (int i = 0; i < 3; i++)
+    {
+        TEST_ASSERT_EQUAL(WIRE_FRAME_SIZE, queue.peekFrame(frame));
+        TEST_ASSERT_EQUAL(headers[i][0], frame[0]);
+        TEST_ASSERT_EQUAL(headers[i][1], frame[1]);
+        TEST_ASSERT_EQUAL_MEMORY(text + i * WIRE_FRAME_DATA, frame + 2, WIRE_FRAME_DATA);
+        queue.popFrame();
+    }
+
+    TEST_ASSERT_TRUE(queue.isEmpty());     // no empty fourth frame
+}
+
+void test_wire_queue_full() {
+    ChassisWireQueue queue;
+    uint8_t frame[WIRE_FRAME_SIZE];
+    char text[WIRE_QUEUE_SIZE];
+
+    memset(text, 'x', sizeof(text));
+
+    TEST_ASSERT_FALSE(queue.push(text, WIRE_QUEUE_SIZE - 1));   // never fits with its length
+    TEST_ASSERT_TRUE(queue.push(text, 100));
+    TEST_ASSERT_FALSE(queue.push(text, 100));
+    TEST_ASSERT_EQUAL(2, queue.getDropped());
+    TEST_ASSERT_EQUAL(102, queue.getQueued());
+
+    // the ring wraps, messages come out whole and in order
+    for (int round = 0; round < 20; round++)
+    {
+        text[0] = 'A' + round;
+        TEST_ASSERT_TRUE(queue.push(text, 50));
+
+        queue.peekFrame(frame);
+        while (frame[1] != WIRE_FRAME_STOP)
+        {
+            queue.popFrame();
+            queue.peekFrame(frame);
+        }
+        queue.popFrame();
+
+        TEST_ASSERT_EQUAL(WIRE_FRAME_START, queue.peekFrame(frame) ? frame[0] : 0);
+        TEST_ASSERT_EQUAL('A' + round, frame[2]);
+    }
+
+    TEST_ASSERT_EQUAL(2, queue.getDropped());
+}
+
+void test_wire_queue_oversized_and_clear() {
+    ChassisWireQueue queue;
+    uint8_t frame[WIRE_FRAME_SIZE];
+    char text[WIRE_QUEUE_SIZE + 10];
+
+    memset(text, 'x', sizeof(text));
+
+    // the longest message fits an empty queue, one more never does
+    TEST_ASSERT_TRUE(queue.push(text, WIRE_MAX_MESSAGE));
+    queue.clear();
+    TEST_ASSERT_FALSE(queue.push(text, WIRE_MAX_MESSAGE + 1));
+    TEST_ASSERT_EQUAL(1, queue.getOversized());
+
+    // a busy queue drops without calling it oversized
+    TEST_ASSERT_TRUE(queue.push(text, 100));
+    TEST_ASSERT_FALSE(queue.push(text, 100));
+    TEST_ASSERT_EQUAL(2, queue.getDropped());
+    TEST_ASSERT_EQUAL(1, queue.getOversized());
+
+    // clear() also drops the message being written and the counters
+    queue.beginMessage();
+    queue.append('a');
+    queue.clear();
+    queue.append('b');
+    TEST_ASSERT_EQUAL(0, queue.getDropped());
+    TEST_ASSERT_TRUE(queue.push("hi", 2));
+    TEST_ASSERT_EQUAL(4, queue.peekFrame(frame));
+    TEST_ASSERT_EQUAL_MEMORY("hi", frame + 2, 2);
+    TEST_ASSERT_EQUAL(4, queue.getQueued());
+}